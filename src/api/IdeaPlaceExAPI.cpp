@@ -8,15 +8,31 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include "main/IdeaPlaceEx.h"
+#include "main/IdeaPlaceExBatch.h"
 
 namespace py = pybind11;
 void initIdeaPlaceExAPI(py::module &m)
 {
     py::class_<PROJECT_NAMESPACE::IdeaPlaceEx>(m , "IdeaPlaceEx")
         .def(py::init<>())
-        .def("solve", &PROJECT_NAMESPACE::IdeaPlaceEx::solve, "Solve the problem")
+        .def("solve", &PROJECT_NAMESPACE::IdeaPlaceEx::solve, "Solve the problem. The global placement stops early to fit in a positive time budget",
+                py::arg("gridSize") = -1, py::arg("timeBudgetMs") = 0)
+        .def("solveIncremental", &PROJECT_NAMESPACE::IdeaPlaceEx::solveIncremental, "Re-place after small edits, starting from the current placement. With fixUnchanged, the other cells keep their locations through the global placement and the legalization, up to the final grid alignment",
+                py::arg("changedCells"), py::arg("fixUnchanged") = true, py::arg("gridSize") = -1)
+        .def("solveFromCheckpoint", &PROJECT_NAMESPACE::IdeaPlaceEx::solveFromCheckpoint, "Solve with the global placement resumed from a checkpoint",
+                py::arg("filename"), py::arg("gridSize") = -1)
         .def("alignToGrid", &PROJECT_NAMESPACE::IdeaPlaceEx::alignToGrid, "Align the placement to grid")
         .def("numThreads", &PROJECT_NAMESPACE::IdeaPlaceEx::setNumThreads, "Set number of threads")
+        .def("nlpExecutor", &PROJECT_NAMESPACE::IdeaPlaceEx::setNlpExecutor, "Set how the global placement operators are run in parallel. 0: one parallel region per operator family, 1: one persistent parallel region")
+        .def("nlpOptimizer", &PROJECT_NAMESPACE::IdeaPlaceEx::setNlpOptimizer, "Set the optimization kernel of the global placement. 0: adam, 1: adam with Barzilai-Borwein warm-up, 2: nesterov with Armijo backtracking")
+        .def("nlpPrecision", &PROJECT_NAMESPACE::IdeaPlaceEx::setNlpPrecision, "Set the numerical precision of the global placement with the adam kernel. 0: double, 1: mixed, the operators in float and the rest in double, 2: float, experimental")
+        .def("numMultiStarts", &PROJECT_NAMESPACE::IdeaPlaceEx::setNumMultiStarts, "Set the number of global placement runs started concurrently with different seeds. The best legal result is kept")
+        .def("initSeed", &PROJECT_NAMESPACE::IdeaPlaceEx::setInitSeed, "Set the seed of the random initial placement")
+        .def("multilevel", &PROJECT_NAMESPACE::IdeaPlaceEx::setUseMultilevel, "Set whether to run the global placement on a hierarchy of clustered netlists")
+        .def("checkpoint", &PROJECT_NAMESPACE::IdeaPlaceEx::setCheckpoint, "Set the file and the number of outer iterations between the checkpoints of the global placement. Empty file to disable",
+                py::arg("filename"), py::arg("interval") = 10)
+        .def("trace", &PROJECT_NAMESPACE::IdeaPlaceEx::setTrace, "Record the convergence of the global placement into a file. CSV if it ends with .csv, binary otherwise. Empty file to disable",
+                py::arg("filename"), py::arg("capacity") = 1 << 15)
         .def("readTechSimpleFile", &PROJECT_NAMESPACE::IdeaPlaceEx::readTechSimpleFile, "Internal usage: Read in the techsimple file")
         .def("readPinFile", &PROJECT_NAMESPACE::IdeaPlaceEx::readPinFile, "Internal usage: Read in the .pin file")
         .def("readConnectionFile", &PROJECT_NAMESPACE::IdeaPlaceEx::readConnectionFile, "Internal usage: Read in the .connection file")
@@ -49,6 +65,7 @@ void initIdeaPlaceExAPI(py::module &m)
         .def("closeVirtualPinAssignment", &PROJECT_NAMESPACE::IdeaPlaceEx::closeVirtualPinAssignment, "Close the virtual pin assignment functionality")
         .def("setIoPinBoundaryExtension", &PROJECT_NAMESPACE::IdeaPlaceEx::setIoPinBoundaryExtension, "Set the extension of io pin locations to the boundary of cell placements")
         .def("setIoPinInterval", &PROJECT_NAMESPACE::IdeaPlaceEx::setIoPinInterval, "Set the minimum interval of io pins")
+        .def("setIoPinMoveThreshold", &PROJECT_NAMESPACE::IdeaPlaceEx::setIoPinMoveThreshold, "Set how far the cells need to move for the io pins to be reassigned in global placement")
         .def("markIoNet", &PROJECT_NAMESPACE::IdeaPlaceEx::markAsIoNet, "Mark a net as IO net")
         .def("revokeIoNet", &PROJECT_NAMESPACE::IdeaPlaceEx::revokeIoNet, "Revoke IO net flag on a net")
         .def("markAsVddNet", &PROJECT_NAMESPACE::IdeaPlaceEx::markAsVddNet, "Mark a net as VDD")
@@ -65,6 +82,9 @@ void initIdeaPlaceExAPI(py::module &m)
         .def("isIoPinVertical", &PROJECT_NAMESPACE::IdeaPlaceEx::isIopinVertical, "true if io pins are on top or bottom")
         .def("xCellLoc", &PROJECT_NAMESPACE::IdeaPlaceEx::xCellLoc, "Get x coordinate of a cell location")
         .def("yCellLoc", &PROJECT_NAMESPACE::IdeaPlaceEx::yCellLoc, "Get y coordinate of a cell location")
+        .def("profileGlobalPlacement", &PROJECT_NAMESPACE::IdeaPlaceEx::profileGlobalPlacement, "Get the counters of each operator family in the global placement of the last solve of this placer. The times are in ns and summed over the threads")
+        .def("profileInnerIterations", &PROJECT_NAMESPACE::IdeaPlaceEx::profileInnerIterations, "Get the number of gradient evaluations in each outer iteration of the global placement of the last solve")
+        .def("dumpProfile", &PROJECT_NAMESPACE::IdeaPlaceEx::dumpProfile, "Write the profile of the global placement of the last solve as JSON")
         .def("runtimeIdeaPlaceEx", &PROJECT_NAMESPACE::IdeaPlaceEx::runtimeIdeaPlaceEx, "Get the runtime for the Ideaplace")
         .def("runtimeGlobalPlace", &PROJECT_NAMESPACE::IdeaPlaceEx::runtimeGlobalPlace, "Get the time used for global placement")
         .def("runtimeGlobalPlaceCalcObj", &PROJECT_NAMESPACE::IdeaPlaceEx::runtimeGlobalPlaceCalcObj, "Get the time used for calculating the objectives in global placement")
@@ -75,4 +95,18 @@ void initIdeaPlaceExAPI(py::module &m)
         .def("runtimeLegalization", &PROJECT_NAMESPACE::IdeaPlaceEx::runtimeLegalization, "Get the time used for legalization")
         .def("runtimeDetailedPlacement", &PROJECT_NAMESPACE::IdeaPlaceEx::runtimeDetailedPlacement, "Get the time used for detailed placement")
         ;
+
+    py::class_<PROJECT_NAMESPACE::IdeaPlaceExBatch>(m , "IdeaPlaceExBatch")
+        .def(py::init<>())
+        .def("addPlacer", &PROJECT_NAMESPACE::IdeaPlaceExBatch::addPlacer, "Add a placer with its problem read in. Return the index of the problem, or the max index if the placer is already in the batch",
+                py::arg("placer"), py::arg("gridSize") = -1, py::arg("timeBudgetMs") = 0, py::keep_alive<1, 2>())
+        .def("numPlacers", &PROJECT_NAMESPACE::IdeaPlaceExBatch::numPlacers, "Get the number of problems")
+        .def("clear", &PROJECT_NAMESPACE::IdeaPlaceExBatch::clear, "Remove all the problems")
+        .def("numThreads", &PROJECT_NAMESPACE::IdeaPlaceExBatch::setNumThreads, "Set the total number of threads of the batch")
+        .def("numThreadsOf", &PROJECT_NAMESPACE::IdeaPlaceExBatch::numThreadsOf, "Get the number of threads a problem is given")
+        .def("solve", &PROJECT_NAMESPACE::IdeaPlaceExBatch::solve, "Solve all the problems concurrently. Return the symmetric axis of each problem",
+                py::call_guard<py::gil_scoped_release>())
+        .def("profileGlobalPlacement", &PROJECT_NAMESPACE::IdeaPlaceExBatch::profileGlobalPlacement, "Get the counters of each operator family in the global placement of all the problems of the last solve")
+        .def("dumpProfile", &PROJECT_NAMESPACE::IdeaPlaceExBatch::dumpProfile, "Write the merged profile of the global placement of the last solve as JSON")
+        ;
 }
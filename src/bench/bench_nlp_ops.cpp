@@ -0,0 +1,944 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "place/nlp/nlpTasks.hpp"
+#include "place/nlp/nlpOverlapOps.hpp"
+#include "place/nlp/nlpSimdExp.hpp"
+#include "place/differentAutoDiff.hpp"
+#include "place/NlpGPlacer.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+/// @brief micro-benchmarks and gradient checks of the differentiable operators of the global placement.
+/// @details Each size level builds a synthetic placement and a set of operators of every type over it.
+/// The operators run through the same partial, gather and hessian tasks as in the placer. Only the gather is multi-threaded, as set by OMP_NUM_THREADS.
+/// The gradient of each set is checked against the central finite differences of its evaluations
+namespace bench
+{
+    typedef RealType num_type;
+    typedef RealType coord_type;
+    typedef Eigen::Matrix<num_type, Eigen::Dynamic, 1> vector_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    constexpr IndexType defaultSizes[] = { 100, 1000, 10000, 100000 }; ///< The number of cells of the size levels
+    constexpr coord_type pitch = 10; ///< The cells are on a jittered grid of this pitch, so that the neighbors overlap
+    constexpr coord_type totalCellArea = 100; ///< The placement is scaled to this total cell area, as in the placer
+    constexpr coord_type ovlAlphaCellDimRatio = 0.5; ///< The alpha of the overlapping penalties over the average cell dimension
+    constexpr IndexType numSlices = 8; ///< The number of operators sharing a neighbor list or a density map
+    constexpr IndexType netDegreeLo = 2; ///< The pin count of the common nets
+    constexpr IndexType netDegreeHi = 8;
+    constexpr IndexType wideNetDegree = 256; ///< The pin count of the wide nets
+    constexpr IndexType symGrpSize = 16; ///< The number of symmetric pairs in a group. A group also has two self-symmetric cells
+    constexpr IndexType numFdSamples = 16; ///< The variables checked in each operator set
+    constexpr RealType fdStep = 1e-4;
+    constexpr IndexType maxFdDraws = 64; ///< A sample is skipped if all its draws are near a kink
+    constexpr RealType fdTolerance = 1e-4; ///< The largest relative error of a gradient
+    constexpr RealType fdGradFloor = 1e-2; ///< The relative error is over max(|analytic|, |fd|, floor)
+
+    /// @brief the synthetic placement of a size level
+    struct Design
+    {
+        explicit Design(IndexType numCells, unsigned seed)
+            : numCells(numCells), rng(seed)
+        {
+            cols = std::max(static_cast<IndexType>(std::ceil(std::sqrt(numCells))), static_cast<IndexType>(2));
+            const IndexType rows = (numCells + cols - 1) / cols;
+            std::uniform_real_distribution<coord_type> jitter(-0.3 * pitch, 0.3 * pitch);
+            std::uniform_real_distribution<coord_type> dim(0.6 * pitch, 1.4 * pitch);
+            vars.resize(2 * numCells);
+            widths.resize(numCells);
+            heights.resize(numCells);
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                vars(cellIdx) = (cellIdx % cols) * pitch + jitter(rng);
+                vars(cellIdx + numCells) = (cellIdx / cols) * pitch + jitter(rng);
+                widths[cellIdx] = dim(rng);
+                heights[cellIdx] = dim(rng);
+            }
+            // Scale as the placer does, so that alpha and the exponentials are in the same range
+            coord_type area = 0;
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                area += widths[cellIdx] * heights[cellIdx];
+            }
+            scale = std::sqrt(totalCellArea / area);
+            vars *= scale;
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                widths[cellIdx] *= scale;
+                heights[cellIdx] *= scale;
+            }
+            // A bit smaller than the placement so that the boundary penalty is not zero
+            const coord_type xLen = cols * pitch * scale;
+            const coord_type yLen = rows * pitch * scale;
+            boundary = Box<coord_type>(0.05 * xLen, 0.05 * yLen, 0.95 * xLen, 0.95 * yLen);
+            symAxis = 0.5 * xLen;
+            alphaOvl = ovlAlphaCellDimRatio * std::sqrt(totalCellArea / numCells);
+        }
+        IndexType randCell() { return std::uniform_int_distribution<IndexType>(0, numCells - 1)(rng); }
+        diff::PlaceVarView<coord_type, coord_type> view() const { return diff::PlaceVarView<coord_type, coord_type>(vars.data(), numCells, &symAxis); }
+        IndexType varIdx(IndexType cellIdx, Orient2DType orient) const { return orient == Orient2DType::HORIZONTAL ? cellIdx : cellIdx + numCells; }
+
+        IndexType numCells = 0;
+        IndexType cols = 0;
+        coord_type scale = 1; ///< From the generated coordinates to the placement coordinates
+        vector_type vars; ///< [x_0 .. x_n-1, y_0 .. y_n-1]. The symmetric axis is fixed
+        std::vector<coord_type> widths;
+        std::vector<coord_type> heights;
+        Box<coord_type> boundary;
+        coord_type symAxis = 0;
+        RealType alpha = 1.0; ///< In the range of the placer
+        RealType alphaOvl = 1.0; ///< Relative to the cell dimensions, so that the neighbor list stays sparse at the large sizes
+        RealType lambda = 1.0;
+        std::mt19937 rng;
+    };
+
+    /// @brief the timings of an operator set. The best of the repeats, in nanoseconds for the whole set
+    struct Result
+    {
+        std::string name;
+        IndexType numOps = 0;
+        IndexType numPins = 0; ///< The number of cells touched by the operators, counted per operator
+        RealType prepNs = 0; ///< Refreshing the shared neighbor list or density map
+        RealType evalNs = 0; ///< evaluate()
+        RealType gradNs = 0; ///< accumlateGradient() into the partials
+        RealType fusedNs = 0; ///< evaluateAndAccumulate() into the partials
+        RealType gatherNs = 0; ///< gathering the partials into the gradient
+        RealType hessNs = 0; ///< the jacobi hessian approximation
+        bool hasHessian = true; ///< Whether the operator has a jacobi hessian approximation
+        RealType maxRelErr = 0; ///< of the gradient against the finite differences
+        bool pass() const { return maxRelErr <= fdTolerance; } // false if NaN
+    };
+
+    /// @brief whether the operator has a jacobi hessian approximation
+    template<typename op_type, typename = void>
+    struct has_hessian_trait : std::false_type {};
+    template<typename op_type>
+    struct has_hessian_trait<op_type, std::void_t<decltype(&diff::jacobi_hessian_approx_trait<op_type>::accumulateHessian)>> : std::true_type {};
+
+    template<typename func_type>
+    RealType timeNs(func_type &&func)
+    {
+        const auto begin = clock_type::now();
+        func();
+        return std::chrono::duration<RealType, std::nano>(clock_type::now() - begin).count();
+    }
+
+    /// @brief benchmark and check a set of operators
+    /// @param the name of the set
+    /// @param the design the operators are over
+    /// @param the operators. Need to stay at the same place
+    /// @param the number of repeats. The best is kept
+    /// @param refreshes the state shared by the operators after the placement changes. Empty if none
+    /// @param whether a variable is within the finite difference step of a kink of a piecewise smooth operator. Such samples are drawn again. Empty if smooth
+    template<typename op_type>
+    Result runOpSet(const std::string &name, Design &design, std::vector<op_type> &ops, IndexType repeats,
+            const std::function<void()> &prepare, const std::function<bool(IndexType)> &isNearKink = nullptr)
+    {
+        typedef nt::CalculateOperatorPartialTask<op_type, vector_type> calc_type;
+        typedef nt::GatherGradientFromPartialTask<op_type, vector_type> gather_type;
+        auto idxFunc = [&](IndexType cellIdx, Orient2DType orient) { return design.varIdx(cellIdx, orient); };
+        auto prep = [&]() { if (prepare) { prepare(); } };
+
+        Result result;
+        result.name = name;
+        result.numOps = ops.size();
+        prep();
+        std::vector<nt::Task<calc_type>> calcTasks;
+        calcTasks.reserve(ops.size());
+        for (auto &op : ops)
+        {
+            op.setGetVarFunc(design.view());
+            calcTasks.emplace_back(nt::Task<calc_type>(calc_type(&op)));
+            result.numPins += calcTasks.back().taskData().numCells();
+        }
+        vector_type grad = vector_type::Zero(design.vars.size());
+        vector_type hess = vector_type::Zero(design.vars.size());
+        gather_type gather(calcTasks, &grad, idxFunc);
+        // Not all the operators have a hessian approximation
+        std::function<void()> calcHessian;
+        if constexpr (has_hessian_trait<op_type>::value)
+        {
+            typedef nt::CalculateOperatorHessianTask<op_type, diff::jacobi_hessian_approx_trait<op_type>, vector_type, vector_type> hess_type;
+            auto hessTasks = std::make_shared<std::vector<hess_type>>();
+            hessTasks->reserve(ops.size());
+            for (auto &op : ops)
+            {
+                hessTasks->emplace_back(hess_type(&op, &hess, idxFunc));
+            }
+            calcHessian = [hessTasks]()
+            {
+                for (auto &task : *hessTasks) { task.calc(); task.update(); }
+            };
+        }
+        result.hasHessian = static_cast<bool>(calcHessian);
+        auto evaluate = [&]()
+        {
+            num_type obj = 0;
+            for (const auto &op : ops)
+            {
+                obj += diff::placement_differentiable_traits<op_type>::evaluate(op);
+            }
+            return obj;
+        };
+
+        result.prepNs = result.evalNs = result.gradNs = result.fusedNs = result.gatherNs = result.hessNs = std::numeric_limits<RealType>::max();
+        volatile num_type sink = 0;
+        for (IndexType iter = 0; iter < repeats; ++iter)
+        {
+            result.prepNs = std::min(result.prepNs, timeNs(prep));
+            result.evalNs = std::min(result.evalNs, timeNs([&]() { sink = evaluate(); }));
+            result.gradNs = std::min(result.gradNs, timeNs([&]()
+                        {
+                            for (auto &calc : calcTasks) { calc_type::run(calc.taskData()); }
+                        }));
+            result.fusedNs = std::min(result.fusedNs, timeNs([&]()
+                        {
+                            for (auto &calc : calcTasks) { calc_type::runWithObj(calc.taskData()); }
+                        }));
+            grad.setZero();
+            result.gatherNs = std::min(result.gatherNs, timeNs([&]() { gather_type::run(gather); }));
+            hess.setZero();
+            result.hessNs = calcHessian ? std::min(result.hessNs, timeNs(calcHessian)) : 0;
+        }
+        (void)sink;
+
+        // Check the gathered gradient. Half of the samples are the nonzero entries, so that the small sets are checked too.
+        // The differences are taken operator by operator, so that the operators away from the variable do not add rounding errors
+        std::vector<num_type> objHi(ops.size());
+        std::vector<IndexType> nonzeros;
+        for (IndexType idx = 0; idx < grad.size(); ++idx)
+        {
+            if (grad(idx) != 0) { nonzeros.emplace_back(idx); }
+        }
+        for (IndexType sample = 0; sample < numFdSamples; ++sample)
+        {
+            IndexType varIdx;
+            IndexType numDraws = 0;
+            do
+            {
+                if (sample % 2 == 0 and not nonzeros.empty())
+                {
+                    varIdx = nonzeros[std::uniform_int_distribution<IndexType>(0, nonzeros.size() - 1)(design.rng)];
+                }
+                else
+                {
+                    varIdx = std::uniform_int_distribution<IndexType>(0, design.vars.size() - 1)(design.rng);
+                }
+            } while (isNearKink and isNearKink(varIdx) and ++numDraws < maxFdDraws);
+            if (numDraws == maxFdDraws)
+            {
+                continue;
+            }
+            const coord_type value = design.vars(varIdx);
+            design.vars(varIdx) = value + fdStep;
+            prep();
+            for (IndexType opIdx = 0; opIdx < ops.size(); ++opIdx)
+            {
+                objHi[opIdx] = diff::placement_differentiable_traits<op_type>::evaluate(ops[opIdx]);
+            }
+            design.vars(varIdx) = value - fdStep;
+            prep();
+            num_type objDiff = 0;
+            for (IndexType opIdx = 0; opIdx < ops.size(); ++opIdx)
+            {
+                objDiff += objHi[opIdx] - diff::placement_differentiable_traits<op_type>::evaluate(ops[opIdx]);
+            }
+            design.vars(varIdx) = value;
+            prep();
+            const RealType fd = objDiff / (2 * fdStep);
+            const RealType relErr = std::fabs(grad(varIdx) - fd) / std::max(std::max(std::fabs(grad(varIdx)), std::fabs(fd)), fdGradFloor);
+            // NaN fails the check
+            result.maxRelErr = std::isnan(relErr) ? relErr : std::max(result.maxRelErr, relErr);
+            if (std::isnan(relErr))
+            {
+                break;
+            }
+        }
+        return result;
+    }
+
+    /// @brief build the operator sets of a size level and run them
+    std::vector<Result> runSize(IndexType numCells, IndexType repeats, unsigned seed)
+    {
+        typedef diff::LseHpwlDifferentiable<num_type, coord_type> hpwl_type;
+        typedef diff::CellPairOverlapPenaltyDifferentiable<num_type, coord_type> ovl_pair_type;
+        typedef diff::CellPairOverlapNeighborListPenaltyDifferentiable<num_type, coord_type> ovl_nbl_type;
+        typedef diff::ElectrostaticDensityPenaltyDifferentiable<num_type, coord_type> ovl_density_type;
+        typedef diff::CellOutOfBoundaryPenaltyDifferentiable<num_type, coord_type> oob_type;
+        typedef diff::AsymmetryDifferentiable<num_type, coord_type> asym_type;
+        typedef diff::CosineDatapathDifferentiable<num_type, coord_type> cos_type;
+        typedef diff::PowerVerQuadraticWireLengthDifferentiable<num_type, coord_type> power_wl_type;
+        typedef diff::CurrentFlowDifferentiable<num_type, coord_type> crf_type;
+
+        Design design(numCells, seed);
+        const diff::NumericRef<num_type> alpha(&design.alpha);
+        const diff::NumericRef<num_type> alphaOvl(&design.alphaOvl);
+        const diff::NumericRef<num_type> lambda(&design.lambda);
+        std::uniform_real_distribution<coord_type> offset(0, 0.6 * pitch * design.scale);
+        std::vector<Result> results;
+
+        // HPWL of the common nets and of the wide nets
+        {
+            std::uniform_int_distribution<IndexType> degree(netDegreeLo, netDegreeHi);
+            std::vector<hpwl_type> ops;
+            for (IndexType netIdx = 0; netIdx < std::max(numCells / 2, static_cast<IndexType>(1)); ++netIdx)
+            {
+                ops.emplace_back(hpwl_type(alpha, lambda));
+                const IndexType deg = degree(design.rng);
+                for (IndexType pin = 0; pin < deg; ++pin)
+                {
+                    ops.back().addVar(design.randCell(), offset(design.rng), offset(design.rng));
+                }
+            }
+            results.emplace_back(runOpSet("hpwl", design, ops, repeats, nullptr));
+        }
+        {
+            const IndexType deg = std::min(wideNetDegree, numCells);
+            std::vector<hpwl_type> ops;
+            for (IndexType netIdx = 0; netIdx < std::max(numCells / wideNetDegree, static_cast<IndexType>(1)); ++netIdx)
+            {
+                ops.emplace_back(hpwl_type(alpha, lambda));
+                for (IndexType pin = 0; pin < deg; ++pin)
+                {
+                    ops.back().addVar(design.randCell(), offset(design.rng), offset(design.rng));
+                }
+            }
+            results.emplace_back(runOpSet("hpwl.wide", design, ops, repeats, nullptr));
+        }
+        // Overlap of the neighboring pairs on the grid
+        {
+            std::vector<ovl_pair_type> ops;
+            auto addPair = [&](IndexType i, IndexType j)
+            {
+                if (j < numCells)
+                {
+                    ops.emplace_back(ovl_pair_type(i, design.widths[i], design.heights[i], j, design.widths[j], design.heights[j], alphaOvl, lambda));
+                }
+            };
+            for (IndexType i = 0; i < numCells; ++i)
+            {
+                if ((i + 1) % design.cols != 0) { addPair(i, i + 1); }
+                addPair(i, i + design.cols);
+                if ((i + 1) % design.cols != 0) { addPair(i, i + design.cols + 1); }
+                if (i % design.cols != 0) { addPair(i, i + design.cols - 1); }
+            }
+            results.emplace_back(runOpSet("ovl.pair", design, ops, repeats, nullptr));
+        }
+        // Overlap with the neighbor list. The list is not rebuilt by the small perturbations of the finite differences
+        {
+            typedef nlp::ovl_ops::ovl_ops_trait<ovl_nbl_type> trait;
+            auto neighborList = std::make_shared<typename ovl_nbl_type::neighbor_list_type>();
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                neighborList->addCell(cellIdx, design.widths[cellIdx], design.heights[cellIdx]);
+            }
+            neighborList->setSkin(trait::skinRatio * std::sqrt(totalCellArea / numCells));
+            neighborList->setCutoffAlphaRatio(trait::cutoffAlphaRatio);
+            std::vector<ovl_nbl_type> ops;
+            for (IndexType sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+            {
+                ops.emplace_back(ovl_nbl_type(neighborList, sliceIdx, numSlices, alphaOvl, lambda));
+                ops.back().setGetVarFunc(design.view());
+            }
+            results.emplace_back(runOpSet("ovl.nbl", design, ops, repeats, [&]() { ops.front().refreshNeighborList(); }));
+        }
+        // Electrostatic density
+        {
+            typedef nlp::ovl_ops::ovl_ops_trait<ovl_density_type> trait;
+            IndexType numBinsPerDim = trait::minNumBinsPerDim;
+            while (numBinsPerDim * numBinsPerDim < numCells and numBinsPerDim < trait::maxNumBinsPerDim)
+            {
+                numBinsPerDim *= 2;
+            }
+            auto densityMap = std::make_shared<typename ovl_density_type::density_map_type>(&design.boundary, numBinsPerDim);
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                densityMap->addCell(cellIdx, design.widths[cellIdx], design.heights[cellIdx]);
+            }
+            std::vector<ovl_density_type> ops;
+            for (IndexType sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+            {
+                ops.emplace_back(ovl_density_type(densityMap, sliceIdx, numSlices, alphaOvl, lambda));
+                ops.back().setGetVarFunc(design.view());
+            }
+            // The bins are of the size of the cells at the large sizes, so the steps often cross a bin edge. The cells are added in order, so the local indices are the cell indices
+            auto isNearKink = [&](IndexType varIdx)
+            {
+                return densityMap->distanceToBinEdge(varIdx % numCells, varIdx < numCells) <= fdStep;
+            };
+            results.emplace_back(runOpSet("ovl.density", design, ops, repeats, [&]() { ops.front().updateDensityMap(); }, isNearKink));
+        }
+        // Out of boundary
+        {
+            std::vector<oob_type> ops;
+            for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+            {
+                ops.emplace_back(oob_type(cellIdx, design.widths[cellIdx], design.heights[cellIdx], &design.boundary, alpha, lambda));
+            }
+            results.emplace_back(runOpSet("oob", design, ops, repeats, nullptr));
+        }
+        // Asymmetry of the groups of consecutive cells
+        {
+            std::vector<asym_type> ops;
+            const IndexType cellsPerGrp = 2 * symGrpSize + 2;
+            for (IndexType grpIdx = 0; (grpIdx + 1) * cellsPerGrp <= numCells; ++grpIdx)
+            {
+                ops.emplace_back(asym_type(grpIdx, lambda));
+                const IndexType first = grpIdx * cellsPerGrp;
+                for (IndexType pairIdx = 0; pairIdx < symGrpSize; ++pairIdx)
+                {
+                    ops.back().addSymPair(first + 2 * pairIdx, first + 2 * pairIdx + 1, design.widths[first + 2 * pairIdx]);
+                }
+                ops.back().addSelfSym(first + cellsPerGrp - 2, design.widths[first + cellsPerGrp - 2]);
+                ops.back().addSelfSym(first + cellsPerGrp - 1, design.widths[first + cellsPerGrp - 1]);
+            }
+            results.emplace_back(runOpSet("asym", design, ops, repeats, nullptr));
+        }
+        // Cosine of the three-cell datapaths
+        {
+            std::vector<cos_type> ops;
+            for (IndexType pathIdx = 0; pathIdx < std::max(numCells / 3, static_cast<IndexType>(1)); ++pathIdx)
+            {
+                const IndexType s = design.randCell();
+                IndexType mid = design.randCell();
+                IndexType t = design.randCell();
+                while (mid == s) { mid = design.randCell(); }
+                while (t == s or t == mid) { t = design.randCell(); }
+                ops.emplace_back(cos_type(
+                            s, XY<coord_type>(offset(design.rng), offset(design.rng)),
+                            mid, XY<coord_type>(offset(design.rng), offset(design.rng)), XY<coord_type>(offset(design.rng), offset(design.rng)),
+                            t, XY<coord_type>(offset(design.rng), offset(design.rng)),
+                            lambda));
+            }
+            results.emplace_back(runOpSet("cos", design, ops, repeats, nullptr));
+        }
+        // Vertical quadratic wire length of the power nets to their virtual pins
+        {
+            std::uniform_int_distribution<IndexType> degree(netDegreeLo, netDegreeHi);
+            std::vector<power_wl_type> ops;
+            for (IndexType netIdx = 0; netIdx < std::max(numCells / 4, static_cast<IndexType>(1)); ++netIdx)
+            {
+                ops.emplace_back(power_wl_type(lambda));
+                const IndexType deg = degree(design.rng);
+                for (IndexType pin = 0; pin < deg; ++pin)
+                {
+                    ops.back().addVar(design.randCell(), offset(design.rng), offset(design.rng));
+                }
+                ops.back().setVirtualPin(design.boundary.xLo(), design.boundary.yLo());
+            }
+            results.emplace_back(runOpSet("powerWl", design, ops, repeats, nullptr));
+        }
+        // Current flow of the cell pairs
+        {
+            std::vector<crf_type> ops;
+            for (IndexType flowIdx = 0; flowIdx < std::max(numCells / 2, static_cast<IndexType>(1)); ++flowIdx)
+            {
+                const IndexType s = design.randCell();
+                IndexType t = design.randCell();
+                while (t == s) { t = design.randCell(); }
+                ops.emplace_back(crf_type(s, offset(design.rng), t, offset(design.rng), lambda));
+                ops.back().setGetAlphaFunc(alpha);
+            }
+            results.emplace_back(runOpSet("crf", design, ops, repeats, nullptr));
+        }
+        return results;
+    }
+
+    void printHeader()
+    {
+        std::printf("%-12s %8s %9s %10s %10s %10s %10s %10s %10s %10s  %s\n",
+                "operator", "ops", "pins", "prep/op", "eval/op", "grad/op", "fused/op", "gather/op", "hess/op", "grad.err", "check");
+    }
+    void printResult(const Result &result)
+    {
+        const RealType numOps = std::max(result.numOps, static_cast<IndexType>(1));
+        char hess[16] = "-";
+        if (result.hasHessian)
+        {
+            std::snprintf(hess, sizeof(hess), "%.1f", result.hessNs / numOps);
+        }
+        std::printf("%-12s %8u %9u %10.1f %10.1f %10.1f %10.1f %10.1f %10s %10.2e  %s\n",
+                result.name.c_str(), result.numOps, result.numPins,
+                result.prepNs / numOps, result.evalNs / numOps, result.gradNs / numOps, result.fusedNs / numOps,
+                result.gatherNs / numOps, hess, result.maxRelErr,
+                result.pass() ? "ok" : "FAIL");
+    }
+
+    /// @brief check the vectorized exponential against std::exp with each instruction set the CPU has, at the edges of the double range and on a sweep
+    /// @return whether all the values are within the tolerance
+    bool checkSimdExp()
+    {
+        typedef nlp::simd::SimdIsaType isa_type;
+        const std::vector<double> edges = {
+            -1e4, -746.0, -745.2, -745.0, -744.0, -720.0, -708.5, -708.39, -708.0, -700.0, -1.0, -1e-300, 0.0, 1e-300, 1.0, 700.0,
+            708.0, 709.0, 709.5, 709.7, 709.78, 709.79, 710.0, 1e4 };
+        std::vector<double> values = edges;
+        for (IntType idx = -7500; idx <= 7500; ++idx)
+        {
+            values.emplace_back(idx * 0.1 + 0.0123);
+        }
+        const auto isaInUse = nlp::simd::simdIsa();
+        bool pass = true;
+        std::printf("exp check:");
+        for (isa_type isa : { isa_type::SCALAR, isa_type::AVX2, isa_type::AVX512 })
+        {
+            nlp::simd::setSimdIsa(isa);
+            if (nlp::simd::simdIsa() != isa)
+            {
+                continue;
+            }
+            std::vector<double> out(values.size());
+            nlp::simd::expScaled(values.data(), out.data(), values.size(), 1.0);
+            RealType maxRelErr = 0;
+            bool isaPass = true;
+            for (IndexType idx = 0; idx < values.size(); ++idx)
+            {
+                const double ref = std::exp(values[idx]);
+                if (std::isinf(ref))
+                {
+                    // Overflows or saturates at the largest values
+                    isaPass = isaPass and (out[idx] == ref or out[idx] >= 0.5 * std::numeric_limits<double>::max());
+                    continue;
+                }
+                // The subnormal results have only a few significant bits
+                const RealType err = std::fabs(out[idx] - ref);
+                isaPass = isaPass and std::isfinite(out[idx]) and err <= 1e-13 * ref + 1e-320;
+                if (ref >= std::numeric_limits<double>::min())
+                {
+                    maxRelErr = std::max(maxRelErr, err / ref);
+                }
+            }
+            std::printf(" %s %.2e %s,", isa == isa_type::SCALAR ? "scalar" : (isa == isa_type::AVX2 ? "avx2" : "avx512"), maxRelErr, isaPass ? "ok" : "FAIL");
+            pass = pass and isaPass;
+        }
+        std::printf("\n");
+        nlp::simd::setSimdIsa(isaInUse);
+        return pass;
+    }
+
+    /// @brief check the full hessian of the HPWL against the finite differences of its gradient,
+    /// and the newton direction of the second-order placer with the full hessian against the clipped hessian
+    /// @return whether both are within the tolerance
+    bool checkFullHessian(unsigned seed)
+    {
+        typedef diff::LseHpwlDifferentiable<num_type, coord_type> hpwl_type;
+        typedef Eigen::SparseMatrix<num_type> sparse_type;
+        typedef nt::CalculateOperatorHessianTask<hpwl_type, diff::full_hessian_trait<hpwl_type>, vector_type, sparse_type> hess_type;
+        typedef nt::CalculateOperatorPartialTask<hpwl_type, vector_type> calc_type;
+        typedef nt::GatherGradientFromPartialTask<hpwl_type, vector_type> gather_type;
+        typedef _nlp_second_order_details::is_diagonal_select<nlp::nlp_full_hpwl_hessian_settings, false> selector_type;
+        constexpr IndexType numCells = 100;
+
+        Design design(numCells, seed);
+        const diff::NumericRef<num_type> alpha(&design.alpha);
+        const diff::NumericRef<num_type> lambda(&design.lambda);
+        std::uniform_real_distribution<coord_type> offset(0, 0.6 * pitch * design.scale);
+        std::uniform_int_distribution<IndexType> degree(netDegreeLo, netDegreeHi);
+        std::vector<hpwl_type> ops;
+        for (IndexType netIdx = 0; netIdx < numCells / 2; ++netIdx)
+        {
+            ops.emplace_back(hpwl_type(alpha, lambda));
+            const IndexType deg = degree(design.rng);
+            for (IndexType pin = 0; pin < deg; ++pin)
+            {
+                ops.back().addVar(design.randCell(), offset(design.rng), offset(design.rng));
+            }
+            if (netIdx % 4 == 0)
+            {
+                ops.back().setVirtualPin(design.boundary.xLo(), design.boundary.yHi());
+            }
+        }
+        auto idxFunc = [&](IndexType cellIdx, Orient2DType orient) { return design.varIdx(cellIdx, orient); };
+        std::vector<nt::Task<calc_type>> calcTasks;
+        std::vector<hess_type> hessTasks;
+        sparse_type hess(design.vars.size(), design.vars.size());
+        for (auto &op : ops)
+        {
+            op.setGetVarFunc(design.view());
+            calcTasks.emplace_back(nt::Task<calc_type>(calc_type(&op)));
+            hessTasks.emplace_back(hess_type(&op, &hess, idxFunc));
+        }
+        vector_type grad = vector_type::Zero(design.vars.size());
+        gather_type gather(calcTasks, &grad, idxFunc);
+        auto gradient = [&]()
+        {
+            for (auto &calc : calcTasks) { calc_type::run(calc.taskData()); }
+            grad.setZero();
+            gather_type::run(gather);
+            return vector_type(grad);
+        };
+        for (auto &task : hessTasks) { task.calc(); }
+        _nlp_second_order_details::updateHessian(hessTasks, hess);
+
+        // Compare the columns of the hessian with the differences of the gradients
+        RealType maxHessErr = 0;
+        for (IndexType sample = 0; sample < numFdSamples; ++sample)
+        {
+            const IndexType varIdx = std::uniform_int_distribution<IndexType>(0, design.vars.size() - 1)(design.rng);
+            const coord_type value = design.vars(varIdx);
+            design.vars(varIdx) = value + fdStep;
+            const vector_type gradHi = gradient();
+            design.vars(varIdx) = value - fdStep;
+            const vector_type fd = (gradHi - gradient()) / (2 * fdStep);
+            design.vars(varIdx) = value;
+            const vector_type col = hess.col(varIdx);
+            const RealType relErr = (col - fd).cwiseAbs().maxCoeff() / std::max(std::max(col.cwiseAbs().maxCoeff(), fd.cwiseAbs().maxCoeff()), fdGradFloor);
+            maxHessErr = std::isnan(relErr) ? relErr : std::max(maxHessErr, relErr);
+        }
+
+        // The newton direction solves the clipped hessian, without falling back to its diagonal
+        const vector_type rhs = gradient();
+        _nlp_second_order_details::clipHessian(hess, 0.01, 10.0);
+        const vector_type direction = selector_type::solve(hess, rhs);
+        const RealType residual = (hess * direction - rhs).norm() / std::max(rhs.norm(), std::numeric_limits<RealType>::min());
+
+        const bool pass = maxHessErr <= fdTolerance and residual <= 1e-8;
+        std::printf("full hessian check: hess.err %.2e solve.res %.2e nnz %ld %s\n", maxHessErr, residual, static_cast<long>(hess.nonZeros()), pass ? "ok" : "FAIL");
+        return pass;
+    }
+
+    /// @brief the operators of a family over a design, with the tasks computing their gradient as in the placer
+    template<typename op_type>
+    struct OpFamily
+    {
+        typedef nt::CalculateOperatorPartialTask<op_type, vector_type> calc_type;
+        typedef nt::GatherGradientFromPartialTask<op_type, vector_type> gather_type;
+
+        /// @brief build the tasks once all the operators are added. The operators need to stay at the same place afterwards
+        void init(Design &design)
+        {
+            grad = vector_type::Zero(design.vars.size());
+            for (auto &op : ops)
+            {
+                op.setGetVarFunc(design.view());
+                calcTasks.emplace_back(nt::Task<calc_type>(calc_type(&op)));
+            }
+            gather = std::make_unique<gather_type>(calcTasks, &grad, [&design](IndexType cellIdx, Orient2DType orient) { return design.varIdx(cellIdx, orient); });
+        }
+        num_type evaluate() const
+        {
+            num_type obj = 0;
+            for (const auto &op : ops) { obj += diff::placement_differentiable_traits<op_type>::evaluate(op); }
+            return obj;
+        }
+        const vector_type & calcGrad()
+        {
+            for (auto &calc : calcTasks) { calc_type::run(calc.taskData()); }
+            grad.setZero();
+            gather_type::run(*gather);
+            return grad;
+        }
+
+        std::vector<op_type> ops;
+        std::vector<nt::Task<calc_type>> calcTasks;
+        std::unique_ptr<gather_type> gather;
+        vector_type grad;
+    };
+
+    /// @brief a small placement problem for the optimization kernels: the HPWL, the overlapping of the neighboring pairs and the out of boundary penalty.
+    /// It has the members the kernels use from NlpGPlacerFirstOrder
+    struct OptmProblem
+    {
+        typedef vector_type EigenVector;
+        typedef diff::LseHpwlDifferentiable<num_type, coord_type> hpwl_type;
+        typedef diff::CellPairOverlapPenaltyDifferentiable<num_type, coord_type> ovl_type;
+        typedef diff::CellOutOfBoundaryPenaltyDifferentiable<num_type, coord_type> oob_type;
+
+        OptmProblem(Design &design)
+            : _numVariables(design.vars.size()), _pl(design.vars),
+            _optimizerKernelStopWatch(WATCH_CREATE_NEW("bench_optimizer_kernel"))
+        {
+            const diff::NumericRef<num_type> alpha(&design.alpha);
+            const diff::NumericRef<num_type> alphaOvl(&design.alphaOvl);
+            const diff::NumericRef<num_type> lambda(&design.lambda);
+            const IndexType numCells = design.numCells;
+            std::uniform_real_distribution<coord_type> offset(0, 0.6 * pitch * design.scale);
+            std::uniform_int_distribution<IndexType> degree(netDegreeLo, netDegreeHi);
+            for (IndexType netIdx = 0; netIdx < numCells / 2; ++netIdx)
+            {
+                _hpwl.ops.emplace_back(hpwl_type(alpha, lambda));
+                const IndexType deg = degree(design.rng);
+                for (IndexType pin = 0; pin < deg; ++pin)
+                {
+                    _hpwl.ops.back().addVar(design.randCell(), offset(design.rng), offset(design.rng));
+                }
+            }
+            for (IndexType i = 0; i < numCells; ++i)
+            {
+                for (IndexType j = i + 1; j < numCells; ++j)
+                {
+                    _ovl.ops.emplace_back(ovl_type(i, design.widths[i], design.heights[i], j, design.widths[j], design.heights[j], alphaOvl, lambda));
+                }
+                _oob.ops.emplace_back(oob_type(i, design.widths[i], design.heights[i], &design.boundary, alpha, lambda));
+            }
+            _hpwl.init(design);
+            _ovl.init(design);
+            _oob.init(design);
+            _grad = vector_type::Zero(_numVariables);
+        }
+        void calcObj()
+        {
+            _objHpwl = _hpwl.evaluate();
+            _objOvl = _ovl.evaluate();
+            _objOob = _oob.evaluate();
+            _obj = _objHpwl + _objOvl + _objOob;
+            // The lambda of the design is 1, so the raw terms are the same
+            _objHpwlRaw = _objHpwl;
+            _objOvlRaw = _objOvl;
+            _objOobRaw = _objOob;
+        }
+        void calcGrad()
+        {
+            _grad = _hpwl.calcGrad() + _ovl.calcGrad() + _oob.calcGrad();
+        }
+        void calcObjAndGrad()
+        {
+            calcObj();
+            calcGrad();
+        }
+
+        IndexType _numVariables;
+        vector_type &_pl; ///< The variables of the design, which the operators read
+        vector_type _grad;
+        num_type _obj = 0;
+        num_type _objHpwl = 0;
+        num_type _objOvl = 0;
+        num_type _objOob = 0;
+        num_type _objAsym = 0;
+        num_type _objCos = 0;
+        num_type _objPowerWl = 0;
+        num_type _objCrf = 0;
+        num_type _objHpwlRaw = 0;
+        num_type _objOvlRaw = 0;
+        num_type _objOobRaw = 0;
+        num_type _objAsymRaw = 0;
+        num_type _objCosRaw = 0;
+        num_type _objPowrWlRaw = 0;
+        num_type _objCrfRaw = 0;
+        std::unique_ptr<::klib::StopWatch> _optimizerKernelStopWatch;
+        OpFamily<hpwl_type> _hpwl;
+        OpFamily<ovl_type> _ovl;
+        OpFamily<oob_type> _oob;
+    };
+} // namespace bench
+
+namespace nlp
+{
+    template<>
+    struct is_first_order_diff<bench::OptmProblem> : std::true_type {};
+} // namespace nlp
+
+namespace bench
+{
+    constexpr IndexType optmNumCells = 100; ///< The number of cells of the problem for the optimization kernels
+    constexpr IndexType optmNumIters = 2000; ///< The number of iterations of each kernel. More than the warm-up of adam
+
+    /// @brief run an optimization kernel from the jittered grid for a fixed number of iterations
+    /// @return whether the objective decreases and stays finite
+    template<typename optm_type>
+    bool runOptimizer(const std::string &name, unsigned seed)
+    {
+        typedef nlp::optm::optm_trait<optm_type> optm_trait;
+        Design design(optmNumCells, seed);
+        OptmProblem problem(design);
+        problem.calcObj();
+        const num_type objInit = problem._obj;
+        optm_type optm;
+        const RealType ns = timeNs([&]() { optm_trait::optimize(problem, optm); });
+        problem.calcObj();
+        const bool pass = std::isfinite(problem._obj) and problem._obj < objInit;
+        std::printf("%-12s %12.4e %12.4e %12.4e %10.1f  %s\n", name.c_str(), objInit, problem._obj, problem._objHpwl, ns * 1e-6, pass ? "ok" : "FAIL");
+        return pass;
+    }
+
+    /// @brief run the first-order kernels selectable in the placer on the same problem
+    bool checkOptimizers(unsigned seed)
+    {
+        typedef nlp::converge::converge_list<nlp::converge::converge_criteria_max_iter<optmNumIters>> converge_type;
+        std::printf("\nOptimization kernels, %u cells, %u iterations\n", optmNumCells, optmNumIters);
+        std::printf("%-12s %12s %12s %12s %10s  %s\n", "kernel", "obj.init", "obj", "hpwl", "ms", "check");
+        bool pass = runOptimizer<nlp::optm::first_order::adam<converge_type, num_type>>("adam", seed);
+        pass = runOptimizer<nlp::optm::first_order::lbfgs<converge_type, num_type>>("lbfgs", seed) and pass;
+        pass = runOptimizer<nlp::optm::first_order::adam<converge_type, num_type,
+             nlp::optm::step_size::barzilai_borwein<num_type>>>("adam-bb", seed) and pass;
+        pass = runOptimizer<nlp::optm::first_order::nesterov<converge_type, num_type,
+             nlp::optm::step_size::adaptive_restart<nlp::optm::step_size::armijo_backtracking<num_type>>>>("nesterov-arm", seed) and pass;
+        return pass;
+    }
+
+    /// @brief the Armijo step evaluates the objective at the trial points. Check that it leaves the variables and every objective member of the current point as they were
+    bool checkArmijoRestore(unsigned seed)
+    {
+        typedef nlp::optm::step_size::armijo_backtracking<num_type> step_size_type;
+        typedef nlp::optm::step_size::step_size_trait<step_size_type> step_size_trait;
+        Design design(optmNumCells, seed);
+        OptmProblem problem(design);
+        problem.calcObjAndGrad();
+        const vector_type pl0 = problem._pl;
+        const auto members = [](const OptmProblem &n)
+        {
+            return std::vector<num_type>{ n._obj, n._objHpwl, n._objOvl, n._objOob, n._objAsym, n._objCos, n._objPowerWl, n._objCrf,
+                n._objHpwlRaw, n._objOvlRaw, n._objOobRaw, n._objAsymRaw, n._objCosRaw, n._objPowrWlRaw, n._objCrfRaw };
+        };
+        const auto members0 = members(problem);
+        step_size_type stepSize;
+        const num_type step = step_size_trait::stepSize(problem, stepSize, static_cast<num_type>(1.0));
+        const bool pass = std::isfinite(step) and step > 0 and problem._pl == pl0 and members(problem) == members0;
+        std::printf("\nArmijo step %.4e, the current point restored: %s\n", step, pass ? "ok" : "FAIL");
+        return pass;
+    }
+
+    /// @brief check the dual numbers against the closed-form derivatives of the functions, including pow at x = 0
+    /// @return whether the values and the first and second partials match and the partials to the other variable are zero
+    bool checkDual()
+    {
+        typedef diff::ad::Dual<num_type, 2, 2> dual2_type;
+        typedef diff::ad::Dual<num_type, 2, 1> dual1_type;
+        struct Case
+        {
+            const char *name;
+            std::function<dual2_type(const dual2_type &)> fn;
+            std::function<num_type(num_type)> f, df, ddf;
+            std::vector<num_type> points;
+        };
+        const std::vector<num_type> nonNegative = { 0.0, 0.5, 2.0 };
+        const std::vector<num_type> positive = { 0.5, 2.0 };
+        const std::vector<Case> cases = {
+            { "pow0", [](const dual2_type &x) { return pow(x, 0.0); },
+                [](num_type) { return 1.0; }, [](num_type) { return 0.0; }, [](num_type) { return 0.0; }, nonNegative },
+            { "pow1", [](const dual2_type &x) { return pow(x, 1.0); },
+                [](num_type x) { return x; }, [](num_type) { return 1.0; }, [](num_type) { return 0.0; }, nonNegative },
+            { "pow2", [](const dual2_type &x) { return pow(x, 2.0); },
+                [](num_type x) { return x * x; }, [](num_type x) { return 2 * x; }, [](num_type) { return 2.0; }, nonNegative },
+            { "pow3", [](const dual2_type &x) { return pow(x, 3.0); },
+                [](num_type x) { return x * x * x; }, [](num_type x) { return 3 * x * x; }, [](num_type x) { return 6 * x; }, nonNegative },
+            { "pow2.5", [](const dual2_type &x) { return pow(x, 2.5); },
+                [](num_type x) { return x * x * std::sqrt(x); }, [](num_type x) { return 2.5 * x * std::sqrt(x); },
+                [](num_type x) { return 3.75 * std::sqrt(x); }, nonNegative },
+            { "pow-1.5", [](const dual2_type &x) { return pow(x, -1.5); },
+                [](num_type x) { return 1 / (x * std::sqrt(x)); }, [](num_type x) { return -1.5 / (x * x * std::sqrt(x)); },
+                [](num_type x) { return 3.75 / (x * x * x * std::sqrt(x)); }, positive },
+            { "sqrt", [](const dual2_type &x) { return sqrt(x); },
+                [](num_type x) { return std::sqrt(x); }, [](num_type x) { return 0.5 / std::sqrt(x); },
+                [](num_type x) { return -0.25 / (x * std::sqrt(x)); }, positive },
+            { "exp", [](const dual2_type &x) { return exp(x); },
+                [](num_type x) { return std::exp(x); }, [](num_type x) { return std::exp(x); }, [](num_type x) { return std::exp(x); }, positive },
+            { "log", [](const dual2_type &x) { return log(x); },
+                [](num_type x) { return std::log(x); }, [](num_type x) { return 1 / x; }, [](num_type x) { return -1 / (x * x); }, positive },
+            { "square", [](const dual2_type &x) { return diff::ad::square(x); },
+                [](num_type x) { return x * x; }, [](num_type x) { return 2 * x; }, [](num_type) { return 2.0; }, nonNegative },
+        };
+        const auto near = [](num_type value, num_type ref) { return std::isfinite(value) and std::fabs(value - ref) <= 1e-12 * (1 + std::fabs(ref)); };
+        bool pass = true;
+        std::printf("\ndual check:");
+        for (const Case &c : cases)
+        {
+            bool casePass = true;
+            for (num_type point : c.points)
+            {
+                const dual2_type y = c.fn(dual2_type::variable(point, 0));
+                casePass = casePass and near(y.value(), c.f(point)) and near(y.partial(0), c.df(point)) and near(y.secondPartial(0), c.ddf(point))
+                    and y.partial(1) == 0 and y.secondPartial(1) == 0;
+            }
+            std::printf(" %s %s,", c.name, casePass ? "ok" : "FAIL");
+            pass = pass and casePass;
+        }
+        // Without the hessian the power at zero must not go through x^(p-2) either
+        const dual1_type y = pow(dual1_type::variable(0.0, 0), 1.0);
+        const bool order1Pass = y.value() == 0 and y.partial(0) == 1 and y.partial(1) == 0;
+        std::printf(" pow1 order 1 %s\n", order1Pass ? "ok" : "FAIL");
+        return pass and order1Pass;
+    }
+
+    void printUsage(const char *exe)
+    {
+        std::printf("Usage: %s [-n maxCells] [-r repeats] [-s seed] [-o results.csv]\n", exe);
+        std::printf("  Times the differentiable operators at %u to %u cells, in ns per operator, and checks their gradients.\n",
+                defaultSizes[0], defaultSizes[sizeof(defaultSizes) / sizeof(defaultSizes[0]) - 1]);
+        std::printf("  Exits with 1 if a gradient differs from the finite differences by more than %g, or the vectorized exp from std::exp,\n", fdTolerance);
+        std::printf("  or the full HPWL hessian from the finite differences of the gradient, or its newton direction does not solve it,\n");
+        std::printf("  or an optimization kernel does not decrease the objective of a small placement problem,\n");
+        std::printf("  or the Armijo step does not restore the objectives of the current point,\n");
+        std::printf("  or a dual number differs from the closed-form derivatives\n");
+    }
+} // namespace bench
+
+PROJECT_NAMESPACE_END
+
+int main(int argc, char* argv[])
+{
+    using namespace PROJECT_NAMESPACE;
+    IndexType maxCells = 100000;
+    IndexType repeats = 5;
+    unsigned seed = 7;
+    std::string csvFile;
+    for (IntType argIdx = 1; argIdx < argc; ++argIdx)
+    {
+        const bool hasValue = argIdx + 1 < argc;
+        if (std::strcmp(argv[argIdx], "-n") == 0 and hasValue) { maxCells = std::atoi(argv[++argIdx]); }
+        else if (std::strcmp(argv[argIdx], "-r") == 0 and hasValue) { repeats = std::max(std::atoi(argv[++argIdx]), 1); }
+        else if (std::strcmp(argv[argIdx], "-s") == 0 and hasValue) { seed = std::atoi(argv[++argIdx]); }
+        else if (std::strcmp(argv[argIdx], "-o") == 0 and hasValue) { csvFile = argv[++argIdx]; }
+        else { bench::printUsage(argv[0]); return argIdx == 1 and std::strcmp(argv[argIdx], "-h") == 0 ? 0 : 1; }
+    }
+
+    std::ofstream csv;
+    if (not csvFile.empty())
+    {
+        csv.open(csvFile);
+        csv << "cells,operator,ops,pins,prepNs,evalNs,gradNs,fusedNs,gatherNs,hessNs,gradRelErr\n";
+    }
+    bool pass = bench::checkSimdExp();
+    pass = bench::checkFullHessian(seed) and pass;
+    for (IndexType numCells : bench::defaultSizes)
+    {
+        if (numCells > maxCells)
+        {
+            break;
+        }
+        const auto results = bench::runSize(numCells, repeats, seed);
+        std::printf("\n%u cells. Time in ns per operator, best of %u\n", numCells, repeats);
+        bench::printHeader();
+        bench::Result total;
+        total.name = "total";
+        for (const auto &result : results)
+        {
+            bench::printResult(result);
+            pass = pass and result.pass();
+            total.numOps += result.numOps;
+            total.numPins += result.numPins;
+            total.prepNs += result.prepNs;
+            total.evalNs += result.evalNs;
+            total.gradNs += result.gradNs;
+            total.fusedNs += result.fusedNs;
+            total.gatherNs += result.gatherNs;
+            total.hessNs += result.hessNs;
+            total.maxRelErr = std::max(total.maxRelErr, result.maxRelErr);
+            if (csv.is_open())
+            {
+                csv << numCells << "," << result.name << "," << result.numOps << "," << result.numPins << ","
+                    << result.prepNs << "," << result.evalNs << "," << result.gradNs << "," << result.fusedNs << ","
+                    << result.gatherNs << "," << result.hessNs << "," << result.maxRelErr << "\n";
+            }
+        }
+        bench::printResult(total);
+        std::printf("%-12s %8s %9s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f  (ms for all the operators)\n", "total.ms", "", "",
+                total.prepNs * 1e-6, total.evalNs * 1e-6, total.gradNs * 1e-6, total.fusedNs * 1e-6, total.gatherNs * 1e-6, total.hessNs * 1e-6);
+    }
+    pass = bench::checkOptimizers(seed) and pass;
+    pass = bench::checkArmijoRestore(seed) and pass;
+    pass = bench::checkDual() and pass;
+    std::printf("\nChecks %s\n", pass ? "passed" : "FAILED");
+    return pass ? 0 : 1;
+}
@@ -173,6 +173,9 @@ class Cell
         void setSelfSym(bool selfSym=true) { _bSelfSym = selfSym; };
         void setSymNetIdx(IndexType symNetIdx) { _symNetIdx = symNetIdx; }
         IndexType symNetIdx() const {return _symNetIdx; }
+        /// @brief whether the global placement keeps the cell at its current location relative to the other fixed cells
+        bool isFixed() const { return _bFixed; }
+        void setFixed(bool fixed=true) { _bFixed = fixed; }
 
     private:
         std::string _name; ///< The cell name
@@ -183,6 +186,7 @@ class Cell
         IndexType _symNetIdx =INDEX_TYPE_MAX; 
         bool _bSelfSym = false;
         bool _flip = false;
+        bool _bFixed = false; ///< Fixed in the incremental global placement
 };
 
 PROJECT_NAMESPACE_END
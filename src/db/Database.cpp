@@ -1,7 +1,14 @@
 #include "Database.h"
+#include <atomic>
 
 PROJECT_NAMESPACE_BEGIN
 
+Database::Database()
+{
+    static std::atomic<IndexType> numDatabases(0);
+    _stopWatchScope = "db" + std::to_string(numDatabases++) + ".";
+}
+
 bool Database::initCells()
 {
     for (IndexType cellIdx = 0; cellIdx < this->numCells(); ++cellIdx)
@@ -22,8 +22,8 @@ PROJECT_NAMESPACE_BEGIN
 class Database
 {
     public:
-        /// @brief default database
-        explicit Database() = default;
+        /// @brief default database. Each database gets its own scope of the stop watch names
+        explicit Database();
         /*------------------------------*/ 
         /* Initialization               */
         /*------------------------------*/ 
@@ -47,6 +47,15 @@ class Database
         /// @brief get the placement parameter wrapper
         /// @return the placement parameter wrapper
         Parameters & parameters() { return _para; }
+        /// @brief get the name of a stop watch of this placement. The watches are global, so the names are scoped by the database,
+        /// and the placers running concurrently, e.g. in IdeaPlaceExBatch, do not record into each other's watches. A copy keeps the scope
+        /// @param the name of the stop watch
+        /// @return the scoped name
+        std::string stopWatchName(const std::string &name) const { return _stopWatchScope + name; }
+        /// @brief get the scope of the stop watch names
+        const std::string & stopWatchScope() const { return _stopWatchScope; }
+        /// @brief set the scope of the stop watch names, e.g. to have the database of a coarse level record into the watches of its placer
+        void setStopWatchScope(const std::string &scope) { _stopWatchScope = scope; }
         /*------------------------------*/ 
         /* Vector operations            */
         /*------------------------------*/ 
@@ -218,6 +227,7 @@ class Database
         std::vector<SignalPath> _signalPaths; ///< The signal/current paths
         Tech _tech; ///< The tech information
         Parameters _para; ///< The parameters for the placement engine
+        std::string _stopWatchScope; ///< The prefix of the names of the stop watches of this placement
 };
 
 inline RealType Database::calculateTotalCellArea() const
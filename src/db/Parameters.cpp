@@ -5,9 +5,22 @@ Parameters::Parameters()
 {
     _ifUsePinAssignment = true;
     _numThreads = 10;
+    _nlpExecutorType = NlpExecutorType::PERSISTENT_REGION;
+    _nlpOptimizerType = NlpOptimizerType::ADAM;
+    _nlpPrecisionType = NlpPrecisionType::DOUBLE;
+    _numMultiStarts = 1;
+    _nlpInitSeed = 0;
+    _useMultilevel = false;
+    _nlpCheckpointFile = "";
+    _nlpCheckpointInterval = 10;
+    _nlpResumeFile = "";
+    _nlpTimeBudgetMs = 0;
+    _nlpTraceFile = "";
+    _nlpTraceCapacity = 1 << 15;
     _gridStep = -1;
     _virtualBoundaryExtension = 200; ///< The extension of current virtual boundary to the bounding box of placement
     _virtualPinInterval = 400; ///< The interval between each virtual pin
+    _virtualPinMoveThreshold = 20; ///< The displacement below which the virtual pin assignment is kept
     _layoutOffset = 1000; ///< The default offset for the placement
     _defaultAspectRatio = 1.2;
     _maxWhiteSpace = 2;
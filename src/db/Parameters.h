@@ -32,12 +32,38 @@ class Parameters
         void closeVirtualPinAssignment() { _ifUsePinAssignment = false; }
         /// @brief set the number of threads
         void setNumThreads(IndexType numThreads) { _numThreads = numThreads; }
+        /// @brief set how the operator tasks of the global placement are run in parallel
+        void setNlpExecutorType(NlpExecutorType nlpExecutorType) { _nlpExecutorType = nlpExecutorType; }
+        /// @brief set the first-order optimization kernel of the global placement
+        void setNlpOptimizerType(NlpOptimizerType nlpOptimizerType) { _nlpOptimizerType = nlpOptimizerType; }
+        /// @brief set the numerical precision of the global placement
+        void setNlpPrecisionType(NlpPrecisionType nlpPrecisionType) { _nlpPrecisionType = nlpPrecisionType; }
+        /// @brief set the number of global placement runs started concurrently. The best legal result is kept
+        void setNumMultiStarts(IndexType numMultiStarts) { _numMultiStarts = numMultiStarts; }
+        /// @brief set the seed of the random initial placement
+        void setNlpInitSeed(IndexType nlpInitSeed) { _nlpInitSeed = nlpInitSeed; }
+        /// @brief set whether to run the global placement on a hierarchy of clustered netlists
+        void setUseMultilevel(bool useMultilevel) { _useMultilevel = useMultilevel; }
+        /// @brief save the global placement state to a file every a number of outer iterations
+        /// @param the file name. Empty to disable
+        /// @param the number of outer iterations between two checkpoints
+        void setNlpCheckpoint(const std::string &filename, IndexType interval) { _nlpCheckpointFile = filename; _nlpCheckpointInterval = interval; }
+        /// @brief resume the global placement from a checkpoint file. Empty to start from scratch
+        void setNlpResumeFile(const std::string &filename) { _nlpResumeFile = filename; }
+        /// @brief record the convergence trace of the global placement
+        /// @param the file name. Written as CSV if it ends with .csv, binary otherwise. Empty to disable
+        /// @param the number of records to keep. The latest ones are kept in a longer run
+        void setNlpTrace(const std::string &filename, IndexType capacity) { _nlpTraceFile = filename; _nlpTraceCapacity = capacity; }
+        /// @brief set the wall-clock budget of a global placement run in millisecond. Not positive for no limit
+        void setNlpTimeBudgetMs(RealType nlpTimeBudgetMs) { _nlpTimeBudgetMs = nlpTimeBudgetMs; }
         /// @brief set the grid step constraint
         void setGridStep(LocType gridStep) { _gridStep = gridStep; } 
         /// @brief set the virutal boundary extension. The extension of boundary to io pin with respect to the cell placement
         void setVirtualBoundaryExtension(LocType virtualBoundaryExtension) { _virtualBoundaryExtension = virtualBoundaryExtension; _layoutOffset = 2 * virtualBoundaryExtension; }
         /// @brief set the pin interval 
         void setVirtualPinInterval(LocType virtualPinInterval) { _virtualPinInterval  = virtualPinInterval; }
+        /// @brief set how far the cells need to move for the virtual pins to be reassigned during the global placement. 0 to reassign after any move
+        void setVirtualPinMoveThreshold(LocType virtualPinMoveThreshold) { _virtualPinMoveThreshold = virtualPinMoveThreshold; }
         /*------------------------------*/ 
         /* Query the parameters         */
         /*------------------------------*/ 
@@ -51,6 +77,30 @@ class Parameters
         bool ifUsePinAssignment() const { return _ifUsePinAssignment; }
         /// @brief get the number of thread
         IndexType numThreads() const { return _numThreads; }
+        /// @brief get how the operator tasks of the global placement are run in parallel
+        NlpExecutorType nlpExecutorType() const { return _nlpExecutorType; }
+        /// @brief get the first-order optimization kernel of the global placement
+        NlpOptimizerType nlpOptimizerType() const { return _nlpOptimizerType; }
+        /// @brief get the numerical precision of the global placement
+        NlpPrecisionType nlpPrecisionType() const { return _nlpPrecisionType; }
+        /// @brief get the number of global placement runs started concurrently
+        IndexType numMultiStarts() const { return _numMultiStarts; }
+        /// @brief get the seed of the random initial placement
+        IndexType nlpInitSeed() const { return _nlpInitSeed; }
+        /// @brief get whether to run the multilevel global placement
+        bool useMultilevel() const { return _useMultilevel; }
+        /// @brief get the file of the global placement checkpoints. Empty if disabled
+        const std::string & nlpCheckpointFile() const { return _nlpCheckpointFile; }
+        /// @brief get the number of outer iterations between two checkpoints
+        IndexType nlpCheckpointInterval() const { return _nlpCheckpointInterval; }
+        /// @brief get the checkpoint file to resume the global placement from. Empty if starting from scratch
+        const std::string & nlpResumeFile() const { return _nlpResumeFile; }
+        /// @brief get the file of the convergence trace. Empty if disabled
+        const std::string & nlpTraceFile() const { return _nlpTraceFile; }
+        /// @brief get the number of trace records to keep
+        IndexType nlpTraceCapacity() const { return _nlpTraceCapacity; }
+        /// @brief get the wall-clock budget of a global placement run in millisecond. Not positive if no limit
+        RealType nlpTimeBudgetMs() const { return _nlpTimeBudgetMs; }
         /// @brief get the grid step
         LocType gridStep() const { return _gridStep; }
         /// @brief get wether there is grid step constraint
@@ -59,6 +109,8 @@ class Parameters
         LocType virtualBoundaryExtension() const { return _virtualBoundaryExtension; }
         /// @brief get the interval of virtual io pins
         LocType virtualPinInterval() const { return _virtualPinInterval; }
+        /// @brief get how far the cells need to move for the virtual pins to be reassigned during the global placement
+        LocType virtualPinMoveThreshold() const { return _virtualPinMoveThreshold; }
         /// @brief get the layout offset
         LocType layoutOffset() const { return _layoutOffset; }
         /// @brief get the default aspect ratio for the global placement
@@ -75,9 +127,22 @@ class Parameters
         Box<LocType> _boundaryConstraint = Box<LocType>(LOC_TYPE_MAX, LOC_TYPE_MAX, LOC_TYPE_MIN, LOC_TYPE_MIN);
         bool _ifUsePinAssignment; ///< If do pin assignment
         IndexType _numThreads;
+        NlpExecutorType _nlpExecutorType; ///< How the operator tasks of the global placement are run in parallel
+        NlpOptimizerType _nlpOptimizerType; ///< The first-order optimization kernel of the global placement
+        NlpPrecisionType _nlpPrecisionType; ///< The numerical precision of the global placement
+        IndexType _numMultiStarts; ///< The number of global placement runs started concurrently
+        IndexType _nlpInitSeed; ///< The seed of the random initial placement. Run k of a multi-start uses seed + k
+        bool _useMultilevel; ///< Whether to coarsen the netlist and refine the placement level by level
+        std::string _nlpCheckpointFile; ///< The file of the global placement checkpoints
+        IndexType _nlpCheckpointInterval; ///< The number of outer iterations between two checkpoints
+        std::string _nlpResumeFile; ///< The checkpoint to resume the global placement from
+        RealType _nlpTimeBudgetMs; ///< The wall-clock budget of a global placement run
+        std::string _nlpTraceFile; ///< The file of the convergence trace
+        IndexType _nlpTraceCapacity; ///< The number of trace records to keep
         LocType _gridStep;
         LocType _virtualBoundaryExtension; ///< The extension of current virtual boundary to the bounding box of placement
         LocType _virtualPinInterval; ///< The interval between each virtual pin
+        LocType _virtualPinMoveThreshold; ///< The displacement of cells or the virtual boundary below which the virtual pin assignment is kept
         LocType _layoutOffset; ///< The default offset for the placement
         RealType _defaultAspectRatio; ///< The defaut aspect ratio for global placement
         RealType _maxWhiteSpace; ///< The default maximum white space target
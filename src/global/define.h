@@ -26,6 +26,4 @@
 
 //#define IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
 
-#define IDEAPLACE_DEFAULT_MAX_NUM_CELLS 100
-
 #endif /// IDEAPLACE_DEFINE_H
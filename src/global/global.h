@@ -29,6 +29,7 @@ static const auto &WATCH_QUICK_START = klib::StopWatchMgr::quickStart;
 static const auto &WATCH_QUICK_END = klib::StopWatchMgr::quickEnd;
 static const auto &WATCH_CREATE_NEW = klib::StopWatchMgr::createNewStopWatch;;
 static const auto &WATCH_LOOK_RECORD_TIME = klib::StopWatchMgr::time;
+static const auto &WATCH_EXISTS = klib::StopWatchMgr::hasWatch;
 
 PROJECT_NAMESPACE_END
 
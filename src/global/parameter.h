@@ -28,6 +28,7 @@ constexpr RealType NLP_WN_CONJ_EPISLON = 200 / NLP_WN_CONJ_DEFAULT_MAX_ITER ;
 constexpr RealType NLP_WN_CONJ_DEFAULT_MAX_WHITE_SPACE = 2; ///< The default extra white space for setting the boundry
 constexpr RealType NLP_WN_MAX_PENALTY = 1024;
 constexpr RealType NLP_WN_REDUCE_PENALTY = 512 / NLP_WN_MAX_PENALTY ;
+constexpr IndexType NLP_DENSITY_OVERLAP_MIN_NUM_CELLS = 1000; ///< The minimum number of cells for using the electrostatic density instead of the pair-wise overlapping penalty
 
 PROJECT_NAMESPACE_END
 
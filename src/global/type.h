@@ -64,6 +64,29 @@ enum class Direction2DType
     NORTH  = 3,
     NONE = 4
 };
+
+/// @brief How the operator tasks of the global placement are run in parallel
+enum class NlpExecutorType
+{
+    PER_FAMILY = 0, ///< One parallel region for each family of operators
+    PERSISTENT_REGION = 1 ///< One parallel region for all the families, without barriers between the independent ones
+};
+
+/// @brief The first-order optimization kernel of the global placement
+enum class NlpOptimizerType
+{
+    ADAM = 0, ///< Adam, warmed up with plain gradient steps
+    ADAM_BARZILAI_BORWEIN = 1, ///< Adam, warmed up with Barzilai-Borwein gradient steps
+    NESTEROV_ARMIJO = 2 ///< Nesterov with Armijo backtracking and adaptive momentum restart
+};
+
+/// @brief The numerical precision of the global placement
+enum class NlpPrecisionType
+{
+    DOUBLE = 0, ///< Everything in double precision
+    MIXED = 1, ///< The variables and the optimizer states in double precision. The operators evaluated in single precision
+    FLOAT = 2 ///< Everything in single precision. Experimental: changes the converged placement
+};
 PROJECT_NAMESPACE_END
 
 #endif // AROUTER_TYPE_H_
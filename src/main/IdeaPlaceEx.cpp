@@ -12,12 +12,182 @@
 /* Placement */
 #include "pinassign/VirtualPinAssigner.h"
 #include "place/ProximityMgr.h"
+#include "place/NlpMultilevelGPlacer.h"
 /* Post-Processing */
 #include "place/alignGrid.h"
+#include <algorithm>
 #include <omp.h>
+#include <thread>
 
 PROJECT_NAMESPACE_BEGIN
 
+/// @brief run the global placement with a setting
+template<typename nlp_settings>
+static void runNlpGlobalPlacement(Database &db, nlp::profile::Profile *profile, nlp::MultiStartMonitor *monitor, IndexType runIdx, bool warmStart)
+{
+    if (warmStart)
+    {
+        NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp_settings>> placer(db);
+        placer.setMultiStartMonitor(monitor, runIdx);
+        placer.setProfile(profile);
+        placer.solve();
+        return;
+    }
+    if (db.parameters().useMultilevel())
+    {
+        NlpMultilevelGPlacer<nlp_settings> placer(db);
+        placer.setMultiStartMonitor(monitor, runIdx);
+        placer.setProfile(profile);
+        placer.solve();
+        return;
+    }
+    NlpGPlacerFirstOrder<nlp_settings> placer(db);
+    placer.setMultiStartMonitor(monitor, runIdx);
+    placer.setProfile(profile);
+    placer.solve();
+}
+
+/// @brief run the global placement with the first-order kernel selected by the parameters
+template<typename nlp_settings>
+static void runNlpGlobalPlacementWithOptimizer(Database &db, nlp::profile::Profile *profile, nlp::MultiStartMonitor *monitor, IndexType runIdx, bool warmStart)
+{
+    switch (db.parameters().nlpOptimizerType())
+    {
+        case NlpOptimizerType::ADAM_BARZILAI_BORWEIN:
+            runNlpGlobalPlacement<nlp::nlp_adam_bb_settings<nlp_settings>>(db, profile, monitor, runIdx, warmStart);
+            break;
+        case NlpOptimizerType::NESTEROV_ARMIJO:
+            runNlpGlobalPlacement<nlp::nlp_nesterov_armijo_settings<nlp_settings>>(db, profile, monitor, runIdx, warmStart);
+            break;
+        default:
+            runNlpGlobalPlacement<nlp_settings>(db, profile, monitor, runIdx, warmStart);
+            break;
+    }
+}
+
+/// @brief run the global placement with the settings selected by the parameters
+/// @param the database
+/// @param the profile the counters of the run are added to. Not shared by concurrent runs
+/// @param the monitor shared by the runs of a multi-start. nullptr if running alone
+/// @param the index of the run in the multi-start
+/// @param whether to start from the placement in the database
+static void runGlobalPlacement(Database &db, nlp::profile::Profile *profile, nlp::MultiStartMonitor *monitor = nullptr, IndexType runIdx = 0, bool warmStart = false)
+{
+    const bool useDensity = db.numCells() >= NLP_DENSITY_OVERLAP_MIN_NUM_CELLS;
+    // The single- and mixed-precision settings are with the adam kernel only
+    NlpPrecisionType precisionType = db.parameters().nlpPrecisionType();
+    if (precisionType != NlpPrecisionType::DOUBLE and db.parameters().nlpOptimizerType() != NlpOptimizerType::ADAM)
+    {
+        WRN("Ideaplace: the global placement precision applies to the adam kernel only. Run in double \n");
+        precisionType = NlpPrecisionType::DOUBLE;
+    }
+    switch (precisionType)
+    {
+        case NlpPrecisionType::MIXED:
+            if (useDensity) { runNlpGlobalPlacement<nlp::nlp_mixed_density_settings>(db, profile, monitor, runIdx, warmStart); }
+            else { runNlpGlobalPlacement<nlp::nlp_mixed_settings>(db, profile, monitor, runIdx, warmStart); }
+            break;
+        case NlpPrecisionType::FLOAT:
+            if (useDensity) { runNlpGlobalPlacement<nlp::nlp_float_density_settings>(db, profile, monitor, runIdx, warmStart); }
+            else { runNlpGlobalPlacement<nlp::nlp_float_settings>(db, profile, monitor, runIdx, warmStart); }
+            break;
+        default:
+            if (useDensity) { runNlpGlobalPlacementWithOptimizer<nlp::nlp_density_settings>(db, profile, monitor, runIdx, warmStart); }
+            else { runNlpGlobalPlacementWithOptimizer<nlp::nlp_default_settings>(db, profile, monitor, runIdx, warmStart); }
+            break;
+    }
+}
+
+/// @brief run the global placement from several seeds concurrently, legalize them and keep the best
+/// @param the database
+/// @param the time budget of the whole placement. Once it runs out, the remaining runs are not legalized if there is a legal one already
+/// @param the profile the counters of all the runs are added to
+/// @return whether the kept result is legal
+static bool runMultiStartPlacement(Database &db, const nlp::TimeBudget &budget, nlp::profile::Profile &profile)
+{
+    const IndexType numRuns = db.parameters().numMultiStarts();
+    const IndexType numThreadsPerRun = std::max(db.parameters().numThreads() / numRuns, static_cast<IndexType>(1));
+    INF("Ideaplace: multi-start with %d runs, %d threads each \n", numRuns, numThreadsPerRun);
+    nlp::MultiStartMonitor monitor(numRuns);
+    std::vector<Database> runDbs(numRuns, db);
+    std::vector<nlp::profile::Profile> runProfiles(numRuns);
+    std::vector<std::thread> threads;
+    for (IndexType runIdx = 0; runIdx < numRuns; ++runIdx)
+    {
+        auto &params = runDbs[runIdx].parameters();
+        params.setNlpInitSeed(db.parameters().nlpInitSeed() + runIdx);
+        // The operators are sliced by the number of threads
+        params.setNumThreads(numThreadsPerRun);
+        // Each run has its own checkpoints and trace
+        if (not params.nlpCheckpointFile().empty())
+        {
+            params.setNlpCheckpoint(params.nlpCheckpointFile() + "." + std::to_string(runIdx), params.nlpCheckpointInterval());
+        }
+        if (not params.nlpResumeFile().empty())
+        {
+            params.setNlpResumeFile(params.nlpResumeFile() + "." + std::to_string(runIdx));
+        }
+        if (not params.nlpTraceFile().empty())
+        {
+            params.setNlpTrace(params.nlpTraceFile() + "." + std::to_string(runIdx), params.nlpTraceCapacity());
+        }
+        threads.emplace_back([&, runIdx]()
+        {
+            omp_set_num_threads(numThreadsPerRun);
+            runGlobalPlacement(runDbs[runIdx], &runProfiles[runIdx], &monitor, runIdx);
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    // The cancelled runs are counted as well, since they took their share of the time
+    for (const auto &runProfile : runProfiles)
+    {
+        profile.merge(runProfile);
+    }
+    // Legalize the runs with better global placement first, in case the budget runs out
+    std::vector<IndexType> runOrder;
+    std::vector<LocType> gpHpwls(numRuns, LOC_TYPE_MAX);
+    for (IndexType runIdx = 0; runIdx < numRuns; ++runIdx)
+    {
+        if (monitor.cancelled(runIdx))
+        {
+            INF("Ideaplace: multi-start run %d cancelled \n", runIdx);
+            continue;
+        }
+        gpHpwls[runIdx] = runDbs[runIdx].hpwl();
+        runOrder.emplace_back(runIdx);
+    }
+    std::stable_sort(runOrder.begin(), runOrder.end(), [&](IndexType lhs, IndexType rhs) { return gpHpwls[lhs] < gpHpwls[rhs]; });
+    IndexType bestIdx = INDEX_TYPE_MAX;
+    bool bestLegal = false;
+    LocType bestHpwl = LOC_TYPE_MAX;
+    for (IndexType runIdx : runOrder)
+    {
+        if (bestLegal and budget.expired())
+        {
+            INF("Ideaplace: out of the time budget. Skip legalizing multi-start run %d \n", runIdx);
+            continue;
+        }
+        CGLegalizer legalizer(runDbs[runIdx]);
+        const bool legal = legalizer.legalize();
+        const LocType hpwl = runDbs[runIdx].hpwl();
+        INF("Ideaplace: multi-start run %d legal %d HPWL %d \n", runIdx, legal, hpwl);
+        if (bestIdx == INDEX_TYPE_MAX or (legal and not bestLegal) or (legal == bestLegal and hpwl < bestHpwl))
+        {
+            bestIdx = runIdx;
+            bestLegal = legal;
+            bestHpwl = hpwl;
+        }
+    }
+    AssertMsg(bestIdx != INDEX_TYPE_MAX, "Ideaplace: all the multi-start runs are cancelled \n");
+    INF("Ideaplace: keep multi-start run %d \n", bestIdx);
+    const Parameters parameters = db.parameters();
+    db = std::move(runDbs[bestIdx]);
+    db.parameters() = parameters;
+    return bestLegal;
+}
 
 void IdeaPlaceEx::readTechSimpleFile(const std::string &techsimple)
 {
@@ -141,27 +311,17 @@ bool IdeaPlaceEx::parseFileBased(int argc, char **argv)
     return true;
 }
 
-LocType IdeaPlaceEx::solve(LocType gridStep)
+LocType IdeaPlaceEx::solve(LocType gridStep, RealType timeBudgetMs)
 {
-    auto stopWatch = WATCH_CREATE_NEW("IdeaPlaceEx");
+    auto stopWatch = WATCH_CREATE_NEW(_db.stopWatchName("IdeaPlaceEx"));
     stopWatch->start();
+    nlp::TimeBudget budget;
+    budget.start(timeBudgetMs);
     omp_set_num_threads(_db.parameters().numThreads());
     // Start message printer timer
     MsgPrinter::startTimer();
-    // Solve cleaning up tasks for safe...
-    for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
-    {
-        _db.cell(cellIdx).calculateCellBBox();
-#ifdef DEBUG_GR
-        DBG("cell %d %s bbox %s \n", cellIdx, _db.cell(cellIdx).name().c_str(), _db.cell(cellIdx).cellBBox().toStr().c_str());
-#endif
-    }
-
-    if (gridStep > 0)
-    {
-        _db.parameters().setGridStep(gridStep);
-        _db.expandCellToGridSize(gridStep);
-    }
+    _gpProfile = nlp::profile::Profile();
+    prepareCells(gridStep);
 
     // Set proximity group
     ProximityMgr proximityMgr(_db);
@@ -172,16 +332,134 @@ LocType IdeaPlaceEx::solve(LocType gridStep)
 
     INF("Ideaplace: Entering global placement...\n");
 
-    NlpGPlacerFirstOrder<nlp::nlp_default_settings> placer(_db);
-    placer.solve();
+    const RealType nlpTimeBudgetMs = _db.parameters().nlpTimeBudgetMs();
+    if (budget.enabled())
+    {
+        const RealType gpBudgetMs = std::max(globalPlacementBudgetShare * timeBudgetMs - budget.elapsedMs(), 1.0);
+        INF("Ideaplace: time budget %f ms, %f ms for the global placement \n", timeBudgetMs, gpBudgetMs);
+        _db.parameters().setNlpTimeBudgetMs(gpBudgetMs);
+    }
+
+    bool legalizeResult = false;
+    if (_db.parameters().numMultiStarts() > 1)
+    {
+        legalizeResult = runMultiStartPlacement(_db, budget, _gpProfile);
+    }
+    else
+    {
+        runGlobalPlacement(_db, &_gpProfile);
 #ifdef DEBUG_GR
 #ifdef DEBUG_DRAW
-    _db.drawCellBlocks("./debug/after_gr.gds");
+        _db.drawCellBlocks("./debug/after_gr.gds");
 #endif //DEBUG_DRAW
 #endif
+        INF("Ideaplace: Entering legalization and detailed placement...\n");
+        CGLegalizer legalizer(_db);
+        legalizeResult = legalizer.legalize();
+    }
+    _db.parameters().setNlpTimeBudgetMs(nlpTimeBudgetMs);
+    const LocType symAxis = finishPlacement(proximityMgr, gridStep);
+    if (budget.expired())
+    {
+        WRN("Ideaplace: exceeded the time budget by %f ms \n", -budget.remainingMs());
+    }
+
+    stopWatch->stop();
+
+    return symAxis;
+}
+
+LocType IdeaPlaceEx::solveIncremental(const std::vector<IndexType> &changedCells, bool fixUnchanged, LocType gridStep)
+{
+    auto stopWatch = WATCH_CREATE_NEW(_db.stopWatchName("IdeaPlaceExIncremental"));
+    stopWatch->start();
+    omp_set_num_threads(_db.parameters().numThreads());
+    MsgPrinter::startTimer();
+    _gpProfile = nlp::profile::Profile();
+    prepareCells(gridStep);
+
+    std::vector<bool> isChanged(_db.numCells(), false);
+    for (IndexType cellIdx : changedCells)
+    {
+        AssertMsg(cellIdx < _db.numCells(), "Ideaplace: incremental placement: cell %d does not exist \n", cellIdx);
+        isChanged.at(cellIdx) = true;
+    }
+    // The global placement and the legalization keep the fixed cells in place relative to each other. Remember one of them to restore the absolute locations
+    IndexType refCellIdx = INDEX_TYPE_MAX;
+    IndexType numFixed = 0;
+    for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+    {
+        const bool fixed = fixUnchanged and not isChanged[cellIdx];
+        _db.cell(cellIdx).setFixed(fixed);
+        if (fixed)
+        {
+            ++numFixed;
+            if (refCellIdx == INDEX_TYPE_MAX)
+            {
+                refCellIdx = cellIdx;
+            }
+        }
+    }
+    const XY<LocType> refLoc = refCellIdx != INDEX_TYPE_MAX ? _db.cell(refCellIdx).loc() : XY<LocType>(0, 0);
+    INF("Ideaplace: incremental placement with %d changed cells, %d fixed \n", changedCells.size(), numFixed);
+
+    ProximityMgr proximityMgr(_db);
+    proximityMgr.applyProximityWithDummyNets();
+    _db.splitSignalPathsBySymPairs();
+
+    auto restoreFixedCells = [&]()
+    {
+        if (refCellIdx == INDEX_TYPE_MAX)
+        {
+            return;
+        }
+        const XY<LocType> shift = refLoc - _db.cell(refCellIdx).loc();
+        for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+        {
+            auto &cell = _db.cell(cellIdx);
+            cell.setXLoc(cell.xLoc() + shift.x());
+            cell.setYLoc(cell.yLoc() + shift.y());
+        }
+    };
+
+    INF("Ideaplace: Entering incremental global placement...\n");
+    runGlobalPlacement(_db, &_gpProfile, nullptr, 0, true);
+    restoreFixedCells();
     INF("Ideaplace: Entering legalization and detailed placement...\n");
     CGLegalizer legalizer(_db);
-    bool legalizeResult = legalizer.legalize();
+    legalizer.legalize();
+    restoreFixedCells();
+    for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+    {
+        _db.cell(cellIdx).setFixed(false);
+    }
+    const LocType symAxis = finishPlacement(proximityMgr, gridStep);
+
+    stopWatch->stop();
+
+    return symAxis;
+}
+
+void IdeaPlaceEx::prepareCells(LocType gridStep)
+{
+    // Solve cleaning up tasks for safe...
+    for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+    {
+        _db.cell(cellIdx).calculateCellBBox();
+#ifdef DEBUG_GR
+        DBG("cell %d %s bbox %s \n", cellIdx, _db.cell(cellIdx).name().c_str(), _db.cell(cellIdx).cellBBox().toStr().c_str());
+#endif
+    }
+
+    if (gridStep > 0)
+    {
+        _db.parameters().setGridStep(gridStep);
+        _db.expandCellToGridSize(gridStep);
+    }
+}
+
+LocType IdeaPlaceEx::finishPlacement(ProximityMgr &proximityMgr, LocType gridStep)
+{
     INF("Ideaplace: Assigning IO pin...\n");
     VirtualPinAssigner pinAssigner(_db);
     pinAssigner.solveFromDB();
@@ -245,8 +523,6 @@ LocType IdeaPlaceEx::solve(LocType gridStep)
 #endif //DEBUG_DRAW
 #endif
 
-    stopWatch->stop();
-
     return symAxis;
 }
 
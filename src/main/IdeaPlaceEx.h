@@ -12,6 +12,7 @@
 /* Solver */
 #include "place/CGLegalizer.h"
 #include "place/NlpGPlacer.h"
+#include "place/ProximityMgr.h"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -21,6 +22,7 @@ PROJECT_NAMESPACE_BEGIN
 class IdeaPlaceEx
 {
     public:
+        static constexpr RealType globalPlacementBudgetShare = 0.7; ///< The share of the time budget of solve() for the global placement. The rest is for the legalization and the alignment, which run to the end
         /// @brief default constructor
         explicit IdeaPlaceEx() = default;
         /// @brief the file-based input
@@ -28,8 +30,27 @@ class IdeaPlaceEx
         /// @return if the parsing is successful
         bool parseFileBased(int argc, char** argv);
         /// @brief run the placement algorithm
+        /// @param the grid step. Negative if there is no grid
+        /// @param the wall-clock budget in millisecond. Not positive for no limit. The global placement stops early to fit in it
         /// @return whether the placement is successful
-        LocType solve(LocType gridSize = -1);
+        LocType solve(LocType gridSize = -1, RealType timeBudgetMs = 0);
+        /// @brief re-run the placement after small edits, starting from the current placement
+        /// @param the indices of the changed cells
+        /// @param whether to keep the other cells in place through the global placement and the legalization. The final grid alignment may still snap them by less than a grid step
+        /// @param the grid step. Same as solve()
+        /// @return the symmetric axis. Same as solve()
+        LocType solveIncremental(const std::vector<IndexType> &changedCells, bool fixUnchanged = true, LocType gridSize = -1);
+        /// @brief run the placement with the global placement resumed from a checkpoint
+        /// @param the checkpoint file. With multi-start, run k resumes from file.k
+        /// @param the grid step. Same as solve()
+        /// @return the symmetric axis. Same as solve()
+        LocType solveFromCheckpoint(const std::string &filename, LocType gridSize = -1)
+        {
+            _db.parameters().setNlpResumeFile(filename);
+            const LocType symAxis = solve(gridSize);
+            _db.parameters().setNlpResumeFile("");
+            return symAxis;
+        }
         /// @brief the file-based output
         /// @param the system arguments
         /// @return if the writing is successful
@@ -69,8 +90,34 @@ class IdeaPlaceEx
         /* paramters                    */
         /*------------------------------*/ 
         void setNumThreads(IndexType numThreads);
+        /// @brief set how the operator tasks of the global placement are run in parallel
+        /// @param 0: one parallel region for each family of operators. 1: one persistent parallel region for all of them
+        void setNlpExecutor(IndexType executorType) { _db.parameters().setNlpExecutorType(static_cast<NlpExecutorType>(executorType)); }
+        /// @brief set the first-order optimization kernel of the global placement
+        /// @param 0: adam. 1: adam with Barzilai-Borwein warm-up. 2: nesterov with Armijo backtracking
+        void setNlpOptimizer(IndexType optimizerType) { _db.parameters().setNlpOptimizerType(static_cast<NlpOptimizerType>(optimizerType)); }
+        /// @brief set the numerical precision of the global placement. Applies to the adam kernel, the others run in double
+        /// @param 0: double. 1: mixed, the operators in float and the rest in double, within 1e-5 of the double HPWL.
+        /// 2: float. Experimental, the converged HPWL differs from double by up to 17% either way
+        void setNlpPrecision(IndexType precisionType) { _db.parameters().setNlpPrecisionType(static_cast<NlpPrecisionType>(precisionType)); }
+        /// @brief set the number of global placement runs started concurrently with different seeds. The threads are split among them
+        void setNumMultiStarts(IndexType numMultiStarts) { _db.parameters().setNumMultiStarts(numMultiStarts); }
+        /// @brief set the seed of the random initial placement
+        void setInitSeed(IndexType seed) { _db.parameters().setNlpInitSeed(seed); }
+        /// @brief set whether to cluster the netlist and run the global placement from the coarsest level to the original one
+        void setUseMultilevel(bool useMultilevel) { _db.parameters().setUseMultilevel(useMultilevel); }
+        /// @brief save the global placement state every a number of outer iterations. With multi-start, run k saves to file.k
+        /// @param the file name. Empty to disable
+        /// @param the number of outer iterations between two checkpoints
+        void setCheckpoint(const std::string &filename, IndexType interval) { _db.parameters().setNlpCheckpoint(filename, interval); }
+        /// @brief record the objectives, the gradient norm, the multipliers and alpha of each iteration of the global placement. With multi-start, run k writes to file.k
+        /// @param the file name. Written as CSV if it ends with .csv, binary otherwise. Empty to disable
+        /// @param the number of records to keep. The latest ones are kept in a longer run
+        void setTrace(const std::string &filename, IndexType capacity) { _db.parameters().setNlpTrace(filename, capacity); }
         void setIoPinBoundaryExtension(LocType ext) { _db.parameters().setVirtualBoundaryExtension(ext); }
         void setIoPinInterval(LocType interval) { _db.parameters().setVirtualPinInterval(interval); }
+        /// @brief set how far the cells need to move for the io pins to be reassigned during the global placement. 0 to reassign after any move
+        void setIoPinMoveThreshold(LocType threshold) { _db.parameters().setVirtualPinMoveThreshold(threshold); }
         /*------------------------------*/ 
         /* tech input interface         */
         /*------------------------------*/ 
@@ -292,64 +339,105 @@ class IdeaPlaceEx
             return _db.cell(cellIdx).pinIdx(pinCellIdx); 
         }
         /* Run time */
+        /* The times are of this placer only, also when several placers run concurrently. 0 for a phase the placer has not run.
+         * With multi-start, the global placement watches are named by run, so their getters are 0 */
         /// @brief get the total run time
         /// @return time in us
         decltype(auto) runtimeIdeaPlaceEx()
         {
-            return WATCH_LOOK_RECORD_TIME("IdeaPlaceEx");
+            return runtimeOf("IdeaPlaceEx");
         }
         /// @brief get the the run time for global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlace()
         {
-            return WATCH_LOOK_RECORD_TIME("NlpGPlacer");
+            return runtimeOf("NlpGPlacer");
         }
         /// @brief get the the run time for calculating objectives in global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlaceCalcObj()
         {
-            return WATCH_LOOK_RECORD_TIME("GP_calculate_obj");
+            return runtimeOf("GP_calculate_obj");
         }
         /// @brief get the the run time for calculating gradients in global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlaceCalcGrad()
         {
-            return WATCH_LOOK_RECORD_TIME("GP_calculate_gradient");
+            return runtimeOf("GP_calculate_gradient");
         }
         /// @brief get the the run time for the optimization kernel in global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlaceOptmKernel()
         {
-            return WATCH_LOOK_RECORD_TIME("GP_optimizer_kernel");
+            return runtimeOf("GP_optimizer_kernel");
         }
         /// @brief get the the run time for the optimization kernel in global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlaceOptimize()
         {
-            return WATCH_LOOK_RECORD_TIME("GP_optimize");
+            return runtimeOf("GP_optimize");
         }
         /// @brief get the the run time for updating the problem (e.g. multipliers) in global placement
         /// @return time in us
         decltype(auto) runtimeGlobalPlaceUpdateProblem()
         {
-            return WATCH_LOOK_RECORD_TIME("GP_update_problem");
+            return runtimeOf("GP_update_problem");
         }
         /// @brief get the the run time for legalization
         /// @return time in us
         decltype(auto) runtimeLegalization()
         {
-            return WATCH_LOOK_RECORD_TIME("legalization");
+            return runtimeOf("legalization");
         }
         /// @brief get the the run time for detailed placement
         /// @return time in us
         decltype(auto) runtimeDetailedPlacement()
         {
-            return WATCH_LOOK_RECORD_TIME("detailedPlacement");
+            return runtimeOf("detailedPlacement");
+        }
+        /* Profiling */
+        /// @brief get the counters of each operator family in the global placement of the last solve.
+        /// The last solve is the last solve() or solveIncremental() of this placer, and includes all the runs of a multi-start and all the levels of a multilevel placement
+        /// @return family -> {numEvals, numOps, ns, nsPerOp, scatterNs}. The times are in ns and summed over the threads
+        std::map<std::string, std::map<std::string, RealType>> profileGlobalPlacement() const
+        {
+            return _gpProfile.toMap();
+        }
+        /// @brief get the number of gradient evaluations in each outer iteration of the global placement of the last solve
+        std::vector<IndexType> profileInnerIterations() const
+        {
+            return _gpProfile.innerIters;
         }
+        /// @brief write the profile of the global placement of the last solve as JSON
+        /// @return whether the file is written successfully
+        bool dumpProfile(const std::string &filename) const
+        {
+            return _gpProfile.writeJson(filename);
+        }
+        /// @brief get the profile of the global placement of the last solve, e.g. to merge the profiles of several placers
+        const nlp::profile::Profile &globalPlacementProfile() const { return _gpProfile; }
 
 
+    protected:
+        /// @brief calculate the cell bounding boxes and expand them to the grid
+        void prepareCells(LocType gridStep);
+        /// @brief assign the io pins, restore the proximity groups, and align the legalized placement to the grid
+        /// @return the symmetric axis
+        LocType finishPlacement(ProximityMgr &proximityMgr, LocType gridStep);
+        /// @brief get the time of a stop watch of this placer
+        /// @return time in us. 0 if the watch has not been created
+        std::uint64_t runtimeOf(const std::string &name) const
+        {
+            const std::string watchName = _db.stopWatchName(name);
+            if (not WATCH_EXISTS(watchName))
+            {
+                return 0;
+            }
+            return WATCH_LOOK_RECORD_TIME(std::string(watchName));
+        }
     protected:
         Database _db; ///< The placement engine database 
+        nlp::profile::Profile _gpProfile; ///< The profile of the global placement of the last solve. Owned by this placer, so that concurrent placers do not share it
 };
 
 PROJECT_NAMESPACE_END
@@ -0,0 +1,73 @@
+#include "IdeaPlaceExBatch.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+PROJECT_NAMESPACE_BEGIN
+
+IndexType IdeaPlaceExBatch::numThreadsOf(IndexType jobIdx) const
+{
+    const IndexType numCells = _jobs.at(jobIdx).placer->numCells();
+    const IndexType numThreads = (numCells + numCellsPerThread - 1) / numCellsPerThread;
+    return std::max(std::min(numThreads, _numThreads), static_cast<IndexType>(1));
+}
+
+std::vector<LocType> IdeaPlaceExBatch::solve()
+{
+    const IndexType numJobs = _jobs.size();
+    std::vector<LocType> symAxes(numJobs, LOC_TYPE_MIN);
+    // The larger problems first
+    std::vector<IndexType> order(numJobs);
+    std::vector<IndexType> numThreads(numJobs);
+    for (IndexType jobIdx = 0; jobIdx < numJobs; ++jobIdx)
+    {
+        order[jobIdx] = jobIdx;
+        numThreads[jobIdx] = numThreadsOf(jobIdx);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](IndexType lhs, IndexType rhs)
+    {
+        return _jobs[lhs].placer->numCells() > _jobs[rhs].placer->numCells();
+    });
+    INF("Ideaplace: batch of %d problems on %d threads \n", numJobs, _numThreads);
+
+    // Start a problem once there are enough free threads for it
+    std::mutex mutex;
+    std::condition_variable freed;
+    IndexType numFreeThreads = _numThreads;
+    std::vector<std::thread> threads;
+    threads.reserve(numJobs);
+    for (IndexType jobIdx : order)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            freed.wait(lock, [&]() { return numFreeThreads >= numThreads[jobIdx]; });
+            numFreeThreads -= numThreads[jobIdx];
+        }
+        threads.emplace_back([&, jobIdx]()
+        {
+            // Sets the threads of the problem and of this thread only
+            const auto &job = _jobs[jobIdx];
+            job.placer->setNumThreads(numThreads[jobIdx]);
+            symAxes[jobIdx] = job.placer->solve(job.gridStep, job.timeBudgetMs);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                numFreeThreads += numThreads[jobIdx];
+            }
+            freed.notify_one();
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    // In the order the problems are added
+    _profile = nlp::profile::Profile();
+    for (const auto &job : _jobs)
+    {
+        _profile.merge(job.placer->globalPlacementProfile());
+    }
+    return symAxes;
+}
+
+PROJECT_NAMESPACE_END
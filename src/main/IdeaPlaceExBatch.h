@@ -0,0 +1,81 @@
+/**
+ * @file IdeaPlaceExBatch.h
+ * @brief Placing many independent circuits concurrently
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#ifndef IDEAPLACE_IDEAPLACEEXBATCH_H_
+#define IDEAPLACE_IDEAPLACEEXBATCH_H_
+
+#include "main/IdeaPlaceEx.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+/// @class IDEAPLACE::IdeaPlaceExBatch
+/// @brief solve a batch of placement problems in one process. The problems share a pool of threads.
+/// @details The larger problems are started first, so the long ones do not trail at the end. A problem is given threads by its size:
+/// the small ones run on one thread each, side by side, and the large ones on several.
+/// The placers are not owned, are added at most once and must live until solve() returns. Each keeps its result and its own global placement profile, queried as usual.
+/// The batch merges the profiles of its placers after solve()
+class IdeaPlaceExBatch
+{
+    public:
+        static constexpr IndexType numCellsPerThread = 64; ///< A problem is given one thread for each of this many cells
+        /// @brief default constructor
+        explicit IdeaPlaceExBatch() = default;
+        /// @brief add a problem
+        /// @param the placer with the problem read in
+        /// @param the grid step. Same as IdeaPlaceEx::solve()
+        /// @param the wall-clock budget of the problem in millisecond. Same as IdeaPlaceEx::solve()
+        /// @return the index of the problem in the batch. INDEX_TYPE_MAX if the placer is already in the batch, and it is not added again
+        IndexType addPlacer(IdeaPlaceEx &placer, LocType gridStep = -1, RealType timeBudgetMs = 0)
+        {
+            // The same placer twice would be solved by two threads at once
+            for (const auto &job : _jobs)
+            {
+                if (job.placer == &placer)
+                {
+                    ERR("IdeaPlaceExBatch::%s the placer is already in the batch \n", __FUNCTION__);
+                    return INDEX_TYPE_MAX;
+                }
+            }
+            _jobs.emplace_back(Job{ &placer, gridStep, timeBudgetMs });
+            return _jobs.size() - 1;
+        }
+        /// @brief get the number of problems
+        IndexType numPlacers() const { return _jobs.size(); }
+        /// @brief remove all the problems
+        void clear() { _jobs.clear(); }
+        /// @brief set the total number of threads of the batch
+        void setNumThreads(IndexType numThreads) { _numThreads = std::max(numThreads, static_cast<IndexType>(1)); }
+        /// @brief get the number of threads a problem is given
+        /// @param the index of the problem
+        IndexType numThreadsOf(IndexType jobIdx) const;
+        /// @brief solve all the problems
+        /// @return the symmetric axis of each problem, in the order they are added
+        std::vector<LocType> solve();
+        /* Profiling */
+        /// @brief get the counters of each operator family in the global placement of all the problems of the last solve()
+        /// @return family -> {numEvals, numOps, ns, nsPerOp, scatterNs}. The times are in ns and summed over the threads
+        std::map<std::string, std::map<std::string, RealType>> profileGlobalPlacement() const { return _profile.toMap(); }
+        /// @brief write the merged profile of the last solve() as JSON
+        /// @return whether the file is written successfully
+        bool dumpProfile(const std::string &filename) const { return _profile.writeJson(filename); }
+        /// @brief get the merged profile of the last solve()
+        const nlp::profile::Profile &globalPlacementProfile() const { return _profile; }
+    private:
+        struct Job
+        {
+            IdeaPlaceEx *placer;
+            LocType gridStep;
+            RealType timeBudgetMs;
+        };
+        std::vector<Job> _jobs; ///< The problems
+        IndexType _numThreads = 10; ///< The total number of threads
+        nlp::profile::Profile _profile; ///< The profiles of the placers merged after the last solve()
+};
+
+PROJECT_NAMESPACE_END
+
+#endif //IDEAPLACE_IDEAPLACEEXBATCH_H_
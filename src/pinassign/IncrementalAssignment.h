@@ -0,0 +1,209 @@
+/**
+ * @file IncrementalAssignment.h
+ * @brief A min-cost assignment solver that keeps its dual solution between the solves
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#ifndef IDEAPLACE_INCREMENTAL_ASSIGNMENT_H_
+#define IDEAPLACE_INCREMENTAL_ASSIGNMENT_H_
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "global/global.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+/// @class IDEAPLACE::IncrementalAssignment
+/// @brief Assign each row to a distinct column with the minimum total cost, by the shortest augmenting paths with potentials.
+/// @details The problem is made square by dummy rows of zero cost, so that any column may be left unused.
+/// The potentials and the matching are kept after a solve. When the costs of some rows or columns change, only those are unmatched
+/// and their potentials repaired, and only the unmatched rows are augmented again. The other pairs stay optimal for the reduced costs,
+/// so a solve after a few changes costs a few augmentations instead of the whole problem
+class IncrementalAssignment
+{
+    public:
+        typedef std::int64_t cost_type;
+        static constexpr cost_type INF = std::numeric_limits<cost_type>::max() / 4;
+        /// @brief reset to a new problem. All costs are zero and nothing is matched
+        /// @param the number of rows
+        /// @param the number of columns. Must not be less than the number of rows
+        void init(IndexType numRows, IndexType numCols)
+        {
+            Assert(numRows <= numCols);
+            _numRows = numRows;
+            _numCols = numCols;
+            _cost.assign(static_cast<std::size_t>(numRows) * numCols, 0);
+            _u.assign(numCols + 1, 0);
+            _v.assign(numCols + 1, 0);
+            _p.assign(numCols + 1, 0);
+            _rowCol.assign(numCols + 1, 0);
+            _way.assign(numCols + 1, 0);
+            _minv.assign(numCols + 1, 0);
+            _used.assign(numCols + 1, 0);
+            _dirtyRow.assign(numRows, 0);
+            _dirtyCol.assign(numCols, 0);
+            _dirtyRows.clear();
+            _dirtyCols.clear();
+            _numAugments = 0;
+        }
+        IndexType numRows() const { return _numRows; }
+        IndexType numCols() const { return _numCols; }
+        /// @brief set a cost. The row or the column must be marked dirty before the next solve if it has been solved
+        void setCost(IndexType row, IndexType col, cost_type cost) { _cost[static_cast<std::size_t>(row) * _numCols + col] = cost; }
+        cost_type cost(IndexType row, IndexType col) const { return _cost[static_cast<std::size_t>(row) * _numCols + col]; }
+        /// @brief mark that the costs of a row have changed
+        void markRowDirty(IndexType row)
+        {
+            if (not _dirtyRow[row])
+            {
+                _dirtyRow[row] = 1;
+                _dirtyRows.emplace_back(row);
+            }
+        }
+        /// @brief mark that the costs of a column have changed
+        void markColDirty(IndexType col)
+        {
+            if (not _dirtyCol[col])
+            {
+                _dirtyCol[col] = 1;
+                _dirtyCols.emplace_back(col);
+            }
+        }
+        /// @brief solve the problem from the last solution
+        void solve()
+        {
+            // Unmatch the changed rows and columns
+            for (IndexType row : _dirtyRows)
+            {
+                unmatchRow(row + 1);
+            }
+            for (IndexType col : _dirtyCols)
+            {
+                if (_p[col + 1] != 0)
+                {
+                    unmatchRow(_p[col + 1]);
+                }
+            }
+            // Repair the feasibility of the potentials. The columns first with the old row potentials, then the rows with all the columns.
+            // The potentials of the matched pairs are untouched, so they stay tight
+            for (IndexType col : _dirtyCols)
+            {
+                cost_type minv = INF;
+                for (IndexType i = 1; i <= _numCols; ++i)
+                {
+                    minv = std::min(minv, c(i, col + 1) - _u[i]);
+                }
+                _v[col + 1] = minv;
+                _dirtyCol[col] = 0;
+            }
+            for (IndexType row : _dirtyRows)
+            {
+                cost_type minu = INF;
+                for (IndexType j = 1; j <= _numCols; ++j)
+                {
+                    minu = std::min(minu, c(row + 1, j) - _v[j]);
+                }
+                _u[row + 1] = minu;
+                _dirtyRow[row] = 0;
+            }
+            _dirtyRows.clear();
+            _dirtyCols.clear();
+            // Augment the unmatched rows, the real ones first
+            for (IndexType i = 1; i <= _numCols; ++i)
+            {
+                if (_rowCol[i] == 0)
+                {
+                    augment(i);
+                }
+            }
+        }
+        /// @brief the column assigned to a row
+        IndexType rowToCol(IndexType row) const { return _rowCol[row + 1] - 1; }
+        /// @brief the number of augmentations since init. For measuring how much the warm start saves
+        IndexType numAugments() const { return _numAugments; }
+    private:
+        /// @brief the cost with 1-based indices. Dummy rows cost zero
+        cost_type c(IndexType i, IndexType j) const { return i <= _numRows ? _cost[static_cast<std::size_t>(i - 1) * _numCols + j - 1] : 0; }
+        void unmatchRow(IndexType i)
+        {
+            if (_rowCol[i] != 0)
+            {
+                _p[_rowCol[i]] = 0;
+                _rowCol[i] = 0;
+            }
+        }
+        /// @brief find the shortest augmenting path from row i and augment along it
+        void augment(IndexType i)
+        {
+            ++_numAugments;
+            const IndexType n = _numCols;
+            _p[0] = i;
+            IndexType j0 = 0;
+            std::fill(_minv.begin(), _minv.end(), INF);
+            std::fill(_used.begin(), _used.end(), 0);
+            do
+            {
+                _used[j0] = 1;
+                const IndexType i0 = _p[j0];
+                cost_type delta = INF;
+                IndexType j1 = 0;
+                for (IndexType j = 1; j <= n; ++j)
+                {
+                    if (_used[j]) { continue; }
+                    const cost_type cur = c(i0, j) - _u[i0] - _v[j];
+                    if (cur < _minv[j])
+                    {
+                        _minv[j] = cur;
+                        _way[j] = j0;
+                    }
+                    if (_minv[j] < delta)
+                    {
+                        delta = _minv[j];
+                        j1 = j;
+                    }
+                }
+                for (IndexType j = 0; j <= n; ++j)
+                {
+                    if (_used[j])
+                    {
+                        _u[_p[j]] += delta;
+                        _v[j] -= delta;
+                    }
+                    else
+                    {
+                        _minv[j] -= delta;
+                    }
+                }
+                j0 = j1;
+            } while (_p[j0] != 0);
+            do
+            {
+                const IndexType j1 = _way[j0];
+                _p[j0] = _p[j1];
+                _rowCol[_p[j0]] = j0;
+                j0 = j1;
+            } while (j0 != 0);
+        }
+    private:
+        IndexType _numRows = 0;
+        IndexType _numCols = 0;
+        std::vector<cost_type> _cost; ///< Row-major costs of the real rows
+        std::vector<cost_type> _u; ///< The potentials of the rows, 1-based
+        std::vector<cost_type> _v; ///< The potentials of the columns, 1-based
+        std::vector<IndexType> _p; ///< _p[j] = the row matched to column j, 0 if none
+        std::vector<IndexType> _rowCol; ///< _rowCol[i] = the column matched to row i, 0 if none
+        std::vector<IndexType> _way; ///< The previous column on the shortest path
+        std::vector<cost_type> _minv; ///< The shortest reduced distances to the columns
+        std::vector<char> _used; ///< Whether a column is in the path tree
+        std::vector<char> _dirtyRow;
+        std::vector<char> _dirtyCol;
+        std::vector<IndexType> _dirtyRows;
+        std::vector<IndexType> _dirtyCols;
+        IndexType _numAugments = 0;
+};
+
+PROJECT_NAMESPACE_END
+
+#endif //IDEAPLACE_INCREMENTAL_ASSIGNMENT_H_
@@ -68,32 +68,44 @@ IntType lcm(IntType a, IntType b)
     return temp ? (a / temp * b) : 0;
 }
 
-void VirtualPinAssigner::reconfigureVirtualPinLocations(const Box<LocType> &cellsBBox)
+LocType VirtualPinAssigner::calculateVirtualBoundary(const Box<LocType> &cellsBBox, Box<LocType> &boundary) const
 {
-#ifdef DEBUG_PINASSIGN
-    DBG("Ideaplace: pinassgin: %s\n", __FUNCTION__);
-#endif
-    _virtualPinInterval = _db.parameters().virtualPinInterval();
-    _virtualBoundaryExtension = _db.parameters().virtualBoundaryExtension();
-    _boundary = cellsBBox;
-    _boundary.enlargeBy(_virtualBoundaryExtension);
+    boundary = cellsBBox;
+    boundary.enlargeBy(_virtualBoundaryExtension);
     LocType pinInterval = _virtualPinInterval;
     // Align to grid
     if (_db.parameters().hasGridStep())
     {
         LocType gridStep = _db.parameters().gridStep();
-        LocType center = _boundary.center().x();
+        LocType center = boundary.center().x();
         LocType targetCenter = (center / gridStep) * gridStep + gridStep / 2;
-        LocType targetWidth = std::max(_boundary.xHi() - targetCenter, targetCenter - _boundary.xLo());
+        LocType targetWidth = std::max(boundary.xHi() - targetCenter, targetCenter - boundary.xLo());
         targetWidth = targetWidth + gridStep - (targetWidth % gridStep);
-        _boundary.setXLo(targetCenter - targetWidth);
-        _boundary.setYLo(_boundary.yLo() - (_boundary.yLo() % gridStep));
-        _boundary.setXHi(targetCenter + targetWidth);
-        _boundary.setYHi(_boundary.yHi() + gridStep -  (_boundary.yHi() % gridStep));
+        boundary.setXLo(targetCenter - targetWidth);
+        boundary.setYLo(boundary.yLo() - (boundary.yLo() % gridStep));
+        boundary.setXHi(targetCenter + targetWidth);
+        boundary.setYHi(boundary.yHi() + gridStep -  (boundary.yHi() % gridStep));
         pinInterval = lcm(pinInterval, gridStep);
     }
+    return pinInterval;
+}
+
+void VirtualPinAssigner::reconfigureVirtualPinLocations(const Box<LocType> &cellsBBox)
+{
+#ifdef DEBUG_PINASSIGN
+    DBG("Ideaplace: pinassgin: %s\n", __FUNCTION__);
+#endif
+    _virtualPinInterval = _db.parameters().virtualPinInterval();
+    _virtualBoundaryExtension = _db.parameters().virtualBoundaryExtension();
+    LocType pinInterval = calculateVirtualBoundary(cellsBBox, _boundary);
+    generateVirtualPins(pinInterval);
+}
+
+void VirtualPinAssigner::generateVirtualPins(LocType pinInterval)
+{
     // generate the virtual pin locations
     _virtualPins.clear();
+    _leftToRightMap.clear();
     _topPin = VirtualPin(XY<LocType>(_boundary.center().x(), _boundary.xHi()));
     _botPin = VirtualPin(XY<LocType>(_boundary.center().x(), _boundary.xLo()));
     for (LocType x = _boundary.xLo() + pinInterval;  x < _boundary.center().x() - pinInterval / 2 ; x += pinInterval)
@@ -468,6 +480,230 @@ bool VirtualPinAssigner::pinAssignment(std::function<XY<LocType>(IndexType)> cel
 }
 
 
+bool VirtualPinAssigner::pinAssignmentIncremental(const Box<LocType> &cellsBBox, std::function<XY<LocType>(IndexType)> cellLocQueryFunc)
+{
+#ifdef DEBUG_PINASSIGN
+    DBG("Ideaplace: pinassgin: %s\n", __FUNCTION__);
+#endif
+    typedef IncrementalAssignment::cost_type cost_type;
+    const LocType threshold = _db.parameters().virtualPinMoveThreshold();
+    _virtualPinInterval = _db.parameters().virtualPinInterval();
+    _virtualBoundaryExtension = _db.parameters().virtualBoundaryExtension();
+    Box<LocType> boundary;
+    LocType pinInterval = calculateVirtualBoundary(cellsBBox, boundary);
+    // Regenerate the sites only if the boundary has moved, since then all the costs change
+    bool boundaryMoved = std::abs(boundary.xLo() - _boundary.xLo()) > threshold or std::abs(boundary.yLo() - _boundary.yLo()) > threshold;
+    boundaryMoved = boundaryMoved or std::abs(boundary.xHi() - _boundary.xHi()) > threshold or std::abs(boundary.yHi() - _boundary.yHi()) > threshold;
+    bool rebuild = not _hasIncrementalSites or pinInterval != _incrementalPinInterval;
+    if (rebuild or boundaryMoved)
+    {
+        const IndexType numSites = _virtualPins.size();
+        _boundary = boundary;
+        generateVirtualPins(pinInterval);
+        // The sites are generated in the same order, so if their number is the same, each keeps its index and its pair.
+        // Then the problems keep their matching and potentials as the warm start, and only the costs are renewed
+        rebuild = rebuild or _virtualPins.size() != numSites;
+    }
+
+    auto findRealPinLoc = [&](IndexType pinIdx)
+    {
+        XY<LocType> pinOff = _db.pin(pinIdx).midLoc();
+        XY<LocType> cellLoc = cellLocQueryFunc(_db.pin(pinIdx).cellIdx());
+        return cellLoc + pinOff;
+    };
+    // Same as the cost in pinAssignment
+    auto calculateShortestManhattanDistance = [&](IndexType netIdx, IndexType ioPinIdx) -> cost_type
+    {
+        if (_db.net(netIdx).numPinIdx() < 1)
+        {
+            return 0; // don't care
+        }
+        LocType dist = LOC_TYPE_MAX;
+        const auto &iopinLoc = _virtualPins.at(ioPinIdx).loc();
+        for (IndexType pinIdx : _db.net(netIdx).pinIdxArray())
+        {
+            auto pinOff = findRealPinLoc(pinIdx);
+            dist = std::min(::klib::manhattanDistance(iopinLoc, pinOff), dist);
+        }
+        if (iopinLoc.x() < _boundary.center().x())
+        {
+            dist *= 1.2;
+        }
+        return dist;
+    };
+
+    std::vector<char> dirtyNets(_db.numNets(), rebuild or boundaryMoved);
+    if (rebuild)
+    {
+        _incrementalPinInterval = pinInterval;
+        _incrementalCellLocs.resize(_db.numCells());
+        for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+        {
+            _incrementalCellLocs[cellIdx] = cellLocQueryFunc(cellIdx);
+        }
+        // Collect the problems. The nets are filtered as in pinAssignment
+        _symNets.clear();
+        _asymNets.clear();
+        _leftPins.clear();
+        for (IndexType netIdx = 0; netIdx < _db.numNets(); ++netIdx)
+        {
+            const auto &net = _db.net(netIdx);
+            if (not net.isIo() or net.isVdd() or net.isVss())
+            {
+                continue;
+            }
+            if (net.hasSymNet())
+            {
+                if (net.isLeftSym())
+                {
+                    _symNets.emplace_back(netIdx);
+                }
+                continue;
+            }
+            _asymNets.emplace_back(netIdx);
+        }
+        for (const auto &pair : _leftToRightMap)
+        {
+            _leftPins.emplace_back(pair.first);
+        }
+        if (_symNets.size() > _leftPins.size() or _asymNets.size() + 2 * _symNets.size() > _virtualPins.size())
+        {
+            _hasIncrementalSites = false;
+            return false;
+        }
+        _symAssignment.init(_symNets.size(), _leftPins.size());
+        _asymAssignment.init(_asymNets.size(), _virtualPins.size());
+        _pinTakenBySym.assign(_virtualPins.size(), false);
+        _hasIncrementalSites = true;
+    }
+    else if (boundaryMoved)
+    {
+        // All the sites have moved, so all the costs are renewed with the current cell locations
+        for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+        {
+            _incrementalCellLocs[cellIdx] = cellLocQueryFunc(cellIdx);
+        }
+    }
+    else
+    {
+        // Only the nets of the moved cells need new costs
+        std::vector<char> movedCells(_db.numCells(), false);
+        bool moved = false;
+        for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+        {
+            const auto loc = cellLocQueryFunc(cellIdx);
+            const auto &lastLoc = _incrementalCellLocs[cellIdx];
+            if (std::abs(loc.x() - lastLoc.x()) > threshold or std::abs(loc.y() - lastLoc.y()) > threshold)
+            {
+                _incrementalCellLocs[cellIdx] = loc;
+                movedCells[cellIdx] = true;
+                moved = true;
+            }
+        }
+        if (not moved)
+        {
+            // The assignment in the database is still the solution
+            return true;
+        }
+        for (IndexType netIdx = 0; netIdx < _db.numNets(); ++netIdx)
+        {
+            for (IndexType pinIdx : _db.net(netIdx).pinIdxArray())
+            {
+                if (movedCells[_db.pin(pinIdx).cellIdx()])
+                {
+                    dirtyNets[netIdx] = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // The symmetric nets to the pin pairs
+    for (IndexType row = 0; row < _symNets.size(); ++row)
+    {
+        IndexType netIdx = _symNets[row];
+        IndexType otherNetIdx = _db.net(netIdx).symNetIdx();
+        if (not dirtyNets[netIdx] and not dirtyNets[otherNetIdx])
+        {
+            continue;
+        }
+        for (IndexType col = 0; col < _leftPins.size(); ++col)
+        {
+            IndexType leftPinIdx = _leftPins[col];
+            IndexType rightPinIdx = _leftToRightMap.at(leftPinIdx);
+            _symAssignment.setCost(row, col, calculateShortestManhattanDistance(netIdx, leftPinIdx) + calculateShortestManhattanDistance(otherNetIdx, rightPinIdx));
+        }
+        _symAssignment.markRowDirty(row);
+    }
+    _symAssignment.solve();
+
+    // The asymmetric nets to the pins not taken by the symmetric nets. The taken pins are blocked by a cost higher than any feasible solution
+    const cost_type blockedCost = static_cast<cost_type>(LOC_TYPE_MAX) * (_virtualPins.size() + 1);
+    std::vector<char> pinTaken(_virtualPins.size(), false);
+    for (IndexType row = 0; row < _symNets.size(); ++row)
+    {
+        IndexType leftPinIdx = _leftPins[_symAssignment.rowToCol(row)];
+        pinTaken[leftPinIdx] = true;
+        pinTaken[_leftToRightMap.at(leftPinIdx)] = true;
+    }
+    for (IndexType row = 0; row < _asymNets.size(); ++row)
+    {
+        IndexType netIdx = _asymNets[row];
+        if (not dirtyNets[netIdx])
+        {
+            continue;
+        }
+        for (IndexType pinIdx = 0; pinIdx < _virtualPins.size(); ++pinIdx)
+        {
+            _asymAssignment.setCost(row, pinIdx, pinTaken[pinIdx] ? blockedCost : calculateShortestManhattanDistance(netIdx, pinIdx));
+        }
+        _asymAssignment.markRowDirty(row);
+    }
+    for (IndexType pinIdx = 0; pinIdx < _virtualPins.size(); ++pinIdx)
+    {
+        if (pinTaken[pinIdx] == _pinTakenBySym[pinIdx])
+        {
+            continue;
+        }
+        for (IndexType row = 0; row < _asymNets.size(); ++row)
+        {
+            if (dirtyNets[_asymNets[row]])
+            {
+                continue;
+            }
+            _asymAssignment.setCost(row, pinIdx, pinTaken[pinIdx] ? blockedCost : calculateShortestManhattanDistance(_asymNets[row], pinIdx));
+        }
+        _asymAssignment.markColDirty(pinIdx);
+    }
+    _pinTakenBySym = pinTaken;
+    _asymAssignment.solve();
+
+    // Export the solution into the database
+    for (auto &virtualPin : _virtualPins)
+    {
+        virtualPin.free();
+    }
+    assignPowerPin();
+    auto directAssignNetToPinFunc = [&](IndexType netIdx, IndexType virtualPinIdx)
+    {
+        AssertMsg(!_virtualPins[virtualPinIdx].assigned(), "Ideaplace: IO pin assignment: unexpected error: pin assignment conflict \n");
+        _virtualPins[virtualPinIdx].assign(netIdx);
+        _db.net(netIdx).setVirtualPin(_virtualPins[virtualPinIdx]);
+    };
+    for (IndexType row = 0; row < _symNets.size(); ++row)
+    {
+        IndexType netIdx = _symNets[row];
+        IndexType leftPinIdx = _leftPins[_symAssignment.rowToCol(row)];
+        directAssignNetToPinFunc(netIdx, leftPinIdx);
+        directAssignNetToPinFunc(_db.net(netIdx).symNetIdx(), _leftToRightMap.at(leftPinIdx));
+    }
+    for (IndexType row = 0; row < _asymNets.size(); ++row)
+    {
+        directAssignNetToPinFunc(_asymNets[row], _asymAssignment.rowToCol(row));
+    }
+    return true;
+}
+
 bool VirtualPinAssigner::_lpSimplexPinAssignment(
         std::function<bool(IndexType)> isSymNetFunc,
         std::function<bool(IndexType)> isLeftPinFunc,
@@ -487,6 +723,7 @@ bool VirtualPinAssigner::_lpSimplexPinAssignment(
 #ifdef DEBUG_PINASSIGN
     DBG("Ideaplace: pinassgin: %s\n", __FUNCTION__);
 #endif
+    std::lock_guard<std::mutex> lpLock(::klib::lp::lpMutex());
     auto start = std::chrono::high_resolution_clock::now();
 
 
@@ -9,6 +9,7 @@
 #define IDEAPLACE_VIRTUAL_PIN_ASSIGNMER_H_
 
 #include "db/Database.h"
+#include "pinassign/IncrementalAssignment.h"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -34,6 +35,14 @@ class VirtualPinAssigner
         /// @brief solve the pin assignment problem. Export the solution to the database
         /// @param a function for query cell location
         bool pinAssignment(std::function<XY<LocType>(IndexType)> cellLocQueryFunc);
+        /// @brief solve the pin assignment problem from the last call. Export the solution to the database
+        /// @details The pin sites and the assignment problems are kept between the calls. The sites are regenerated only if the virtual boundary moves more than the move threshold.
+        /// Then all the costs are renewed, and the problems are rebuilt only if the number of sites has changed.
+        /// Otherwise the costs are updated only for the nets of the cells moved more than the threshold. The problems are warm-started from the last solution unless rebuilt.
+        /// Nothing is solved if no cell has moved more than the threshold. Always uses the two pass assignment of the fast mode
+        /// @param the bounding box of the cells
+        /// @param a function for query cell location
+        bool pinAssignmentIncremental(const Box<LocType> &cellsBBox, std::function<XY<LocType>(IndexType)> cellLocQueryFunc);
 
         /* Parameter settings */
         /// @brief set the extension distance of placement boundary to cell boundary
@@ -44,6 +53,11 @@ class VirtualPinAssigner
         void useFastMode() { _fastMode = true; }
         void useSlowMode() { _fastMode = false; }
     private:
+        /// @brief calculate the virtual boundary from the cell bounding box
+        /// @return the interval between the pins on the boundary
+        LocType calculateVirtualBoundary(const Box<LocType> &cellsBBox, Box<LocType> &boundary) const;
+        /// @brief generate the virtual pin locations on _boundary
+        void generateVirtualPins(LocType pinInterval);
         void assignPowerPin()
         {
 #ifdef DEBUG_PINASSIGN
@@ -94,6 +108,16 @@ class VirtualPinAssigner
         LocType _virtualPinInterval = -1; ///< The interval between virtual pins
         std::map<IndexType, IndexType> _leftToRightMap; // _leftToRightMap[idx of left] = idx of right
         bool _fastMode = false; ///< True : use two pass MCMF. False: use simplex
+        /* The states kept by pinAssignmentIncremental */
+        bool _hasIncrementalSites = false; ///< Whether the sites and the problems below are built
+        LocType _incrementalPinInterval = -1; ///< The pin interval of the sites
+        std::vector<XY<LocType>> _incrementalCellLocs; ///< The cell locations the costs are calculated with
+        std::vector<IndexType> _symNets; ///< The left nets of the symmetric pairs. The rows of the symmetric problem
+        std::vector<IndexType> _asymNets; ///< The other io nets. The rows of the asymmetric problem
+        std::vector<IndexType> _leftPins; ///< The left pins of the pin pairs. The columns of the symmetric problem
+        std::vector<char> _pinTakenBySym; ///< Whether a pin is taken by the symmetric problem. Such pins are blocked in the asymmetric problem
+        IncrementalAssignment _symAssignment; ///< The symmetric nets to the pin pairs
+        IncrementalAssignment _asymAssignment; ///< The asymmetric nets to all the pins
 };
 
 PROJECT_NAMESPACE_END
@@ -13,7 +13,7 @@ bool CGLegalizer::legalize()
     //this->generateConstraints();
 
 
-    auto legalizationStopWath = WATCH_CREATE_NEW("legalization");
+    auto legalizationStopWath = WATCH_CREATE_NEW(_db.stopWatchName("legalization"));
     legalizationStopWath->start();
 
     this->generateHorConstraints();
@@ -38,7 +38,7 @@ bool CGLegalizer::legalize()
     _hStar = std::max(0.0, static_cast<RealType>(yMax - yMin)) + 10;
     //this->generateConstraints();
     
-    auto dpStopWatch =  WATCH_CREATE_NEW("detailedPlacement");
+    auto dpStopWatch =  WATCH_CREATE_NEW(_db.stopWatchName("detailedPlacement"));
     dpStopWatch->start();
     if (_db.parameters().ifUsePinAssignment())
     {
@@ -1120,6 +1120,7 @@ void CGLegalizer::initIrredundantEdgesDelete(bool isHor, std::vector<IndexType>
 
 RealType CGLegalizer::lpLegalization(bool isHor)
 {
+    std::lock_guard<std::mutex> lpLock(::klib::lp::lpMutex());
     RealType obj;
     if (isHor)
     {
@@ -1163,6 +1164,7 @@ RealType CGLegalizer::lpLegalization(bool isHor)
 
 bool CGLegalizer::lpDetailedPlacement()
 {
+    std::lock_guard<std::mutex> lpLock(::klib::lp::lpMutex());
     // Horizontal
     this->generateHorConstraints();
     INF("CG legalizer: detailed placement horizontal LP...\n");
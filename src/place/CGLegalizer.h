@@ -173,6 +173,8 @@ class LpLegalizeSolver
         void addHpwlConstraints();
         /// @brief add current flow constraint
         void addCurrentFlowConstraints();
+        /// @brief keep the fixed cells at their current locations relative to each other
+        void addFixedCellConstraints();
     private:
         /* Configurations - Inputs */
         Database &_db; ///< The database for the Ideaplace
@@ -584,6 +584,28 @@ void LpLegalizeSolver::addCurrentFlowConstraints()
     }
 }
 
+void LpLegalizeSolver::addFixedCellConstraints()
+{
+    // The solution is shifted as a whole afterward, so only the offsets between the fixed cells are pinned
+    IndexType refCellIdx = INDEX_TYPE_MAX;
+    for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
+    {
+        if (not _db.cell(cellIdx).isFixed())
+        {
+            continue;
+        }
+        if (refCellIdx == INDEX_TYPE_MAX)
+        {
+            refCellIdx = cellIdx;
+            continue;
+        }
+        const auto &cell = _db.cell(cellIdx);
+        const auto &refCell = _db.cell(refCellIdx);
+        const LocType offset = _isHor ? cell.xLo() - refCell.xLo() : cell.yLo() - refCell.yLo();
+        lp_trait::addConstr(_solver, _locs.at(cellIdx) - _locs.at(refCellIdx) == static_cast<RealType>(offset));
+    }
+}
+
 void LpLegalizeSolver::addIlpConstraints()
 {
     // Add boundary constraint
@@ -596,6 +618,8 @@ void LpLegalizeSolver::addIlpConstraints()
     addHpwlConstraints();
     /// Add current flow constraints
     addCurrentFlowConstraints();
+    // Add fixed cell constraints
+    addFixedCellConstraints();
 }
 
 PROJECT_NAMESPACE_END
@@ -9,9 +9,10 @@ using namespace nt;
 template<typename nlp_settings>
 IntType NlpGPlacerBase<nlp_settings>::solve()
 {
-    auto stopWatch = WATCH_CREATE_NEW("NlpGPlacer");
+    auto stopWatch = WATCH_CREATE_NEW(stopWatchName("NlpGPlacer"));
     stopWatch->start();
-    _calcObjStopWatch = WATCH_CREATE_NEW("GP_calculate_obj");
+    _timeBudget.start(_db.parameters().nlpTimeBudgetMs());
+    _calcObjStopWatch = WATCH_CREATE_NEW(stopWatchName("GP_calculate_obj"));
     this->initProblem();
     this->initPlace();
     this->initOperators();
@@ -55,19 +56,16 @@ void NlpGPlacerBase<nlp_settings>::assignIoPins()
         auto loc = cellLocQueryFunc(i);
         xLo = std::min(xLo, loc.x());
         yLo = std::min(yLo, loc.y());
-        xHi = std::max(xLo, _db.cell(i).cellBBox().xLen() + loc.x());
-        yHi = std::max(yLo, _db.cell(i).cellBBox().yLen() + loc.y());
+        xHi = std::max(xHi, _db.cell(i).cellBBox().xLen() + loc.x());
+        yHi = std::max(yHi, _db.cell(i).cellBBox().yLen() + loc.y());
     }
 
 
-    VirtualPinAssigner assigner(_db);
-    assigner.useFastMode();
-    assigner.reconfigureVirtualPinLocations(Box<LocType>(xLo, yLo, xHi, yHi));
     IndexType hpwlIdx = 0;
     IndexType pwlIdx = 0;
     IndexType vssNetIdx = INDEX_TYPE_MAX;
     XY<nlp_coordinate_type> vssPinLoc;
-    if (assigner.pinAssignment(cellLocQueryFunc))
+    if (_pinAssigner.pinAssignmentIncremental(Box<LocType>(xLo, yLo, xHi, yHi), cellLocQueryFunc))
     {
         // update the hpwl operator
         for (IndexType netIdx = 0; netIdx < _db.numNets(); ++netIdx)
@@ -190,39 +188,18 @@ void NlpGPlacerBase<nlp_settings>::initPlace()
 template<typename nlp_settings>
 void NlpGPlacerBase<nlp_settings>::initOperators()
 {
-    auto getAlphaFunc = [&]()
-    {
-        return _alpha ;
-    };
-    auto getLambdaFuncOvr = [&]()
-    {
-        return 1.0;
-    };
-    auto getLambdaFuncBoundary = [&]()
-    {
-        return 1.0;
-    };
-    auto getLambdaFuncHpwl = [&]()
-    {
-        return 1.0;
-    };
-    auto getLambdaFuncAsym = [&]()
-    {
-        return 1.0;
-    };
-    auto getLambdaFuncCosine = [&]()
-    {
-        return 1.0;
-    };
-    auto getVarFunc = [&] (IndexType cellIdx, Orient2DType orient)
-    {
+    // The operators access the alpha, multipliers and variables directly. _pl is sized in initProblem() and only assigned in-place afterwards
+    const diff::NumericRef<nlp_numerical_type> getAlphaFunc(&_alpha);
+    const diff::NumericRef<nlp_numerical_type> getLambdaFuncOvr(1.0);
+    const diff::NumericRef<nlp_numerical_type> getLambdaFuncBoundary(1.0);
+    const diff::NumericRef<nlp_numerical_type> getLambdaFuncHpwl(1.0);
+    const diff::NumericRef<nlp_numerical_type> getLambdaFuncAsym(1.0);
+    const diff::NumericRef<nlp_numerical_type> getLambdaFuncCosine(1.0);
 #ifdef MULTI_SYM_GROUP
-        return _pl(plIdx(cellIdx, orient));
+    const diff::PlaceVarView<nlp_coordinate_type, nlp_coordinate_type> getVarFunc(_pl.data(), _numCells, nullptr);
 #else
-        if (orient == Orient2DType::NONE) { return _defaultSymAxis; }
-        return _pl(plIdx(cellIdx, orient));
+    const diff::PlaceVarView<nlp_coordinate_type, nlp_coordinate_type> getVarFunc(_pl.data(), _numCells, &_defaultSymAxis);
 #endif
-    };
 
     auto calculatePinOffset = [&](IndexType pinIdx)
     {
@@ -255,25 +232,7 @@ void NlpGPlacerBase<nlp_settings>::initOperators()
         op.setGetVarFunc(getVarFunc);
     }
     // Pair-wise cell overlapping
-    for (IndexType cellIdxI = 0; cellIdxI < _db.numCells(); ++cellIdxI)
-    {
-        const auto cellBBoxI = _db.cell(cellIdxI).cellBBox();
-        for (IndexType cellIdxJ = cellIdxI + 1; cellIdxJ < _db.numCells(); ++cellIdxJ)
-        {
-            const auto cellBBoxJ = _db.cell(cellIdxJ).cellBBox();
-            _ovlOps.emplace_back(nlp_ovl_type(
-                        cellIdxI,
-                        cellBBoxI.xLen() * _scale,
-                        cellBBoxI.yLen() * _scale,
-                        cellIdxJ,
-                        cellBBoxJ.xLen() * _scale,
-                        cellBBoxJ.yLen() * _scale,
-                        getAlphaFunc,
-                        getLambdaFuncOvr
-                        ));
-            _ovlOps.back().setGetVarFunc(getVarFunc);
-        }
-    }
+    ovl_ops_trait::construct(*this, getAlphaFunc, getLambdaFuncOvr, getVarFunc);
     // Out of boundary
     for (IndexType cellIdx = 0; cellIdx < _db.numCells(); ++cellIdx)
     {
@@ -516,11 +475,9 @@ template<typename nlp_settings>
 void NlpGPlacerBase<nlp_settings>::constructObjectiveCalculationTasks()
 {
     using EvaObjTask = EvaObjTask<nlp_numerical_type>;
-    for (const auto &hpwl : _hpwlOps)
-    {
-        auto eva = [&]() { return diff::placement_differentiable_traits<nlp_hpwl_type>::evaluate(hpwl);};
-        _evaHpwlTasks.emplace_back(Task<EvaObjTask>(EvaObjTask(eva)));
-    }
+    // All the nets are evaluated together
+    _hpwlBatch.build(_hpwlOps);
+    _evaHpwlTasks.emplace_back(Task<EvaObjTask>(EvaObjTask([&]() { return _hpwlBatch.evaluate(); })));
     for (const auto &ovl : _ovlOps)
     {
         auto eva = [&]() { return diff::placement_differentiable_traits<nlp_ovl_type>::evaluate(ovl);};
@@ -544,12 +501,12 @@ void NlpGPlacerBase<nlp_settings>::constructObjectiveCalculationTasks()
     for (const auto &wl : _powerWlOps)
     {
         auto eva = [&]() { return diff::placement_differentiable_traits<nlp_power_wl_type>::evaluate(wl);};
-        _evaCosTasks.emplace_back(Task<EvaObjTask>(EvaObjTask(eva)));
+        _evaPowerWlTasks.emplace_back(Task<EvaObjTask>(EvaObjTask(eva)));
     }
     for (const auto &op : _crfOps)
     {
         auto eva = [&]() { return diff::placement_differentiable_traits<nlp_crf_type>::evaluate(op);};
-        _evaCosTasks.emplace_back(Task<EvaObjTask>(EvaObjTask(eva)));
+        _evaCrfTasks.emplace_back(Task<EvaObjTask>(EvaObjTask(eva)));
     }
 }
 
@@ -629,6 +586,7 @@ void NlpGPlacerBase<nlp_settings>::constructSumObjTasks()
         _obj += _objCos;
         _obj += _objPowerWl;
         _obj += _objCrf;
+        ++_numObjEvals;
     };
     _sumObjAllTask = Task<FuncTask>(FuncTask(all));
 }
@@ -639,7 +597,7 @@ void NlpGPlacerBase<nlp_settings>::constructWrapObjTask()
 {
     auto hpwl = [&]()
     {
-        #pragma omp parallel for schedule(static)
+        // The batched task is parallelized inside
         for (IndexType idx = 0; idx < _evaHpwlTasks.size(); ++idx)
         {
             _evaHpwlTasks[idx].run();
@@ -649,6 +607,7 @@ void NlpGPlacerBase<nlp_settings>::constructWrapObjTask()
     _wrapObjHpwlTask = Task<FuncTask>(FuncTask(hpwl));
     auto ovl = [&]()
     {
+        ovl_ops_trait::refresh(*this);
         #pragma omp parallel for schedule(static)
         for (IndexType idx = 0; idx < _evaOvlTasks.size(); ++idx)
         {
@@ -729,14 +688,16 @@ void NlpGPlacerBase<nlp_settings>::constructWrapObjTask()
 template<typename nlp_settings>
 void NlpGPlacerFirstOrder<nlp_settings>::optimize()
 {
-    _optimizerKernelStopWatch = WATCH_CREATE_NEW("GP_optimizer_kernel");
-    auto optimizeStopWatch = WATCH_CREATE_NEW("GP_optimize");
+    _optimizerKernelStopWatch = WATCH_CREATE_NEW(this->stopWatchName("GP_optimizer_kernel"));
+    _profiler.init({ this->_hpwlOps.size(), this->_ovlOps.size(), this->_oobOps.size(), this->_asymOps.size(),
+            this->_cosOps.size(), this->_powerWlOps.size(), this->_crfOps.size() });
+    this->_trace.start(this->_db.parameters().nlpTraceFile(), this->_db.parameters().nlpTraceCapacity());
+    auto optimizeStopWatch = WATCH_CREATE_NEW(this->stopWatchName("GP_optimize"));
     optimizeStopWatch->start();
-    auto updateProblemStopWatch = WATCH_CREATE_NEW("GP_update_problem");
+    auto updateProblemStopWatch = WATCH_CREATE_NEW(this->stopWatchName("GP_update_problem"));
     this->assignIoPins();
     // setting up the multipliers
-    this->_wrapObjAllTask.run();
-    _wrapCalcGradTask.run();
+    calcObjAndGrad();
 
     optm_type optm;
     mult_type multiplier = mult_trait::construct(*this);
@@ -752,10 +713,28 @@ void NlpGPlacerFirstOrder<nlp_settings>::optimize()
     alpha_update_trait::init(*this, alpha, alphaUpdate);
 
     IntType iter = 0;
-    do
+    bool stop = false;
+    // The kernels restart their moments in every outer iteration, so there is no optimizer state to keep between the outer iterations
+    const auto &resumeFile = this->_db.parameters().nlpResumeFile();
+    if (not resumeFile.empty())
+    {
+        if (nlp::checkpoint::load(resumeFile, this->_numVariables, iter, stop, this->_pl, multiplier, multAdjuster, alpha, alphaUpdate, this->_stopCondition))
+        {
+            INF("First order NLP: resume from %s at iter %d \n", resumeFile.c_str(), iter);
+            this->assignIoPins();
+        }
+        else
+        {
+            WRN("First order NLP: %s is not a checkpoint of this problem. Start from scratch \n", resumeFile.c_str());
+        }
+    }
+    const auto &checkpointFile = this->_db.parameters().nlpCheckpointFile();
+    const IndexType checkpointInterval = this->_db.parameters().nlpCheckpointInterval();
+    while (not stop)
     {
         INF("First order NLP: iter %d \n", iter);
 
+        this->_timeBudget.beginOuterIter();
         optm_trait::optimize(*this, optm);
         updateProblemStopWatch->start();
         mult_trait::update(*this, multiplier);
@@ -765,13 +744,42 @@ void NlpGPlacerFirstOrder<nlp_settings>::optimize()
         alpha_update_trait::update(*this, alpha, alphaUpdate);
         this->assignIoPins();
         updateProblemStopWatch->stop();
+        _profiler.endOuterIter();
+        this->_trace.recordOuter(*this, multiplier, alpha);
         
 #ifdef DEBUG_GR
         DBG("obj %f hpwl %f ovl %f oob %f asym %f cos %f \n", this->_obj, this->_objHpwl, this->_objOvl, this->_objOob, this->_objAsym, this->_objCos);
 #endif
         ++iter;
-    } while (not base_type::stop_condition_trait::stopPlaceCondition(*this, this->_stopCondition));
+        if (this->reportToMultiStart())
+        {
+            INF("First order NLP: cancelled by the multi-start at iter %d \n", iter);
+            break;
+        }
+        stop = base_type::stop_condition_trait::stopPlaceCondition(*this, this->_stopCondition);
+        if (this->_timeBudget.endOuterIter() and not stop)
+        {
+            INF("First order NLP: out of the time budget at iter %d, %f ms elapsed \n", iter, this->_timeBudget.elapsedMs());
+            stop = true;
+        }
+        // After the stop condition, which may count the iterations too
+        if (not checkpointFile.empty() and checkpointInterval > 0 and iter % checkpointInterval == 0)
+        {
+            if (not nlp::checkpoint::save(checkpointFile, this->_numVariables, iter, stop, this->_pl, multiplier, multAdjuster, alpha, alphaUpdate, this->_stopCondition))
+            {
+                WRN("First order NLP: failed to write the checkpoint %s \n", checkpointFile.c_str());
+            }
+        }
+    }
     optimizeStopWatch->stop();
+    if (this->_profile != nullptr)
+    {
+        this->_profile->merge(_profiler.profile());
+    }
+    if (not this->_trace.flush())
+    {
+        WRN("First order NLP: failed to write the trace %s \n", this->_trace.filename().c_str());
+    }
     this->writeOut();
 }
 
@@ -797,6 +805,15 @@ void NlpGPlacerFirstOrder<nlp_settings>::initFirstOrderGrad()
     _gradCos.resize(size);
     _gradPowerWl.resize(size);
     _gradCrf.resize(size);
+    _fixedVars.clear();
+    for (IndexType cellIdx = 0; cellIdx < this->_db.numCells(); ++cellIdx)
+    {
+        if (this->_db.cell(cellIdx).isFixed())
+        {
+            _fixedVars.emplace_back(this->plIdx(cellIdx, Orient2DType::HORIZONTAL));
+            _fixedVars.emplace_back(this->plIdx(cellIdx, Orient2DType::VERTICAL));
+        }
+    }
 }
 
 template<typename nlp_settings>
@@ -810,26 +827,23 @@ template<typename nlp_settings>
 void NlpGPlacerFirstOrder<nlp_settings>::constructFirstOrderTasks()
 {
     constructCalcPartialsTasks();
-    constructUpdatePartialsTasks();
+    constructGatherPartialsTasks();
     constructClearGradTasks();
     constructSumGradTask();
     constructWrapCalcGradTask();
+    constructWrapCalcObjAndGradTask();
 }
 
 template<typename nlp_settings>
 void NlpGPlacerFirstOrder<nlp_settings>::constructCalcPartialsTasks()
 {
-    using Hpwl = CalculateOperatorPartialTask<nlp_hpwl_type, EigenVector>;
     using Ovl = CalculateOperatorPartialTask<nlp_ovl_type, EigenVector>;
     using Oob = CalculateOperatorPartialTask<nlp_oob_type, EigenVector>;
     using Asym = CalculateOperatorPartialTask<nlp_asym_type, EigenVector>;
     using Cos = CalculateOperatorPartialTask<nlp_cos_type, EigenVector>;
     using Pwl = CalculateOperatorPartialTask<nlp_power_wl_type, EigenVector>;
     using Crf = CalculateOperatorPartialTask<nlp_crf_type, EigenVector>;
-    for (auto &hpwlOp : this->_hpwlOps)
-    {
-        _calcHpwlPartialTasks.emplace_back(Task<Hpwl>(Hpwl(&hpwlOp)));
-    }
+    // The HPWL partials are calculated by the batched kernel
     for (auto &ovlOp : this->_ovlOps)
     {
         _calcOvlPartialTasks.emplace_back(Task<Ovl>(Ovl(&ovlOp)));
@@ -857,44 +871,21 @@ void NlpGPlacerFirstOrder<nlp_settings>::constructCalcPartialsTasks()
 }
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::constructUpdatePartialsTasks()
+void NlpGPlacerFirstOrder<nlp_settings>::constructGatherPartialsTasks()
 {
-    using Hpwl = UpdateGradientFromPartialTask<nlp_hpwl_type, EigenVector>;
-    using Ovl = UpdateGradientFromPartialTask<nlp_ovl_type, EigenVector>;
-    using Oob = UpdateGradientFromPartialTask<nlp_oob_type, EigenVector>;
-    using Asym = UpdateGradientFromPartialTask<nlp_asym_type, EigenVector>;
-    using Cos = UpdateGradientFromPartialTask<nlp_cos_type, EigenVector>;
-    using Pwl = UpdateGradientFromPartialTask<nlp_power_wl_type, EigenVector>;
-    using Crf = UpdateGradientFromPartialTask<nlp_crf_type, EigenVector>;
+    using Ovl = GatherGradientFromPartialTask<nlp_ovl_type, EigenVector>;
+    using Oob = GatherGradientFromPartialTask<nlp_oob_type, EigenVector>;
+    using Asym = GatherGradientFromPartialTask<nlp_asym_type, EigenVector>;
+    using Cos = GatherGradientFromPartialTask<nlp_cos_type, EigenVector>;
+    using Pwl = GatherGradientFromPartialTask<nlp_power_wl_type, EigenVector>;
+    using Crf = GatherGradientFromPartialTask<nlp_crf_type, EigenVector>;
     auto getIdxFunc = [&](IndexType cellIdx, Orient2DType orient) { return this->plIdx(cellIdx, orient); }; // wrapper the convert cell idx to pl idx
-    for (auto &hpwl : _calcHpwlPartialTasks)
-    {
-        _updateHpwlPartialTasks.emplace_back(Task<Hpwl>(Hpwl(hpwl.taskDataPtr(), &_gradHpwl, getIdxFunc)));
-    }
-    for (auto &ovl : _calcOvlPartialTasks)
-    {
-        _updateOvlPartialTasks.emplace_back(Task<Ovl>(Ovl(ovl.taskDataPtr(), &_gradOvl, getIdxFunc)));
-    }
-    for (auto &oob : _calcOobPartialTasks)
-    {
-        _updateOobPartialTasks.emplace_back(Task<Oob>(Oob(oob.taskDataPtr(), &_gradOob, getIdxFunc)));
-    }
-    for (auto &asym : _calcAsymPartialTasks)
-    {
-        _updateAsymPartialTasks.emplace_back(Task<Asym>(Asym(asym.taskDataPtr(), &_gradAsym, getIdxFunc)));
-    }
-    for (auto &cos : _calcCosPartialTasks)
-    {
-        _updateCosPartialTasks.emplace_back(Task<Cos>(Cos(cos.taskDataPtr(), &_gradCos, getIdxFunc)));
-    }
-    for (auto &pwl : _calcPowerWlPartialTasks)
-    {
-        _updatePowerWlPartialTasks.emplace_back(Task<Pwl>(Pwl(pwl.taskDataPtr(), &_gradPowerWl, getIdxFunc)));
-    }
-    for (auto &crf : _calcCrfPartialTasks)
-    {
-        _updateCrfPartialTasks.emplace_back(Task<Crf>(Crf(crf.taskDataPtr(), &_gradCrf, getIdxFunc)));
-    }
+    _gatherOvlGradTask = Task<Ovl>(Ovl(_calcOvlPartialTasks, &_gradOvl, getIdxFunc));
+    _gatherOobGradTask = Task<Oob>(Oob(_calcOobPartialTasks, &_gradOob, getIdxFunc));
+    _gatherAsymGradTask = Task<Asym>(Asym(_calcAsymPartialTasks, &_gradAsym, getIdxFunc));
+    _gatherCosGradTask = Task<Cos>(Cos(_calcCosPartialTasks, &_gradCos, getIdxFunc));
+    _gatherPowerWlGradTask = Task<Pwl>(Pwl(_calcPowerWlPartialTasks, &_gradPowerWl, getIdxFunc));
+    _gatherCrfGradTask = Task<Crf>(Crf(_calcCrfPartialTasks, &_gradCrf, getIdxFunc));
 }
 
 template<typename nlp_settings>
@@ -913,203 +904,251 @@ void NlpGPlacerFirstOrder<nlp_settings>::constructClearGradTasks()
 template<typename nlp_settings>
 void NlpGPlacerFirstOrder<nlp_settings>::constructSumGradTask()
 {
-    _sumHpwlGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updateHpwlPartialTasks){ upd.run(); }}));
-    _sumOvlGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updateOvlPartialTasks){ upd.run(); }}));
-    _sumOobGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updateOobPartialTasks){ upd.run(); }}));
-    _sumAsymGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updateAsymPartialTasks){ upd.run(); }}));
-    _sumCosGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updateCosPartialTasks){ upd.run(); }}));
-    _sumPowerWlTaskGradTask = Task<FuncTask>(FuncTask([&](){ for (auto &upd : _updatePowerWlPartialTasks){ upd.run(); }}));
-    _sumCrfGradTask = Task<FuncTask>(FuncTask([&]() { for (auto &upd : _updateCrfPartialTasks) {upd.run(); }}));
     _sumGradTask = Task<FuncTask>(FuncTask([&](){ _grad = _gradHpwl + _gradOvl + _gradOob + _gradAsym + _gradCos + _gradPowerWl + _gradCrf; }));
 }
 
 template<typename nlp_settings>
 void NlpGPlacerFirstOrder<nlp_settings>::constructWrapCalcGradTask()
 {
-    _calcGradStopWatch = WATCH_CREATE_NEW("GP_calculate_gradient");
+    _calcGradStopWatch = WATCH_CREATE_NEW(this->stopWatchName("GP_calculate_gradient"));
     auto calcGradLambda = [&]()
     {
         _calcGradStopWatch->start();
-        _clearGradTask.run();
-        _clearHpwlGradTask.run();
-        _clearOvlGradTask.run();
-        _clearOobGradTask.run();
-        _clearAsymGradTask.run();
-        _clearCosGradTask.run();
-        _clearPowerWlGradTask.run();
-        _clearCrfGradTask.run();
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcHpwlPartialTasks.size(); ++i ) { _calcHpwlPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateHpwlPartialTasks.size(); ++i ) { _updateHpwlPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcOvlPartialTasks.size(); ++i ) { _calcOvlPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateOvlPartialTasks.size(); ++i ) { _updateOvlPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcOobPartialTasks.size(); ++i ) { _calcOobPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateOobPartialTasks.size(); ++i ) { _updateOobPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcAsymPartialTasks.size(); ++i ) { _calcAsymPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateAsymPartialTasks.size(); ++i ) { _updateAsymPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcCosPartialTasks.size(); ++i ) { _calcCosPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateCosPartialTasks.size(); ++i ) { _updateCosPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcPowerWlPartialTasks.size(); ++i ) { _calcPowerWlPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updatePowerWlPartialTasks.size(); ++i ) { _updatePowerWlPartialTasks[i].run(); }
-        #pragma omp parallel for schedule(static)
-        for (IndexType i = 0; i < _calcCrfPartialTasks.size(); ++i ) { _calcCrfPartialTasks[i].run(); }
-        for (IndexType i = 0; i < _updateCrfPartialTasks.size(); ++i ) { _updateCrfPartialTasks[i].run(); }
-        _sumGradTask.run();
+        if (this->_db.parameters().nlpExecutorType() == NlpExecutorType::PERSISTENT_REGION)
+        {
+            calcOpsInOneRegion<false>();
+        }
+        else
+        {
+            calcOpsPerFamily<false>();
+        }
         _calcGradStopWatch->stop();
     };
     _wrapCalcGradTask = Task<FuncTask>(FuncTask(calcGradLambda));
 }
 
-#ifdef IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
-
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcHpwlGradTaskFlow(tf::Taskflow &tfFlow)
+void NlpGPlacerFirstOrder<nlp_settings>::constructWrapCalcObjAndGradTask()
 {
-    IntType opSize = this->_hpwlOps.size();
-    _clearHpwlGradTask.regTask(tfFlow);
-    _sumHpwlGradTask.regTask(tfFlow);
-    auto taskIntEndCalc = tfFlow.parallel_for(0, opSize, 1, [&] (const int idx)
-            {
-                _calcHpwlPartialTasks[idx].run();
-            });
-    _clearHpwlGradTask.precede(taskIntEndCalc.first);
-    //taskIntEndCalc.second.precede(_sumHpwlGradTask.tfTask());
-    taskIntEndCalc.second.precede(_endGradCalcTask.tfTask());
-    _endGradCalcTask.precede(_sumHpwlGradTask);
+    auto calcObjAndGradLambda = [&]()
+    {
+        _calcGradStopWatch->start();
+        if (this->_db.parameters().nlpExecutorType() == NlpExecutorType::PERSISTENT_REGION)
+        {
+            calcOpsInOneRegion<true>();
+        }
+        else
+        {
+            calcOpsPerFamily<true>();
+        }
+        this->_sumObjAllTask.run();
+        _calcGradStopWatch->stop();
+    };
+    _wrapCalcObjAndGradTask = Task<FuncTask>(FuncTask(calcObjAndGradLambda));
 }
 
-
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcOvlGradTaskFlow(tf::Taskflow &tfFlow)
+template<bool needObj, typename calc_task_vector_type>
+void NlpGPlacerFirstOrder<nlp_settings>::runCalcTasksShared(nlp::profile::OpFamily family, calc_task_vector_type &calcTasks)
 {
-    IntType opSize = this->_ovlOps.size();
-    _clearOvlGradTask.regTask(tfFlow);
-    _sumOvlGradTask.regTask(tfFlow);
-    auto taskIntEndCalc = tfFlow.parallel_for(0, opSize, 1, [&] (const int idx)
-            {
-                _calcOvlPartialTasks[idx].run();
-            });
-    _clearOvlGradTask.precede(taskIntEndCalc.first);
-    //taskIntEndCalc.second.precede(_sumOvlGradTask.tfTask());
-    taskIntEndCalc.second.precede(_endGradCalcTask.tfTask());
-    _endGradCalcTask.precede(_sumOvlGradTask);
+    typedef std::decay_t<decltype(calcTasks.front().taskData())> calc_task_type;
+    const auto start = _profiler.now();
+    #pragma omp for schedule(guided) nowait
+    for (IndexType i = 0; i < calcTasks.size(); ++i)
+    {
+        if (needObj)
+        {
+            calc_task_type::runWithObj(calcTasks[i].taskData());
+        }
+        else
+        {
+            calc_task_type::run(calcTasks[i].taskData());
+        }
+    }
+    _profiler.addCalc(family, start);
 }
 
+template<typename nlp_settings>
+template<typename gather_task_type>
+void NlpGPlacerFirstOrder<nlp_settings>::runGatherTask(nlp::profile::OpFamily family, gather_task_type &gatherTask)
+{
+    const auto start = _profiler.now();
+    gatherTask.run();
+    _profiler.addScatter(family, start);
+}
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcOobGradTaskFlow(tf::Taskflow &tfFlow)
+template<typename op_type>
+void NlpGPlacerFirstOrder<nlp_settings>::runGatherTaskShared(nlp::profile::OpFamily family, Task<GatherGradientFromPartialTask<op_type, EigenVector>> &gatherTask)
 {
-    IntType opSize = this->_oobOps.size();
-    _clearOobGradTask.regTask(tfFlow);
-    _sumOobGradTask.regTask(tfFlow);
-    auto taskIntEndCalc = tfFlow.parallel_for(0, opSize, 1, [&] (const int idx)
-            {
-                _calcOobPartialTasks[idx].run();
-            });
-    _clearOobGradTask.precede(taskIntEndCalc.first);
-    //taskIntEndCalc.second.precede(_sumOobGradTask.tfTask());
-    taskIntEndCalc.second.precede(_endGradCalcTask.tfTask());
-    _endGradCalcTask.precede(_sumOobGradTask);
+    const auto start = _profiler.now();
+    GatherGradientFromPartialTask<op_type, EigenVector>::runShared(gatherTask.taskData());
+    _profiler.addScatter(family, start);
 }
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcAsymGradTaskFlow(tf::Taskflow &tfFlow)
+template<typename calc_task_vector_type>
+typename NlpGPlacerFirstOrder<nlp_settings>::nlp_numerical_type NlpGPlacerFirstOrder<nlp_settings>::sumCalcTasksObj(const calc_task_vector_type &calcTasks)
 {
-    IntType opSize = this->_asymOps.size();
-    _clearAsymGradTask.regTask(tfFlow);
-    _sumAsymGradTask.regTask(tfFlow);
-    auto taskIntEndCalc = tfFlow.parallel_for(0, opSize, 1, [&] (const int idx)
-            {
-                _calcAsymPartialTasks[idx].run();
-            });
-    _clearAsymGradTask.precede(taskIntEndCalc.first);
-    //taskIntEndCalc.second.precede(_sumAsymGradTask.tfTask());
-    taskIntEndCalc.second.precede(_endGradCalcTask.tfTask());
-    _endGradCalcTask.precede(_sumAsymGradTask);
+    nlp_numerical_type obj = 0.0;
+    for (const auto &calc : calcTasks)
+    {
+        obj += calc.taskData().obj();
+    }
+    return obj;
 }
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcCosGradTaskFlow(tf::Taskflow &tfFlow)
+template<bool needObj>
+void NlpGPlacerFirstOrder<nlp_settings>::calcHpwlShared()
 {
-    IntType opSize = this->_cosOps.size();
-    _clearCosGradTask.regTask(tfFlow);
-    _sumCosGradTask.regTask(tfFlow);
-    auto taskIntEndCalc = tfFlow.parallel_for(0, opSize, 1, [&] (const int idx)
-            {
-                _calcCosPartialTasks[idx].run();
-            });
-    _clearCosGradTask.precede(taskIntEndCalc.first);
-    //taskIntEndCalc.second.precede(_sumCosGradTask.tfTask());
-    taskIntEndCalc.second.precede(_endGradCalcTask.tfTask());
-    _endGradCalcTask.precede(_sumCosGradTask);
+    auto &hpwl = this->_hpwlBatch;
+    auto start = _profiler.now();
+    hpwl.computeExpShared();
+    _profiler.addCalc(nlp::profile::OpFamily::HPWL, start);
+    #pragma omp barrier
+    start = _profiler.now();
+    hpwl.template calcNetsShared<needObj, true>();
+    _profiler.addCalc(nlp::profile::OpFamily::HPWL, start);
+    #pragma omp barrier
+    start = _profiler.now();
+    hpwl.gatherShared(_gradHpwl.data(), this->_numCells);
+    _profiler.addScatter(nlp::profile::OpFamily::HPWL, start);
 }
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcGradForLoop(tf::Taskflow &tfFlow)
+template<bool needObj>
+void NlpGPlacerFirstOrder<nlp_settings>::calcOpsPerFamily()
 {
-    //_sumHpwlGradTask.regTask(tfFlow);
-    //_sumOvlGradTask.regTask(tfFlow);
-    //_sumOobGradTask.regTask(tfFlow);
-    //_sumAsymGradTask.regTask(tfFlow);
-    //_sumCosGradTask.regTask(tfFlow);
-    _beginGradCalcTask.regTask(tfFlow);
-    _endGradCalcTask.regTask(tfFlow);
-    for (auto & op : _calcHpwlPartialTasks)
-    {
-        op.regTask(tfFlow);
-        _beginGradCalcTask.precede(op);
-        op.precede(_endGradCalcTask);
+    _clearGradTask.run();
+    _clearHpwlGradTask.run();
+    _clearOvlGradTask.run();
+    _clearOobGradTask.run();
+    _clearAsymGradTask.run();
+    _clearCosGradTask.run();
+    _clearPowerWlGradTask.run();
+    _clearCrfGradTask.run();
+    _profiler.countEval();
+    auto &hpwl = this->_hpwlBatch;
+    hpwl.prepare();
+    #pragma omp parallel
+    {
+        calcHpwlShared<needObj>();
+    }
+    base_type::ovl_ops_trait::refresh(*this);
+    #pragma omp parallel
+    {
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::OVL, _calcOvlPartialTasks);
     }
-    for (auto & op : _calcOvlPartialTasks)
+    runGatherTask(nlp::profile::OpFamily::OVL, _gatherOvlGradTask);
+    #pragma omp parallel
     {
-        op.regTask(tfFlow);
-        _beginGradCalcTask.precede(op);
-        op.precede(_endGradCalcTask);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::OOB, _calcOobPartialTasks);
     }
-    for (auto & op : _calcOobPartialTasks)
+    runGatherTask(nlp::profile::OpFamily::OOB, _gatherOobGradTask);
+    #pragma omp parallel
     {
-        op.regTask(tfFlow);
-        _beginGradCalcTask.precede(op);
-        op.precede(_endGradCalcTask);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::ASYM, _calcAsymPartialTasks);
     }
-    for (auto & op : _calcAsymPartialTasks)
+    runGatherTask(nlp::profile::OpFamily::ASYM, _gatherAsymGradTask);
+    #pragma omp parallel
     {
-        op.regTask(tfFlow);
-        _beginGradCalcTask.precede(op);
-        op.precede(_endGradCalcTask);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::COS, _calcCosPartialTasks);
     }
-    for (auto & op : _calcCosPartialTasks)
+    runGatherTask(nlp::profile::OpFamily::COS, _gatherCosGradTask);
+    #pragma omp parallel
     {
-        op.regTask(tfFlow);
-        _beginGradCalcTask.precede(op);
-        op.precede(_endGradCalcTask);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::POWER_WL, _calcPowerWlPartialTasks);
+    }
+    runGatherTask(nlp::profile::OpFamily::POWER_WL, _gatherPowerWlGradTask);
+    #pragma omp parallel
+    {
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::CRF, _calcCrfPartialTasks);
+    }
+    runGatherTask(nlp::profile::OpFamily::CRF, _gatherCrfGradTask);
+    _sumGradTask.run();
+    clearFixedGrad();
+    if (needObj)
+    {
+        this->_objHpwl = hpwl.sumObj();
+        this->_objOvl = sumCalcTasksObj(_calcOvlPartialTasks);
+        this->_objOob = sumCalcTasksObj(_calcOobPartialTasks);
+        this->_objAsym = sumCalcTasksObj(_calcAsymPartialTasks);
+        this->_objCos = sumCalcTasksObj(_calcCosPartialTasks);
+        this->_objPowerWl = sumCalcTasksObj(_calcPowerWlPartialTasks);
+        this->_objCrf = sumCalcTasksObj(_calcCrfPartialTasks);
     }
 }
 
 template<typename nlp_settings>
-void NlpGPlacerFirstOrder<nlp_settings>::regCalcAllGradTaskFlow(tf::Taskflow &tfFlow)
+template<bool needObj>
+void NlpGPlacerFirstOrder<nlp_settings>::calcOpsInOneRegion()
 {
-    //_sumGradTask.regTask(tfFlow);
-    //_endGradCalcTask.regTask(tfFlow);
-    //this->regCalcHpwlGradTaskFlow(tfFlow);
-    //this->regCalcOvlGradTaskFlow(tfFlow);
-    //this->regCalcOobGradTaskFlow(tfFlow);
-    //this->regCalcAsymGradTaskFlow(tfFlow);
-    //this->regCalcCosGradTaskFlow(tfFlow);
-    //_sumHpwlGradTask.precede(_sumGradTask);
-    //_sumOvlGradTask.precede(_sumGradTask);
-    //_sumOobGradTask.precede(_sumGradTask);
-    //_sumAsymGradTask.precede(_sumGradTask);
-    //_sumCosGradTask.precede(_sumGradTask);
-    
-    this->regCalcGradForLoop(tfFlow);
+    _clearHpwlGradTask.run();
+    _clearOvlGradTask.run();
+    _clearOobGradTask.run();
+    _clearAsymGradTask.run();
+    _clearCosGradTask.run();
+    _clearPowerWlGradTask.run();
+    _clearCrfGradTask.run();
+    auto &hpwl = this->_hpwlBatch;
+    hpwl.prepare();
+    const IndexType numVariables = _grad.size();
+    /* Four phases separated by three barriers. Within a phase the threads move on to the next family without waiting:
+     * 1. the families not depending on the overlapping structure and the HPWL exponentials, while one thread refreshes the overlapping structure
+     * 2. the overlapping operators and the HPWL nets
+     * 3. gather the partials of every family
+     * 4. sum the gradient */
+    _profiler.countEval();
+    #pragma omp parallel
+    {
+        #pragma omp single nowait
+        {
+            base_type::ovl_ops_trait::refresh(*this);
+        }
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::OOB, _calcOobPartialTasks);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::ASYM, _calcAsymPartialTasks);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::COS, _calcCosPartialTasks);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::POWER_WL, _calcPowerWlPartialTasks);
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::CRF, _calcCrfPartialTasks);
+        auto start = _profiler.now();
+        hpwl.computeExpShared();
+        _profiler.addCalc(nlp::profile::OpFamily::HPWL, start);
+        #pragma omp barrier
+        runCalcTasksShared<needObj>(nlp::profile::OpFamily::OVL, _calcOvlPartialTasks);
+        start = _profiler.now();
+        hpwl.template calcNetsShared<needObj, true>();
+        _profiler.addCalc(nlp::profile::OpFamily::HPWL, start);
+        #pragma omp barrier
+        start = _profiler.now();
+        hpwl.gatherShared(_gradHpwl.data(), this->_numCells);
+        _profiler.addScatter(nlp::profile::OpFamily::HPWL, start);
+        runGatherTaskShared(nlp::profile::OpFamily::OVL, _gatherOvlGradTask);
+        runGatherTaskShared(nlp::profile::OpFamily::OOB, _gatherOobGradTask);
+        runGatherTaskShared(nlp::profile::OpFamily::ASYM, _gatherAsymGradTask);
+        runGatherTaskShared(nlp::profile::OpFamily::COS, _gatherCosGradTask);
+        runGatherTaskShared(nlp::profile::OpFamily::POWER_WL, _gatherPowerWlGradTask);
+        runGatherTaskShared(nlp::profile::OpFamily::CRF, _gatherCrfGradTask);
+        #pragma omp barrier
+        #pragma omp for schedule(static)
+        for (IndexType idx = 0; idx < numVariables; ++idx)
+        {
+            _grad(idx) = _gradHpwl(idx) + _gradOvl(idx) + _gradOob(idx) + _gradAsym(idx) + _gradCos(idx) + _gradPowerWl(idx) + _gradCrf(idx);
+        }
+    }
+    clearFixedGrad();
+    if (needObj)
+    {
+        this->_objHpwl = hpwl.sumObj();
+        this->_objOvl = sumCalcTasksObj(_calcOvlPartialTasks);
+        this->_objOob = sumCalcTasksObj(_calcOobPartialTasks);
+        this->_objAsym = sumCalcTasksObj(_calcAsymPartialTasks);
+        this->_objCos = sumCalcTasksObj(_calcCosPartialTasks);
+        this->_objPowerWl = sumCalcTasksObj(_calcPowerWlPartialTasks);
+        this->_objCrf = sumCalcTasksObj(_calcCrfPartialTasks);
+    }
 }
-#endif // IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
+
 
 
 #ifdef DEBUG_GR
@@ -1165,5 +1204,51 @@ PROJECT_NAMESPACE_BEGIN
 template class NlpGPlacerBase<nlp::nlp_default_settings>;
 template class NlpGPlacerFirstOrder<nlp::nlp_default_settings>;
 template class NlpGPlacerSecondOrder<nlp::nlp_default_settings>;
+template class NlpGPlacerBase<nlp::nlp_full_hpwl_hessian_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_full_hpwl_hessian_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_full_hpwl_hessian_settings>;
+template class NlpGPlacerBase<nlp::nlp_density_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_density_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_density_settings>;
+template class NlpGPlacerBase<nlp::nlp_float_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_float_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_float_settings>;
+template class NlpGPlacerBase<nlp::nlp_float_density_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_float_density_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_float_density_settings>;
+template class NlpGPlacerBase<nlp::nlp_mixed_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_mixed_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_mixed_settings>;
+template class NlpGPlacerBase<nlp::nlp_mixed_density_settings>;
+template class NlpGPlacerFirstOrder<nlp::nlp_mixed_density_settings>;
+template class NlpGPlacerSecondOrder<nlp::nlp_mixed_density_settings>;
+template class NlpGPlacerBase<nlp::nlp_adam_bb_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_adam_bb_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerBase<nlp::nlp_adam_bb_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_adam_bb_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerBase<nlp::nlp_nesterov_armijo_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_nesterov_armijo_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerBase<nlp::nlp_nesterov_armijo_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_nesterov_armijo_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_default_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_density_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_adam_bb_settings<nlp::nlp_default_settings>>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_adam_bb_settings<nlp::nlp_default_settings>>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_adam_bb_settings<nlp::nlp_density_settings>>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_adam_bb_settings<nlp::nlp_density_settings>>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_nesterov_armijo_settings<nlp::nlp_default_settings>>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_nesterov_armijo_settings<nlp::nlp_default_settings>>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_nesterov_armijo_settings<nlp::nlp_density_settings>>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_nesterov_armijo_settings<nlp::nlp_density_settings>>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_float_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_float_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_float_density_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_float_density_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_mixed_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_mixed_settings>>;
+template class NlpGPlacerBase<nlp::nlp_warm_start_settings<nlp::nlp_mixed_density_settings>>;
+template class NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp::nlp_mixed_density_settings>>;
 
 PROJECT_NAMESPACE_END
@@ -9,19 +9,24 @@
 #define IDEAPLACE_NLPGPLACER_H_
 
 #include <Eigen/Dense>
-#ifdef IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
-#include <taskflow/taskflow.hpp>
-#endif // IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ
+#include <Eigen/Sparse>
 #include "db/Database.h"
 #include "place/different.h"
 #include "place/differentSecondOrder.hpp"
 #include "place/nlp/nlpOuterOptm.hpp"
 #include "place/nlp/nlpInitPlace.hpp"
+#include "place/nlp/nlpOverlapOps.hpp"
+#include "place/nlp/nlpHpwlBatch.hpp"
 #include "place/nlp/nlpTasks.hpp"
 #include "place/nlp/nlpTypes.hpp"
 #include "place/nlp/nlpOptmKernels.hpp"
 #include "place/nlp/nlpFirstOrderKernel.hpp"
 #include "place/nlp/nlpSecondOrderKernels.hpp"
+#include "place/nlp/nlpMultiStart.hpp"
+#include "place/nlp/nlpCheckpoint.hpp"
+#include "place/nlp/nlpTimeBudget.hpp"
+#include "place/nlp/nlpProfile.hpp"
+#include "place/nlp/nlpTrace.hpp"
 #include "place/nlp/conjugateGradientWnlib.hpp" // TODO: remove after no need
 #include "pinassign/VirtualPinAssigner.h"
 PROJECT_NAMESPACE_BEGIN
@@ -34,22 +39,35 @@ namespace nlp
     {
     };
 
-    struct nlp_default_types
+    /// @brief the types of the problem in a precision
+    /// @tparam the type of the placement variables. The gradients, the hessians and the optimizer states are kept in this type too
+    /// @tparam the type the operators are evaluated in
+    template<typename coordinate_type, typename numerical_type>
+    struct nlp_types_with_precision
     {
-        typedef RealType nlp_coordinate_type;
-        typedef RealType nlp_numerical_type;
-        typedef Eigen::Matrix<nlp_numerical_type, Eigen::Dynamic, Eigen::Dynamic> EigenMatrix;
-        typedef Eigen::Matrix<nlp_numerical_type, Eigen::Dynamic, 1> EigenVector;
+        typedef coordinate_type nlp_coordinate_type;
+        typedef numerical_type nlp_numerical_type;
+        typedef Eigen::Matrix<nlp_coordinate_type, Eigen::Dynamic, Eigen::Dynamic> EigenMatrix;
+        typedef Eigen::SparseMatrix<nlp_coordinate_type> EigenSparseMatrix;
+        typedef Eigen::Matrix<nlp_coordinate_type, Eigen::Dynamic, 1> EigenVector;
         typedef Eigen::Map<EigenVector> EigenMap;
-        typedef Eigen::DiagonalMatrix<nlp_numerical_type, Eigen::Dynamic> EigenDiagonalMatrix;
+        typedef Eigen::DiagonalMatrix<nlp_coordinate_type, Eigen::Dynamic> EigenDiagonalMatrix;
         typedef diff::LseHpwlDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_hpwl_type;
-        typedef diff::CellPairOverlapPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_ovl_type;
+        typedef diff::CellPairOverlapNeighborListPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_ovl_type;
         typedef diff::CellOutOfBoundaryPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_oob_type;
         typedef diff::AsymmetryDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_asym_type;
         typedef diff::CosineDatapathDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_cos_type;
         typedef diff::PowerVerQuadraticWireLengthDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_power_wl_type;
         typedef diff::CurrentFlowDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_crf_type;
     };
+
+    struct nlp_default_types : public nlp_types_with_precision<RealType, RealType> {};
+
+    /// @brief everything in single precision
+    struct nlp_float_types : public nlp_types_with_precision<float, float> {};
+
+    /// @brief the variables and the optimizer states in double precision. The operators are evaluated in single precision
+    struct nlp_mixed_types : public nlp_types_with_precision<RealType, float> {};
     
     struct nlp_default_zero_order_algorithms
     {
@@ -69,6 +87,8 @@ namespace nlp
     struct nlp_default_first_order_algorithms
     {
         typedef converge::converge_list<
+                    converge::converge_criteria_trace,
+                    converge::converge_criteria_time_budget,
                     converge::converge_grad_norm_by_init<nlp_default_types::nlp_numerical_type>,
                     converge::converge_criteria_max_iter<3000>
                         >
@@ -107,9 +127,19 @@ namespace nlp
     };
 
 
+    /// @brief the exact hessian of the HPWL, which couples the pins of a net, and the jacobi approximation of the rest.
+    /// The hessian is then a sparse matrix, and the newton direction is from a sparse LDLT solve
+    template<typename nlp_types>
+    struct nlp_full_hpwl_hessian_second_order_settings : public nlp_default_second_order_settings<nlp_types>
+    {
+        typedef diff::full_hessian_trait<typename nlp_types::nlp_hpwl_type> hpwl_hessian_trait;
+    };
+
     struct nlp_default_second_order_algorithms
     {
         typedef converge::converge_list<
+                    converge::converge_criteria_trace,
+                    converge::converge_criteria_time_budget,
                     converge::converge_grad_norm_by_init<nlp_default_types::nlp_numerical_type>,
                     converge::converge_criteria_max_iter<3000>
                         >
@@ -144,6 +174,141 @@ namespace nlp
         typedef nlp_default_second_order_algorithms nlp_second_order_algorithms_type;
     };
 
+    /// @brief the second-order placer with the exact HPWL hessian
+    struct nlp_full_hpwl_hessian_settings : public nlp_default_settings
+    {
+        typedef nlp_full_hpwl_hessian_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+    };
+
+    /// @brief the electrostatic density penalty instead of the pair-wise overlapping. For large designs
+    struct nlp_density_types : public nlp_default_types
+    {
+        typedef diff::ElectrostaticDensityPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_ovl_type;
+    };
+
+    struct nlp_density_settings : public nlp_default_settings
+    {
+        typedef nlp_density_types nlp_types_type;
+        typedef nlp_default_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+    };
+
+    /* Single precision. The outer problem (multipliers, alpha and the stopping conditions) stays in RealType */
+
+    struct nlp_float_first_order_algorithms : public nlp_default_first_order_algorithms
+    {
+        typedef optm::first_order::adam<converge_type, nlp_float_types::nlp_coordinate_type> optm_type;
+    };
+
+    struct nlp_float_second_order_algorithms : public nlp_default_second_order_algorithms
+    {
+        typedef optm::second_order::adam<converge_type, nlp_float_types::nlp_coordinate_type> optm_type;
+    };
+
+    struct nlp_float_settings : public nlp_default_settings
+    {
+        typedef nlp_float_first_order_algorithms nlp_first_order_algorithms_type;
+        typedef nlp_float_types nlp_types_type;
+        typedef nlp_default_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+        typedef nlp_float_second_order_algorithms nlp_second_order_algorithms_type;
+    };
+
+    struct nlp_float_density_types : public nlp_float_types
+    {
+        typedef diff::ElectrostaticDensityPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_ovl_type;
+    };
+
+    struct nlp_float_density_settings : public nlp_float_settings
+    {
+        typedef nlp_float_density_types nlp_types_type;
+        typedef nlp_default_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+    };
+
+    /* Mixed precision. The operators in single precision, and the rest same as the default */
+
+    struct nlp_mixed_settings : public nlp_default_settings
+    {
+        typedef nlp_mixed_types nlp_types_type;
+        typedef nlp_default_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+    };
+
+    struct nlp_mixed_density_types : public nlp_mixed_types
+    {
+        typedef diff::ElectrostaticDensityPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_ovl_type;
+    };
+
+    struct nlp_mixed_density_settings : public nlp_mixed_settings
+    {
+        typedef nlp_mixed_density_types nlp_types_type;
+        typedef nlp_default_second_order_settings<nlp_types_type> nlp_second_order_setting_type;
+    };
+
+    /* Warm start from the placement in the database, e.g. interpolated from a coarser level. Same as the base settings otherwise */
+
+    template<typename zero_order_algorithms>
+    struct nlp_warm_start_zero_order_algorithms : public zero_order_algorithms
+    {
+        typedef outer_stop_condition::stop_condition_list<
+            outer_stop_condition::stop_after_violate_small,
+            outer_stop_condition::stop_after_num_outer_iterations<20>
+            > stop_condition_type;
+        typedef init_place::init_from_database init_place_type;
+    };
+
+    /// @brief no plain gradient descent warm-up, since the cells are already spread.
+    /// The alpha of the penalties follows the penalties from a small max alpha.
+    /// The default reciprocal update assumes that the penalties start high, and would keep growing alpha if they increase from the small initial values
+    template<typename first_order_algorithms, typename nlp_numerical_type>
+    struct nlp_warm_start_first_order_algorithms : public first_order_algorithms
+    {
+        typedef typename first_order_algorithms::converge_type converge_type;
+        typedef optm::first_order::adam<converge_type, nlp_numerical_type, optm::step_size::constant<0>> optm_type;
+        typedef alpha::update::alpha_update_list<
+                alpha::update::linear_by_obj<nlp_default_types::nlp_numerical_type, 1, std::ratio<3, 5>>,
+                alpha::update::linear_by_obj<nlp_default_types::nlp_numerical_type, 2, std::ratio<3, 5>>,
+                alpha::update::linear_by_obj<nlp_default_types::nlp_numerical_type, 3, std::ratio<3, 5>>
+            > alpha_update_type;
+    };
+
+    template<typename nlp_settings>
+    struct nlp_warm_start_settings : public nlp_settings
+    {
+        typedef nlp_warm_start_zero_order_algorithms<typename nlp_settings::nlp_zero_order_algorithms_type> nlp_zero_order_algorithms_type;
+        typedef nlp_warm_start_first_order_algorithms<typename nlp_settings::nlp_first_order_algorithms_type,
+                typename nlp_settings::nlp_types_type::nlp_numerical_type> nlp_first_order_algorithms_type;
+    };
+
+    /* Other step size policies of the first-order kernel. Same as the base settings otherwise */
+
+    template<typename first_order_algorithms, typename nlp_numerical_type>
+    struct nlp_adam_bb_first_order_algorithms : public first_order_algorithms
+    {
+        typedef optm::first_order::adam<typename first_order_algorithms::converge_type, nlp_numerical_type,
+                optm::step_size::barzilai_borwein<nlp_numerical_type>> optm_type;
+    };
+
+    /// @brief adam with Barzilai-Borwein steps in the warm-up
+    template<typename nlp_settings>
+    struct nlp_adam_bb_settings : public nlp_settings
+    {
+        typedef nlp_adam_bb_first_order_algorithms<typename nlp_settings::nlp_first_order_algorithms_type,
+                typename nlp_settings::nlp_types_type::nlp_numerical_type> nlp_first_order_algorithms_type;
+    };
+
+    template<typename first_order_algorithms, typename nlp_numerical_type>
+    struct nlp_nesterov_armijo_first_order_algorithms : public first_order_algorithms
+    {
+        typedef optm::first_order::nesterov<typename first_order_algorithms::converge_type, nlp_numerical_type,
+                optm::step_size::adaptive_restart<optm::step_size::armijo_backtracking<nlp_numerical_type>>> optm_type;
+    };
+
+    /// @brief nesterov with Armijo backtracking steps and the adaptive restart of the momentum
+    template<typename nlp_settings>
+    struct nlp_nesterov_armijo_settings : public nlp_settings
+    {
+        typedef nlp_nesterov_armijo_first_order_algorithms<typename nlp_settings::nlp_first_order_algorithms_type,
+                typename nlp_settings::nlp_types_type::nlp_numerical_type> nlp_first_order_algorithms_type;
+    };
+
 
 }// namespace nlp
 
@@ -178,6 +343,8 @@ class NlpGPlacerBase
         typedef typename nlp_zero_order_algorithms::init_place_type init_placement_type;
         typedef nlp::init_place::init_place_trait<init_placement_type> init_place_trait;
         friend init_place_trait;
+        typedef nlp::ovl_ops::ovl_ops_trait<nlp_ovl_type> ovl_ops_trait;
+        friend ovl_ops_trait;
         typedef typename nlp_zero_order_algorithms::mult_init_type mult_init_type;
         typedef nlp::outer_multiplier::init::multiplier_init_trait<mult_init_type> mult_init_trait;
         friend mult_init_trait;
@@ -189,11 +356,40 @@ class NlpGPlacerBase
         friend mult_trait;
     
     public:
-        explicit NlpGPlacerBase(Database &db) : _db(db) {}
+        explicit NlpGPlacerBase(Database &db) : _db(db), _pinAssigner(db) {}
         IntType solve();
+        /// @brief run as one of the concurrent runs of a multi-start. The progress is reported to the monitor after each outer iteration
+        /// @param the monitor shared by the runs
+        /// @param the index of this run
+        /// @param the stage of this run, e.g. the level of a multilevel placement
+        void setMultiStartMonitor(nlp::MultiStartMonitor *monitor, IndexType runIdx, IndexType stage = 0)
+        {
+            _multiStartMonitor = monitor;
+            _multiStartRunIdx = runIdx;
+            _multiStartStage = stage;
+        }
+        /// @brief add the counters of the operator families to a profile at the end of the run. Not thread-safe, so each concurrent run needs its own
+        /// @param the profile. nullptr to not profile
+        void setProfile(nlp::profile::Profile *profile) { _profile = profile; }
 
     protected:
         void assignIoPins();
+        /// @brief report the objective without the multipliers to the multi-start monitor, so that the runs are comparable
+        /// @return whether this run has been cancelled
+        bool reportToMultiStart()
+        {
+            if (_multiStartMonitor == nullptr)
+            {
+                return false;
+            }
+            const RealType obj = _objHpwlRaw + _objOvlRaw + _objOobRaw + _objAsymRaw;
+            return _multiStartMonitor->report(_multiStartRunIdx, obj, _multiStartStage);
+        }
+        /// @brief the name of a stop watch, with the suffix of the run in a multi-start
+        std::string stopWatchName(const std::string &name) const
+        {
+            return _db.stopWatchName(nlp::MultiStartMonitor::stopWatchName(name, _multiStartMonitor, _multiStartRunIdx));
+        }
         /* calculating obj */
         void calcObj()
         {
@@ -256,13 +452,21 @@ class NlpGPlacerBase
         nlp_numerical_type _objCosRaw = 0.0; ///< The current value for the cosine signal path penalty
         nlp_numerical_type _objPowrWlRaw = 0.0; ///< Power wire length
         nlp_numerical_type _objCrfRaw = 0.0; ///< Current flow
+        std::uint64_t _numObjEvals = 0; ///< The number of evaluations of the objectives so far. The trace records the objectives only when it changes
         /* NLP optimization kernel memebers */
         stop_condition_type _stopCondition;
+        nlp::MultiStartMonitor *_multiStartMonitor = nullptr; ///< Shared by the runs of a multi-start. nullptr if running alone
+        IndexType _multiStartRunIdx = 0; ///< The index of this run in the multi-start
+        IndexType _multiStartStage = 0; ///< The stage of this run in the multi-start
+        nlp::profile::Profile *_profile = nullptr; ///< Where the counters are added at the end of the run. nullptr if not profiled
+        nlp::TimeBudget _timeBudget; ///< The wall-clock budget of the run. Started in solve()
+        nlp::trace::TraceRecorder _trace; ///< The convergence trace. Disabled unless a trace file is set
+        VirtualPinAssigner _pinAssigner; ///< Kept across the outer iterations, so that the pin assignment is updated incrementally
         /* Optimization data */
         EigenVector _pl; ///< The placement solutions
         /* Tasks */
         // Evaluating objectives
-        std::vector<nt::Task<nt::EvaObjTask<nlp_numerical_type>>> _evaHpwlTasks; ///< The tasks for evaluating hpwl objectives
+        std::vector<nt::Task<nt::EvaObjTask<nlp_numerical_type>>> _evaHpwlTasks; ///< The task for evaluating hpwl objectives. A single one running _hpwlBatch
         std::vector<nt::Task<nt::EvaObjTask<nlp_numerical_type>>> _evaOvlTasks; ///< The tasks for evaluating overlap objectives
         std::vector<nt::Task<nt::EvaObjTask<nlp_numerical_type>>> _evaOobTasks; ///< The tasks for evaluating out of boundary objectives
         std::vector<nt::Task<nt::EvaObjTask<nlp_numerical_type>>> _evaAsymTasks;  ///< The tasks for evaluating asymmetry objectives
@@ -289,6 +493,7 @@ class NlpGPlacerBase
         nt::Task<nt::FuncTask> _wrapObjAllTask;
         /* Operators */
         std::vector<nlp_hpwl_type> _hpwlOps; ///< The HPWL cost 
+        nlp::LseHpwlBatch<nlp_hpwl_type> _hpwlBatch; ///< The batched evaluation of all the HPWL operators
         std::vector<nlp_ovl_type> _ovlOps; ///< The cell pair overlapping penalty operators
         std::vector<nlp_oob_type> _oobOps; ///< The cell out of boundary penalty operators 
         std::vector<nlp_asym_type> _asymOps; ///< The asymmetric penalty operators
@@ -334,6 +539,7 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         typedef typename base_type::nlp_cos_type nlp_cos_type;
         typedef typename base_type::nlp_power_wl_type nlp_power_wl_type;
         typedef typename base_type::nlp_crf_type nlp_crf_type;
+        typedef typename base_type::nlp_numerical_type nlp_numerical_type;
 
         typedef typename nlp_settings::nlp_first_order_algorithms_type nlp_first_order_algorithms;
         typedef typename nlp_first_order_algorithms::converge_type converge_type;
@@ -344,8 +550,13 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         friend converge_type;
         template<typename converge_criteria_type>
         friend struct nlp::converge::converge_criteria_trait;
+        friend class nlp::trace::TraceRecorder;
         friend optm_type;
         friend optm_trait;
+        template<typename step_size_type>
+        friend struct nlp::optm::step_size::step_size_trait;
+        template<typename snapshot_numerical_type>
+        friend struct nlp::optm::step_size::objective_snapshot;
 
         typedef typename nlp_settings::nlp_first_order_algorithms_type::mult_init_type mult_init_type;
         typedef nlp::outer_multiplier::init::multiplier_init_trait<mult_init_type> mult_init_trait;
@@ -394,13 +605,13 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
                 }
             }
             auto getLambda = [&](){ return 1.0; };
-            for (auto &op : this->_hpwlOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_cosOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_ovlOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_oobOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_asymOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_powerWlOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
-            for (auto &op : this->_crfOps) { op._getLambdaFunc = [&](){ return 1.0; }; }
+            for (auto &op : this->_hpwlOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_cosOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_ovlOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_oobOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_asymOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_powerWlOps) { op._getLambdaFunc = 1.0; }
+            for (auto &op : this->_crfOps) { op._getLambdaFunc = 1.0; }
             for (RealType x = -8; x < 8; x+=(16.0/300))
             {
                 for (RealType y = -8; y < 8; y+=(16.0/300))
@@ -419,6 +630,19 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         {
             _wrapCalcGradTask.run();
         }
+        /// @brief calculate the objective and the gradient in one pass over the operators
+        void calcObjAndGrad()
+        {
+            _wrapCalcObjAndGradTask.run();
+        }
+        /// @brief keep the fixed cells in place by zeroing their gradient. The kernels only move the variables along the gradient
+        void clearFixedGrad()
+        {
+            for (IndexType idx : _fixedVars)
+            {
+                _grad(idx) = 0;
+            }
+        }
         /* Init */
         virtual void initProblem() override;
         void initFirstOrderGrad();
@@ -426,22 +650,32 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         virtual void constructTasks() override;
         void constructFirstOrderTasks();
         void constructCalcPartialsTasks();
-        void constructUpdatePartialsTasks();
+        void constructGatherPartialsTasks();
         void constructClearGradTasks();
         void constructSumGradTask();
         void constructWrapCalcGradTask();
+        void constructWrapCalcObjAndGradTask();
+        /* Run the calculating tasks of all the operators, and gather the gradient. Evaluate the objectives too if needObj */
+        template<bool needObj>
+        void calcOpsPerFamily();
+        template<bool needObj>
+        void calcOpsInOneRegion();
+        /// @brief the HPWL operators in three phases. Inside a parallel region
+        template<bool needObj>
+        void calcHpwlShared();
+        /// @brief run the calculating tasks of a family as a worksharing loop without the implied barrier. Inside a parallel region
+        template<bool needObj, typename calc_task_vector_type>
+        void runCalcTasksShared(nlp::profile::OpFamily family, calc_task_vector_type &calcTasks);
+        /// @brief run a gathering task and count its time to a family
+        template<typename gather_task_type>
+        void runGatherTask(nlp::profile::OpFamily family, gather_task_type &gatherTask);
+        /// @brief run a gathering task as a worksharing loop and count its time to a family. Inside a parallel region
+        template<typename op_type>
+        void runGatherTaskShared(nlp::profile::OpFamily family, nt::Task<nt::GatherGradientFromPartialTask<op_type, EigenVector>> &gatherTask);
+        template<typename calc_task_vector_type>
+        static nlp_numerical_type sumCalcTasksObj(const calc_task_vector_type &calcTasks);
         /* optimization */
         virtual void optimize() override;
-        /* Build the computational graph */
-#ifdef IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
-        void regCalcHpwlGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcOvlGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcOobGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcAsymGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcCosGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcAllGradTaskFlow(tf::Taskflow &tfFlow);
-        void regCalcGradForLoop(tf::Taskflow &tfFlow);
-#endif
         
 
     protected:
@@ -454,23 +688,24 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         EigenVector _gradCos; ///< The first order gradient of cosine signal path objective
         EigenVector _gradPowerWl;
         EigenVector _gradCrf;
+        std::vector<IndexType> _fixedVars; ///< The variables of the fixed cells
+        nlp::profile::OpProfiler _profiler; ///< The counters of the operator families
         /* Tasks */
         // Calculate the partials
-        std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_hpwl_type, EigenVector>>> _calcHpwlPartialTasks;
+        // The HPWL partials are calculated by the batched kernel
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_ovl_type,  EigenVector>>> _calcOvlPartialTasks;
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_oob_type,  EigenVector>>> _calcOobPartialTasks;
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_asym_type, EigenVector>>> _calcAsymPartialTasks;
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_cos_type,  EigenVector>>> _calcCosPartialTasks;
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_power_wl_type,  EigenVector>>> _calcPowerWlPartialTasks;
         std::vector<nt::Task<nt::CalculateOperatorPartialTask<nlp_crf_type,  EigenVector>>> _calcCrfPartialTasks;
-        // Update the partials
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_hpwl_type, EigenVector>>> _updateHpwlPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_ovl_type,  EigenVector>>> _updateOvlPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_oob_type,  EigenVector>>> _updateOobPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_asym_type, EigenVector>>> _updateAsymPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_cos_type,  EigenVector>>> _updateCosPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_power_wl_type,  EigenVector>>> _updatePowerWlPartialTasks;
-        std::vector<nt::Task<nt::UpdateGradientFromPartialTask<nlp_crf_type,  EigenVector>>> _updateCrfPartialTasks;
+        // Gather the partials into the gradients in parallel
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_ovl_type, EigenVector>> _gatherOvlGradTask;
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_oob_type, EigenVector>> _gatherOobGradTask;
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_asym_type, EigenVector>> _gatherAsymGradTask;
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_cos_type, EigenVector>> _gatherCosGradTask;
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_power_wl_type, EigenVector>> _gatherPowerWlGradTask;
+        nt::Task<nt::GatherGradientFromPartialTask<nlp_crf_type, EigenVector>> _gatherCrfGradTask;
         // Clear the gradient. Use to clear the _gradxxx records. Needs to call before updating the partials
         nt::Task<nt::FuncTask> _clearGradTask; //FIXME: not used right noe
         nt::Task<nt::FuncTask> _clearHpwlGradTask;
@@ -482,15 +717,9 @@ class NlpGPlacerFirstOrder : public NlpGPlacerBase<nlp_settings>
         nt::Task<nt::FuncTask> _clearCrfGradTask;
         // Sum the _grad from individual
         nt::Task<nt::FuncTask> _sumGradTask;
-        nt::Task<nt::FuncTask> _sumHpwlGradTask;
-        nt::Task<nt::FuncTask> _sumOvlGradTask;
-        nt::Task<nt::FuncTask> _sumOobGradTask;
-        nt::Task<nt::FuncTask> _sumAsymGradTask;
-        nt::Task<nt::FuncTask> _sumCosGradTask;
-        nt::Task<nt::FuncTask> _sumPowerWlTaskGradTask;
-        nt::Task<nt::FuncTask> _sumCrfGradTask;
         // all the grads has been calculated but have not updated
         nt::Task<nt::FuncTask> _wrapCalcGradTask; ///<  calculating the gradient and sum them
+        nt::Task<nt::FuncTask> _wrapCalcObjAndGradTask; ///< calculating the objectives and the gradient together and sum them
         /* run time */
         std::unique_ptr<::klib::StopWatch> _calcGradStopWatch;
         std::unique_ptr<::klib::StopWatch> _optimizerKernelStopWatch;
@@ -504,33 +733,45 @@ namespace _nlp_second_order_details
     template<typename nlp_settings, BoolType is_diagonal>
     struct is_diagonal_select {};
 
+    /// @brief diagonal hessian. Only the diagonal entries are stored in a vector
     template<typename nlp_settings>
     struct is_diagonal_select<nlp_settings, true>
     {
-        typedef typename nlp_settings::nlp_types_type::EigenMatrix matrix_type;
+        typedef typename nlp_settings::nlp_types_type::EigenVector matrix_type;
         static void resize(matrix_type &matrix, IntType size)
         {
-            matrix.resize(size, size);
+            matrix.resize(size);
         }
 
-        static decltype(auto) inverse(matrix_type &matrix)
+        /// @brief solve matrix * x = rhs
+        template<typename vector_type>
+        static vector_type solve(const matrix_type &matrix, const vector_type &rhs)
         {
-            return matrix.diagonal().cwiseInverse().asDiagonal();
+            return rhs.cwiseQuotient(matrix);
         }
     };
 
+    /// @brief full hessian. Stored as a sparse matrix, since an operator only couples a few cells
     template<typename nlp_settings>
     struct is_diagonal_select<nlp_settings, false>
     {
-        typedef typename nlp_settings::nlp_types_type::EigenMatrix matrix_type;
+        typedef typename nlp_settings::nlp_types_type::EigenSparseMatrix matrix_type;
         static void resize(matrix_type &matrix, IntType size)
         {
             matrix.resize(size, size);
         }
-        static decltype(auto) inverse(matrix_type &matrix)
+        /// @brief solve matrix * x = rhs with a sparse LDLT factorization.
+        /// clipHessian() keeps the matrix positive definite. If the factorization still breaks down, it falls back to the diagonal of the matrix
+        template<typename vector_type>
+        static vector_type solve(const matrix_type &matrix, const vector_type &rhs)
         {
-            Assert(false);
-            return matrix.diagonal().cwiseInverse();
+            Eigen::SimplicialLDLT<matrix_type> ldlt(matrix);
+            if (ldlt.info() == Eigen::Success and (ldlt.vectorD().array() > 0).all())
+            {
+                return ldlt.solve(rhs);
+            }
+            WRN("NlpGPlacer: the hessian is not positive definite. Use its diagonal \n");
+            return rhs.cwiseQuotient(matrix.diagonal());
         }
     };
 
@@ -539,6 +780,95 @@ namespace _nlp_second_order_details
     {
         hessian_target_type &target;
     };
+
+    template<typename matrix_type>
+    constexpr bool is_sparse_v = std::is_base_of<Eigen::SparseMatrixBase<matrix_type>, matrix_type>::value;
+
+    /// @brief add the hessians of the tasks to their target.
+    /// For a sparse target, the nonzero entries of all the tasks are assembled in one pass, which sums the duplicated entries
+    template<typename task_type, typename target_type>
+    inline void updateHessian(std::vector<task_type> &tasks, target_type &target)
+    {
+        if constexpr (is_sparse_v<target_type>)
+        {
+            std::vector<typename task_type::triplet_type> triplets;
+            IndexType numTriplets = 0;
+            for (const auto &task : tasks) { numTriplets += task.triplets().size(); }
+            triplets.reserve(numTriplets);
+            for (const auto &task : tasks)
+            {
+                triplets.insert(triplets.end(), task.triplets().begin(), task.triplets().end());
+            }
+            target.setFromTriplets(triplets.begin(), triplets.end());
+        }
+        else
+        {
+            for (auto &task : tasks) { task.update(); }
+        }
+    }
+
+    /// @brief add a hessian to another. A diagonal hessian stored as a vector is added to the diagonal of a full one
+    template<typename target_type, typename source_type>
+    inline void addHessian(target_type &target, const source_type &source)
+    {
+        if constexpr (source_type::ColsAtCompileTime == 1 and target_type::ColsAtCompileTime != 1)
+        {
+            if constexpr (is_sparse_v<target_type>)
+            {
+                target += source.asDiagonal();
+            }
+            else
+            {
+                target.diagonal() += source;
+            }
+        }
+        else
+        {
+            target += source;
+        }
+    }
+
+    /// @brief clip the diagonal of a hessian into [minBound, maxBound].
+    /// The off-diagonal entries of a full hessian are kept, since clipping them into a positive range would change their signs.
+    /// Instead, a diagonal entry is raised to at least the sum of the magnitudes of the off-diagonal entries in its column plus minBound,
+    /// so that the matrix stays diagonally dominant and positive definite
+    template<typename matrix_type, typename num_type>
+    inline void clipHessian(matrix_type &matrix, num_type minBound, num_type maxBound)
+    {
+        if constexpr (is_sparse_v<matrix_type>)
+        {
+            typedef typename matrix_type::Scalar scalar_type;
+            const scalar_type lo = static_cast<scalar_type>(minBound);
+            const scalar_type hi = static_cast<scalar_type>(maxBound);
+            // coeffRef inserts the missing diagonal entries, so that the variables without any hessian are at minBound
+            for (IndexType idx = 0; idx < static_cast<IndexType>(matrix.rows()); ++idx)
+            {
+                matrix.coeffRef(idx, idx);
+            }
+            matrix.makeCompressed();
+            for (IndexType col = 0; col < static_cast<IndexType>(matrix.outerSize()); ++col)
+            {
+                scalar_type *diagonal = nullptr;
+                scalar_type offDiagonal = 0;
+                for (typename matrix_type::InnerIterator it(matrix, col); it; ++it)
+                {
+                    if (static_cast<IndexType>(it.row()) == col)
+                    {
+                        diagonal = &it.valueRef();
+                    }
+                    else
+                    {
+                        offDiagonal += std::abs(it.value());
+                    }
+                }
+                *diagonal = std::max(std::min(std::max(*diagonal, lo), hi), offDiagonal + lo);
+            }
+        }
+        else
+        {
+            matrix = matrix.cwiseMax(minBound).cwiseMin(maxBound);
+        }
+    }
 };
 
 /// @brief first-order optimization
@@ -555,6 +885,7 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
         typedef typename nlp_settings::nlp_second_order_setting_type second_order_setting_type;
 
         typedef typename first_order_type::EigenMatrix EigenMatrix;
+        typedef typename first_order_type::EigenVector EigenVector;
 
         typedef typename first_order_type::nlp_hpwl_type nlp_hpwl_type;
         typedef typename first_order_type::nlp_ovl_type nlp_ovl_type;
@@ -620,6 +951,7 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
         friend converge_type;
         template<typename converge_criteria_type>
         friend struct nlp::converge::converge_criteria_trait;
+        friend class nlp::trace::TraceRecorder;
         friend optm_type;
         friend optm_trait;
 
@@ -654,9 +986,10 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
 
         NlpGPlacerSecondOrder(Database &db) : NlpGPlacerFirstOrder<nlp_settings>(db) {}
     public:
-        decltype(auto) inverseHessian()
+        /// @brief the newton direction of a vector, i.e. the inverse of the hessian times the vector
+        EigenVector newtonDirection(const EigenVector &vec) const
         {
-            return hessian_diagonal_selector::inverse(_hessian);
+            return hessian_diagonal_selector::solve(_hessian, vec);
         }
         void calcHessian()
         {
@@ -678,8 +1011,7 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
             WATCH_QUICK_START();
             // setting up the multipliers
             this->assignIoPins();
-            this->_wrapObjAllTask.run();
-            this->_wrapCalcGradTask.run();
+            this->calcObjAndGrad();
             calcHessian();
 
             optm_type optm;
@@ -767,6 +1099,7 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
         {
             #pragma omp parallel for schedule(static)
             for (IndexType i = 0; i < _calcHpwlHessianTasks.size(); ++i) { _calcHpwlHessianTasks[i].calc(); }
+            base_type::ovl_ops_trait::refresh(*this);
             #pragma omp parallel for schedule(static)
             for (IndexType i = 0; i < _calcOvlHessianTasks.size(); ++i) { _calcOvlHessianTasks[i].calc(); }
             #pragma omp parallel for schedule(static)
@@ -785,35 +1118,40 @@ class NlpGPlacerSecondOrder : public NlpGPlacerFirstOrder<nlp_settings>
             {
                 if (i == 0)
                 {
-                    for (auto & calc : _calcHpwlHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcHpwlHessianTasks, _hessianHpwl);
                 }
                 else if (i == 1)
                 {
-                    for (auto & calc : _calcOvlHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcOvlHessianTasks, _hessianOvl);
                 }
                 else if (i == 2)
                 {
-                    for (auto & calc : _calcOobHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcOobHessianTasks, _hessianOob);
                 }
                 else if (i == 3)
                 {
-                    for (auto & calc : _calcAsymHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcAsymHessianTasks, _hessianAsym);
                 }
                 else if (i == 4)
                 {
-                    for (auto & calc : _calcCosHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcCosHessianTasks, _hessianCos);
                 }
                 else
                 {
-                    for (auto & calc : _calcPowerWlHessianTasks) { calc.update(); }
+                    _nlp_second_order_details::updateHessian(_calcPowerWlHessianTasks, _hessianPowerWl);
                 }
             }
-            _hessian = _hessianHpwl + _hessianOvl + _hessianOob + _hessianAsym + _hessianCos + _hessianPowerWl;
+            _nlp_second_order_details::addHessian(_hessian, _hessianHpwl);
+            _nlp_second_order_details::addHessian(_hessian, _hessianOvl);
+            _nlp_second_order_details::addHessian(_hessian, _hessianOob);
+            _nlp_second_order_details::addHessian(_hessian, _hessianAsym);
+            _nlp_second_order_details::addHessian(_hessian, _hessianCos);
+            _nlp_second_order_details::addHessian(_hessian, _hessianPowerWl);
         }
 
         void clipHessian()
         {
-            _hessian = _hessian.cwiseMin(hessianMinBound).cwiseMax(hessianMaxBound);
+            _nlp_second_order_details::clipHessian(_hessian, hessianMinBound, hessianMaxBound);
         }
         virtual void constructTasks() override
         {
@@ -853,6 +1191,7 @@ inline void NlpGPlacerSecondOrder<nlp_settings>::initSecondOrder()
     asym_hessian_diagonal_selector::resize(_hessianAsym, size);
     cos_hessian_diagonal_selector::resize(_hessianCos, size);
     power_wl_hessian_diagonal_selector::resize(_hessianPowerWl , size);
+    hessian_diagonal_selector::resize(_hessian, size);
 }
 
 
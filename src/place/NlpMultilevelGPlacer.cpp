@@ -0,0 +1,365 @@
+#include "NlpMultilevelGPlacer.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+template<typename nlp_settings>
+IntType NlpMultilevelGPlacer<nlp_settings>::solve()
+{
+    auto stopWatch = WATCH_CREATE_NEW(_db.stopWatchName(nlp::MultiStartMonitor::stopWatchName("NlpMultilevelGPlacer", _multiStartMonitor, _multiStartRunIdx)));
+    stopWatch->start();
+    // Coarsen. The levels are not moved after being built, so that each of them can refer to the finer one
+    std::vector<Level> levels;
+    levels.reserve(maxNumLevels);
+    const Database *fine = &_db;
+    while (levels.size() < maxNumLevels and fine->numCells() >= minNumCells)
+    {
+        levels.emplace_back();
+        if (!coarsen(*fine, levels.back()))
+        {
+            levels.pop_back();
+            break;
+        }
+        INF("Ideaplace multilevel global placement:: level %d: %d cells, %d nets \n", levels.size(), levels.back().db.numCells(), levels.back().db.numNets());
+        fine = &levels.back().db;
+    }
+    if (levels.empty())
+    {
+        NlpGPlacerFirstOrder<nlp_settings> placer(_db);
+        placer.setMultiStartMonitor(_multiStartMonitor, _multiStartRunIdx);
+        placer.setProfile(_profile);
+        placer.solve();
+        stopWatch->stop();
+        return 0;
+    }
+    // Split the time budget. Each coarse level takes a part of what remains, and the original problem takes the rest
+    const RealType budgetMs = _db.parameters().nlpTimeBudgetMs();
+    nlp::TimeBudget budget;
+    budget.start(budgetMs);
+    auto levelBudgetMs = [&](IndexType numRunsLeft)
+    {
+        return budget.enabled() ? std::max(budget.remainingMs() / (numRunsLeft + 1), 1.0) : budgetMs;
+    };
+    // Under a multi-start, the runs are compared level by level. A cancelled run skips the finer levels
+    auto cancelled = [&]()
+    {
+        return _multiStartMonitor != nullptr and _multiStartMonitor->cancelled(_multiStartRunIdx);
+    };
+    // Solve the coarsest level from scratch
+    {
+        levels.back().db.parameters().setNlpTimeBudgetMs(levelBudgetMs(levels.size() + 1));
+        NlpGPlacerFirstOrder<nlp_settings> placer(levels.back().db);
+        placer.setMultiStartMonitor(_multiStartMonitor, _multiStartRunIdx, levels.size());
+        placer.setProfile(_profile);
+        placer.solve();
+    }
+    // Refine
+    for (IndexType levelIdx = levels.size(); levelIdx > 0 and not cancelled(); --levelIdx)
+    {
+        Database &fineDb = levelIdx == 1 ? _db : levels.at(levelIdx - 2).db;
+        interpolate(levels.at(levelIdx - 1), fineDb);
+        INF("Ideaplace multilevel global placement:: refine level %d \n", levelIdx - 1);
+        fineDb.parameters().setNlpTimeBudgetMs(levelIdx == 1 ? (budget.enabled() ? std::max(budget.remainingMs(), 1.0) : budgetMs) : levelBudgetMs(levelIdx));
+        NlpGPlacerFirstOrder<nlp::nlp_warm_start_settings<nlp_settings>> placer(fineDb);
+        placer.setMultiStartMonitor(_multiStartMonitor, _multiStartRunIdx, levelIdx - 1);
+        placer.setProfile(_profile);
+        placer.solve();
+    }
+    _db.parameters().setNlpTimeBudgetMs(budgetMs);
+    stopWatch->stop();
+    return 0;
+}
+
+template<typename nlp_settings>
+bool NlpMultilevelGPlacer<nlp_settings>::coarsen(const Database &fine, Level &level)
+{
+    const IndexType numCells = fine.numCells();
+    level.clusterIdx.assign(numCells, INDEX_TYPE_MAX);
+    level.offset.assign(numCells, XY<LocType>(0, 0));
+    level.db.tech() = fine.tech();
+    level.db.parameters() = fine.parameters();
+    // Record into the stop watches of the placer, under the names of the level. The run suffix keeps the runs of a multi-start apart
+    level.db.setStopWatchScope(fine.stopWatchScope() + "coarse.");
+    level.db.parameters().closeVirtualPinAssignment();
+    // The checkpoints and the trace are of the original problem
+    level.db.parameters().setNlpCheckpoint("", 0);
+    level.db.parameters().setNlpResumeFile("");
+    level.db.parameters().setNlpTrace("", 0);
+
+    std::vector<bool> isSym(numCells, false);
+    for (const auto &symGrp : fine.vSymGrpArray())
+    {
+        for (const auto &symPair : symGrp.vSymPairs())
+        {
+            isSym[symPair.firstCell()] = true;
+            isSym[symPair.secondCell()] = true;
+        }
+        for (IndexType cellIdx : symGrp.vSelfSyms())
+        {
+            isSym[cellIdx] = true;
+        }
+    }
+    auto isFree = [&](IndexType cellIdx) { return level.clusterIdx[cellIdx] == INDEX_TYPE_MAX; };
+    // 1. The symmetric pairs side by side
+    for (const auto &symGrp : fine.vSymGrpArray())
+    {
+        for (const auto &symPair : symGrp.vSymPairs())
+        {
+            if (isFree(symPair.firstCell()) and isFree(symPair.secondCell()))
+            {
+                addCluster(fine, level, { symPair.firstCell(), symPair.secondCell() }, true);
+            }
+        }
+    }
+    // 2. The proximity groups
+    for (const auto &proximityGrp : fine.proximityGrps())
+    {
+        std::vector<IndexType> cells;
+        for (IndexType cellIdx : proximityGrp.cells())
+        {
+            if (isFree(cellIdx) and not isSym[cellIdx] and std::find(cells.begin(), cells.end(), cellIdx) == cells.end())
+            {
+                cells.emplace_back(cellIdx);
+            }
+        }
+        if (cells.size() > 1)
+        {
+            addCluster(fine, level, cells, false);
+        }
+    }
+    // 3. Match each small cell with its most strongly connected small neighbor, starting from the smallest
+    std::vector<IndexType> candidates;
+    for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+    {
+        if (isFree(cellIdx) and not isSym[cellIdx])
+        {
+            candidates.emplace_back(cellIdx);
+        }
+    }
+    auto cellArea = [&](IndexType cellIdx) { return static_cast<RealType>(fine.cell(cellIdx).cellBBox().area()); };
+    std::sort(candidates.begin(), candidates.end(), [&](IndexType lhs, IndexType rhs) { return cellArea(lhs) < cellArea(rhs); });
+    if (!candidates.empty())
+    {
+        const RealType smallArea = cellArea(candidates.at(candidates.size() / 2));
+        std::vector<bool> isCandidate(numCells, false);
+        for (IndexType cellIdx : candidates)
+        {
+            isCandidate[cellIdx] = cellArea(cellIdx) <= smallArea;
+        }
+        std::vector<RealType> connection(numCells, 0);
+        std::vector<IndexType> neighbors;
+        for (IndexType cellIdx : candidates)
+        {
+            if (not isCandidate[cellIdx] or not isFree(cellIdx))
+            {
+                continue;
+            }
+            neighbors.clear();
+            for (IndexType pinIdx : fine.cell(cellIdx).pins())
+            {
+                const auto &pin = fine.pin(pinIdx);
+                for (IndexType idx = 0; idx < pin.numNetIdx(); ++idx)
+                {
+                    const auto &net = fine.net(pin.netIdx(idx));
+                    if (net.numPinIdx() < 2 or net.numPinIdx() > maxNetDegree)
+                    {
+                        continue;
+                    }
+                    const RealType weight = static_cast<RealType>(net.weight()) / (net.numPinIdx() - 1);
+                    for (IndexType netPinIdx : net.pinIdxArray())
+                    {
+                        const IndexType otherCellIdx = fine.pin(netPinIdx).cellIdx();
+                        if (otherCellIdx == cellIdx or not isCandidate[otherCellIdx] or not isFree(otherCellIdx))
+                        {
+                            continue;
+                        }
+                        if (connection[otherCellIdx] == 0)
+                        {
+                            neighbors.emplace_back(otherCellIdx);
+                        }
+                        connection[otherCellIdx] += weight;
+                    }
+                }
+            }
+            IndexType bestCellIdx = INDEX_TYPE_MAX;
+            RealType bestConnection = 0;
+            for (IndexType otherCellIdx : neighbors)
+            {
+                if (connection[otherCellIdx] > bestConnection)
+                {
+                    bestConnection = connection[otherCellIdx];
+                    bestCellIdx = otherCellIdx;
+                }
+                connection[otherCellIdx] = 0;
+            }
+            if (bestCellIdx != INDEX_TYPE_MAX)
+            {
+                addCluster(fine, level, { cellIdx, bestCellIdx }, true);
+            }
+        }
+    }
+    // 4. The rest stay as they are
+    for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+    {
+        if (isFree(cellIdx))
+        {
+            addCluster(fine, level, { cellIdx }, true);
+        }
+    }
+    if (level.db.numCells() > minCoarsenRatio * numCells)
+    {
+        return false;
+    }
+    buildCoarseNetlist(fine, level);
+    return true;
+}
+
+template<typename nlp_settings>
+IndexType NlpMultilevelGPlacer<nlp_settings>::addCluster(const Database &fine, Level &level, const std::vector<IndexType> &cells, bool oneRow)
+{
+    const IndexType clusterIdx = level.db.allocateCell();
+    level.db.initCell(clusterIdx);
+    auto &cluster = level.db.cell(clusterIdx);
+    cluster.setName("cluster_" + std::to_string(clusterIdx));
+    // Pack the cells in rows from the lower left
+    LocType rowWidth = LOC_TYPE_MAX;
+    std::vector<IndexType> order = cells;
+    if (not oneRow)
+    {
+        RealType area = 0;
+        for (IndexType cellIdx : cells)
+        {
+            area += fine.cell(cellIdx).cellBBox().area();
+        }
+        rowWidth = static_cast<LocType>(std::ceil(std::sqrt(area)));
+        std::sort(order.begin(), order.end(), [&](IndexType lhs, IndexType rhs) { return fine.cell(lhs).cellBBox().yLen() > fine.cell(rhs).cellBBox().yLen(); });
+    }
+    LocType x = 0, y = 0, rowHeight = 0;
+    for (IndexType cellIdx : order)
+    {
+        const auto &cellBox = fine.cell(cellIdx).cellBBox();
+        if (x > 0 and x + cellBox.xLen() > rowWidth)
+        {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        level.clusterIdx[cellIdx] = clusterIdx;
+        level.offset[cellIdx] = XY<LocType>(x, y);
+        cluster.unionBBox(0, Box<LocType>(x, y, x + cellBox.xLen(), y + cellBox.yLen()));
+        x += cellBox.xLen();
+        rowHeight = std::max(rowHeight, cellBox.yLen());
+    }
+    cluster.calculateCellBBox();
+    return clusterIdx;
+}
+
+template<typename nlp_settings>
+void NlpMultilevelGPlacer<nlp_settings>::buildCoarseNetlist(const Database &fine, Level &level)
+{
+    auto &coarse = level.db;
+    // Pins. Keep the locations of the pins inside the clusters
+    std::vector<IndexType> coarsePinIdx(fine.numPins(), INDEX_TYPE_MAX);
+    for (IndexType pinIdx = 0; pinIdx < fine.numPins(); ++pinIdx)
+    {
+        const auto &pin = fine.pin(pinIdx);
+        const IndexType cellIdx = pin.cellIdx();
+        const IndexType clusterIdx = level.clusterIdx.at(cellIdx);
+        const auto &cellBox = fine.cell(cellIdx).cellBBox();
+        const XY<LocType> shift = level.offset[cellIdx] - XY<LocType>(cellBox.xLo(), cellBox.yLo());
+        coarsePinIdx[pinIdx] = coarse.allocatePin();
+        auto &coarsePin = coarse.pin(coarsePinIdx[pinIdx]);
+        coarsePin.setName(pin.name());
+        coarsePin.setCellIdx(clusterIdx);
+        coarsePin.shape() = pin.shape().offsetBox(shift);
+        if (pin.isDummyPin())
+        {
+            coarsePin.markAsDummyPin();
+        }
+        coarse.cell(clusterIdx).addPin(coarsePinIdx[pinIdx]);
+    }
+    // Nets. Drop the ones inside a cluster
+    for (const auto &net : fine.nets())
+    {
+        bool crossClusters = false;
+        for (IndexType pinIdx : net.pinIdxArray())
+        {
+            if (coarse.pin(coarsePinIdx[pinIdx]).cellIdx() != coarse.pin(coarsePinIdx[net.pinIdx(0)]).cellIdx())
+            {
+                crossClusters = true;
+                break;
+            }
+        }
+        if (not crossClusters)
+        {
+            continue;
+        }
+        const IndexType netIdx = coarse.allocateNet();
+        auto &coarseNet = coarse.net(netIdx);
+        coarseNet.setName(net.name());
+        coarseNet.setWeight(net.weight());
+        coarseNet.setIsIo(net.isIo());
+        if (net.isVdd()) { coarseNet.markAsVdd(); }
+        if (net.isVss()) { coarseNet.markAsVss(); }
+        if (net.isDummyNet()) { coarseNet.markAsDummyNet(); }
+        for (IndexType pinIdx : net.pinIdxArray())
+        {
+            coarseNet.addPin(coarsePinIdx[pinIdx]);
+            coarse.pin(coarsePinIdx[pinIdx]).addNetIdx(netIdx);
+        }
+    }
+    // Symmetric groups. A pair in one cluster becomes a self-symmetric cell
+    for (const auto &symGrp : fine.vSymGrpArray())
+    {
+        const IndexType symGrpIdx = coarse.allocateSymGrp();
+        auto &coarseSymGrp = coarse.symGroup(symGrpIdx);
+        std::vector<IndexType> selfSyms;
+        for (const auto &symPair : symGrp.vSymPairs())
+        {
+            const IndexType cluster1 = level.clusterIdx[symPair.firstCell()];
+            const IndexType cluster2 = level.clusterIdx[symPair.secondCell()];
+            if (cluster1 == cluster2)
+            {
+                selfSyms.emplace_back(cluster1);
+            }
+            else
+            {
+                coarseSymGrp.addSymPair(cluster1, cluster2);
+            }
+        }
+        for (IndexType cellIdx : symGrp.vSelfSyms())
+        {
+            selfSyms.emplace_back(level.clusterIdx[cellIdx]);
+        }
+        std::sort(selfSyms.begin(), selfSyms.end());
+        selfSyms.erase(std::unique(selfSyms.begin(), selfSyms.end()), selfSyms.end());
+        for (IndexType clusterIdx : selfSyms)
+        {
+            coarseSymGrp.addSelfSym(clusterIdx);
+        }
+    }
+}
+
+template<typename nlp_settings>
+void NlpMultilevelGPlacer<nlp_settings>::interpolate(const Level &level, Database &fine)
+{
+    for (IndexType cellIdx = 0; cellIdx < fine.numCells(); ++cellIdx)
+    {
+        const auto clusterBox = level.db.cell(level.clusterIdx.at(cellIdx)).cellBBoxOff();
+        auto &cell = fine.cell(cellIdx);
+        cell.setXLoc(clusterBox.xLo() + level.offset[cellIdx].x() - cell.cellBBox().xLo());
+        cell.setYLoc(clusterBox.yLo() + level.offset[cellIdx].y() - cell.cellBBox().yLo());
+    }
+}
+
+template class NlpMultilevelGPlacer<nlp::nlp_default_settings>;
+template class NlpMultilevelGPlacer<nlp::nlp_density_settings>;
+template class NlpMultilevelGPlacer<nlp::nlp_adam_bb_settings<nlp::nlp_default_settings>>;
+template class NlpMultilevelGPlacer<nlp::nlp_adam_bb_settings<nlp::nlp_density_settings>>;
+template class NlpMultilevelGPlacer<nlp::nlp_nesterov_armijo_settings<nlp::nlp_default_settings>>;
+template class NlpMultilevelGPlacer<nlp::nlp_nesterov_armijo_settings<nlp::nlp_density_settings>>;
+template class NlpMultilevelGPlacer<nlp::nlp_float_settings>;
+template class NlpMultilevelGPlacer<nlp::nlp_float_density_settings>;
+template class NlpMultilevelGPlacer<nlp::nlp_mixed_settings>;
+template class NlpMultilevelGPlacer<nlp::nlp_mixed_density_settings>;
+
+PROJECT_NAMESPACE_END
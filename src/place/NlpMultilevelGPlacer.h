@@ -0,0 +1,70 @@
+/**
+ * @file NlpMultilevelGPlacer.h
+ * @brief The multilevel (coarsen-solve-refine) driver of the non-linear global placement
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#ifndef IDEAPLACE_NLP_MULTILEVEL_GPLACER_H_
+#define IDEAPLACE_NLP_MULTILEVEL_GPLACER_H_
+
+#include "place/NlpGPlacer.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+/// @class IDEAPLACE::NlpMultilevelGPlacer
+/// @brief multilevel global placement.
+/// @details The cells are clustered level by level: the symmetric pairs, then the proximity groups, then the small cells with strong connections.
+/// The coarsest level is solved from scratch. Each finer level starts from the placement interpolated from the coarser one
+template<typename nlp_settings>
+class NlpMultilevelGPlacer
+{
+    public:
+        static constexpr IndexType maxNumLevels = 4; ///< The maximum number of coarse levels
+        static constexpr IndexType minNumCells = 8; ///< Do not coarsen a level with fewer cells
+        static constexpr RealType minCoarsenRatio = 0.9; ///< Stop if a level can not reduce the number of cells to this ratio
+        static constexpr IndexType maxNetDegree = 16; ///< Ignore the larger nets when measuring the connections between cells
+
+        /// @brief a coarse level
+        struct Level
+        {
+            Database db; ///< The coarse problem
+            std::vector<IndexType> clusterIdx; ///< The coarse cell of each cell in the finer level
+            std::vector<XY<LocType>> offset; ///< The offset of the lower left of each finer cell to the lower left of its coarse cell
+        };
+
+        explicit NlpMultilevelGPlacer(Database &db) : _db(db) {}
+        /// @brief run the multilevel global placement. The result is written to the database
+        IntType solve();
+        /// @brief run as one of the concurrent runs of a multi-start. Each level is compared with the same level of the other runs
+        void setMultiStartMonitor(nlp::MultiStartMonitor *monitor, IndexType runIdx) { _multiStartMonitor = monitor; _multiStartRunIdx = runIdx; }
+        /// @brief add the counters of all the levels to a profile
+        /// @param the profile. nullptr to not profile
+        void setProfile(nlp::profile::Profile *profile) { _profile = profile; }
+    private:
+        /// @brief cluster the cells of a level
+        /// @param the finer level
+        /// @param the coarse level to build
+        /// @return whether the number of cells is reduced enough
+        bool coarsen(const Database &fine, Level &level);
+        /// @brief add a cluster to the coarse level
+        /// @param the finer level
+        /// @param the coarse level
+        /// @param the finer cells in the cluster
+        /// @param whether to put the cells in one row. Otherwise they are packed in rows of about the same width and height
+        /// @return the index of the coarse cell
+        IndexType addCluster(const Database &fine, Level &level, const std::vector<IndexType> &cells, bool oneRow);
+        /// @brief build the pins, nets and symmetric groups of the coarse level after the clusters are decided
+        void buildCoarseNetlist(const Database &fine, Level &level);
+        /// @brief place the finer cells by their coarse cells
+        void interpolate(const Level &level, Database &fine);
+    private:
+        Database &_db; ///< The placement engine database
+        nlp::MultiStartMonitor *_multiStartMonitor = nullptr; ///< Shared by the runs of a multi-start. nullptr if running alone
+        IndexType _multiStartRunIdx = 0; ///< The index of this run in the multi-start
+        nlp::profile::Profile *_profile = nullptr; ///< Where the counters of the levels are added. nullptr if not profiled
+};
+
+PROJECT_NAMESPACE_END
+
+#endif //IDEAPLACE_NLP_MULTILEVEL_GPLACER_H_
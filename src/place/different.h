@@ -9,6 +9,7 @@
 #define IDEAPLACE_DIFFERENT_H_
 
 #include "db/Database.h"
+#include "differentAutoDiff.hpp"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -49,6 +50,26 @@ struct placement_differentiable_traits
         dif.accumlateGradient();
     }
 
+    /// @brief evaluate the operator and accumulate its gradient in one pass
+    /// @return the evaluated value
+    static numerical_type evaluateAndAccumulate(const different_type & dif)
+    {
+        return _evaluateAndAccumulate(dif, 0);
+    }
+
+    private:
+        /// @brief use the fused member when the operator has one, so that the shared terms (e.g. the exponentials) are computed only once
+        template<typename T>
+        static auto _evaluateAndAccumulate(const T & dif, int) -> decltype(dif.evaluateAndAccumulate())
+        {
+            return dif.evaluateAndAccumulate();
+        }
+        template<typename T>
+        static numerical_type _evaluateAndAccumulate(const T & dif, long)
+        {
+            dif.accumlateGradient();
+            return dif.evaluate();
+        }
 };
 
 /// @namespace IDEAPLACE::op
@@ -109,6 +130,150 @@ namespace op
     }
 };
 
+/* Accessors used by the operators. Concrete types instead of type-erased functions so that the hot loops can be inlined */
+
+/// @brief a reference to a scalar owned by someone else (e.g. alpha or a multiplier), or a constant
+/// @details The outer problem keeps these scalars in RealType regardless of the precision of the operators
+template<typename NumType>
+class NumericRef
+{
+    public:
+        NumericRef() = default;
+        /// @brief refer to a value. The pointer need to be kept valid
+        explicit NumericRef(const RealType *ref) : _ref(ref) {}
+        /// @brief a constant value
+        NumericRef(NumType value) : _value(value) {}
+        NumType operator()() const { return _ref ? static_cast<NumType>(*_ref) : _value; }
+    private:
+        const RealType *_ref = nullptr;
+        NumType _value = 0;
+};
+
+/// @brief a read-only view of the placement variables [x_0 .. x_n-1, y_0 .. y_n-1, sym axes]
+/// @tparam the type of the variable vector entries
+/// @tparam the coordinate type returned to the operators
+template<typename VarType, typename CoordType>
+class PlaceVarView
+{
+    public:
+        PlaceVarView() = default;
+        /// @param the raw data of the variable vector. The storage need to stay at the same place
+        /// @param the number of cells
+        /// @param the symmetric axis for the orient NONE. nullptr to read it from the variable vector after the cells
+        PlaceVarView(const VarType *data, IndexType numCells, const CoordType *defaultSymAxis)
+            : _data(data), _numCells(numCells), _defaultSymAxis(defaultSymAxis) {}
+        CoordType operator()(IndexType cellIdx, Orient2DType orient) const
+        {
+            if (orient == Orient2DType::HORIZONTAL)
+            {
+                return static_cast<CoordType>(_data[cellIdx]);
+            }
+            else if (orient == Orient2DType::VERTICAL)
+            {
+                return static_cast<CoordType>(_data[cellIdx + _numCells]);
+            }
+            if (_defaultSymAxis)
+            {
+                return *_defaultSymAxis;
+            }
+            return static_cast<CoordType>(_data[cellIdx + 2 * _numCells]); // here cell index representing the idx of sym grp
+        }
+        const VarType * data() const { return _data; }
+        IndexType numCells() const { return _numCells; }
+    private:
+        const VarType *_data = nullptr;
+        IndexType _numCells = 0;
+        const CoordType *_defaultSymAxis = nullptr;
+};
+
+/// @brief compact map from the database cell indices to the local indices of an operator.
+/// @details Operators only touch a handful of cells, so a sorted vector of (cell, local) pairs is kept instead of a dense array over all the cells
+class OperatorCellMap
+{
+    public:
+        /// @brief build the map from the local-to-database index vector
+        void build(const std::vector<IndexType> &inverseCellMap)
+        {
+            _map.clear();
+            _map.reserve(inverseCellMap.size());
+            for (IndexType idx = 0; idx < inverseCellMap.size(); ++idx)
+            {
+                _map.emplace_back(inverseCellMap[idx], idx);
+            }
+            std::stable_sort(_map.begin(), _map.end(),
+                    [](const std::pair<IndexType, IndexType> &lhs, const std::pair<IndexType, IndexType> &rhs)
+                    { return lhs.first < rhs.first; });
+        }
+        /// @brief get the local index of a database cell index
+        IndexType operator[](IndexType cellIdx) const
+        {
+            // The common operators have less than four cells. Linear scanning is cheaper for them
+            if (_map.size() <= 4)
+            {
+                for (const auto &pair : _map)
+                {
+                    if (pair.first == cellIdx) { return pair.second; }
+                }
+                AssertMsg(false, "OperatorCellMap: cell %d is not in the operator \n", cellIdx);
+                return INDEX_TYPE_MAX;
+            }
+            auto iter = std::lower_bound(_map.begin(), _map.end(), cellIdx,
+                    [](const std::pair<IndexType, IndexType> &pair, IndexType val) { return pair.first < val; });
+            AssertMsg(iter != _map.end() && iter->first == cellIdx, "OperatorCellMap: cell %d is not in the operator \n", cellIdx);
+            return iter->second;
+        }
+        /// @brief get the number of cells in the map
+        IndexType size() const { return _map.size(); }
+    private:
+        std::vector<std::pair<IndexType, IndexType>> _map; ///< (db cell index, local index) sorted by db cell index
+};
+
+/// @brief accumulate the partials of an operator into raw per-operator arrays
+template<typename NumType>
+class PartialAccumulator
+{
+    public:
+        PartialAccumulator() = default;
+        /// @param the partials in x direction, indexed by the local indices
+        /// @param the partials in y direction, indexed by the local indices
+        /// @param the map from cell indices to local indices
+        /// @param the partial of the symmetric axis. nullptr to ignore
+        PartialAccumulator(NumType *partialsX, NumType *partialsY, const OperatorCellMap *cellMap, NumType *partialSym = nullptr)
+            : _partialsX(partialsX), _partialsY(partialsY), _cellMap(cellMap), _partialSym(partialSym) {}
+        void operator()(NumType num, IndexType cellIdx, Orient2DType orient) const
+        {
+            if (orient == Orient2DType::HORIZONTAL)
+            {
+                _partialsX[(*_cellMap)[cellIdx]] += num;
+            }
+            else if (orient == Orient2DType::VERTICAL)
+            {
+                _partialsY[(*_cellMap)[cellIdx]] += num;
+            }
+            else if (_partialSym)
+            {
+                *_partialSym += num;
+            }
+        }
+        /// @brief accumulate by the local index directly, for the operators whose cell order is the one of the partials
+        void accumulateLocal(NumType num, IndexType localIdx, Orient2DType orient) const
+        {
+            if (orient == Orient2DType::HORIZONTAL)
+            {
+                _partialsX[localIdx] += num;
+            }
+            else
+            {
+                _partialsY[localIdx] += num;
+            }
+        }
+    private:
+        NumType *_partialsX = nullptr;
+        NumType *_partialsY = nullptr;
+        const OperatorCellMap *_cellMap = nullptr;
+        NumType *_partialSym = nullptr;
+};
+
 
 /// @brief LSE-smoothed HPWL
 template<typename NumType, typename CoordType>
@@ -117,12 +282,12 @@ struct LseHpwlDifferentiable
     typedef NumType numerical_type;
     typedef CoordType coordinate_type;
 
-    LseHpwlDifferentiable(const std::function<NumType(void)> &getAlphaFunc, const std::function<NumType(void)> &getLambdaFunc) 
+    LseHpwlDifferentiable(const NumericRef<NumType> &getAlphaFunc, const NumericRef<NumType> &getLambdaFunc) 
     { _getAlphaFunc = getAlphaFunc; _getLambdaFunc = getLambdaFunc; }
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
-    void setGetAlphaFunc(const std::function<NumType(void)> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
 
     void setVirtualPin(const CoordType &x, const CoordType &y) 
     { 
@@ -181,16 +346,29 @@ struct LseHpwlDifferentiable
     }
 
     void accumlateGradient() const
+    {
+        _evaluateAndAccumulate(false);
+    }
+
+    /// @brief evaluate and accumulate the gradient with the same exponentials
+    NumType evaluateAndAccumulate() const
+    {
+        return _evaluateAndAccumulate(true);
+    }
+
+    NumType _evaluateAndAccumulate(bool needObj) const
     {
         if (! validHpwl())
         {
-            return;
+            return 0;
         }
         std::array<NumType, 4> max_val = { 0, 0, 0, 0}; // xmax xin ymax ymin
         auto alpha = _getAlphaFunc();
         auto lambda = _getLambdaFunc();
         NumType *pMax = &max_val.front(); 
-        std::vector<std::array<NumType, 4>> exp_results(_cells.size());
+        // Allocated once with the pins and reused by the later calls
+        _expResults.resize(_cells.size());
+        auto &exp_results = _expResults;
         for (IndexType pinIdx = 0; pinIdx < _cells.size(); ++pinIdx)
         {
             NumType x = op::conv<NumType>(
@@ -215,6 +393,15 @@ struct LseHpwlDifferentiable
             pMax[2] += exp(_virtualPinY / alpha);
             pMax[3] += exp(- _virtualPinY / alpha);
         }
+        NumType obj = 0;
+        if (needObj)
+        {
+            for (int i = 0; i < 4; ++ i)
+            {
+                obj += log(pMax[i]);
+            }
+            obj *= alpha * _weight * lambda;
+        }
         // avoid overflow
         for (IndexType i =0; i < 4; ++i)
         {
@@ -230,6 +417,7 @@ struct LseHpwlDifferentiable
             _accumulateGradFunc(xPartial, cellIdx, Orient2DType::HORIZONTAL);
             _accumulateGradFunc(yPartial, cellIdx, Orient2DType::VERTICAL);
         }
+        return obj;
     }
 
     IntType _validVirtualPin = 0;
@@ -238,11 +426,12 @@ struct LseHpwlDifferentiable
     std::vector<IndexType> _cells;
     std::vector<CoordType> _offsetX;
     std::vector<CoordType> _offsetY;
+    mutable std::vector<std::array<NumType, 4>> _expResults; ///< The exponentials of each pin in the last evaluation
     NumType _weight = 1;
-    std::function<NumType(void)> _getAlphaFunc; ///< A function to get the current alpha
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getAlphaFunc; ///< The current alpha
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
 };
 
 
@@ -261,7 +450,7 @@ struct CellPairOverlapPenaltyDifferentiable
 
     CellPairOverlapPenaltyDifferentiable(IndexType cellIdxI, CoordType cellWidthI, CoordType cellHeightI,
                            IndexType cellIdxJ, CoordType cellWidthJ, CoordType cellHeightJ,
-                           const std::function<NumType(void)> &getAlphaFunc, const std::function<NumType(void)> &getLambdaFunc)
+                           const NumericRef<NumType> &getAlphaFunc, const NumericRef<NumType> &getLambdaFunc)
     {
         _cellIdxI = cellIdxI;
         _cellWidthI = cellWidthI;
@@ -273,9 +462,9 @@ struct CellPairOverlapPenaltyDifferentiable
         _getLambdaFunc = getLambdaFunc;
     }
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
-    void setGetAlphaFunc(const std::function<NumType(void)> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
     
     NumType evaluate() const
     {
@@ -363,16 +552,46 @@ struct CellPairOverlapPenaltyDifferentiable
         _accumulateGradFunc(dyj , _cellIdxJ, Orient2DType::VERTICAL);
     }
 
+    /// @brief evaluate and accumulate the gradient with the same exponentials. The partials are in the simplified form of the ones above
+    NumType evaluateAndAccumulate() const
+    {
+        const NumType xi = op::conv<NumType>(_getVarFunc(_cellIdxI, Orient2DType::HORIZONTAL));
+        const NumType yi = op::conv<NumType>(_getVarFunc(_cellIdxI, Orient2DType::VERTICAL));
+        const NumType xj = op::conv<NumType>(_getVarFunc(_cellIdxJ, Orient2DType::HORIZONTAL));
+        const NumType yj = op::conv<NumType>(_getVarFunc(_cellIdxJ, Orient2DType::VERTICAL));
+        const NumType wi = op::conv<NumType>(_cellWidthI);
+        const NumType hi = op::conv<NumType>(_cellHeightI);
+        const NumType wj = op::conv<NumType>(_cellWidthJ);
+        const NumType hj = op::conv<NumType>(_cellHeightJ);
+        const NumType alpha = _getAlphaFunc();
+        const NumType lambda = _getLambdaFunc();
+        const NumType expX1 = exp(-(wi + xi - xj) / alpha);
+        const NumType expX2 = exp(-(wj - xi + xj) / alpha);
+        const NumType expY1 = exp(-(hi + yi - yj) / alpha);
+        const NumType expY2 = exp(-(hj - yi + yj) / alpha);
+        const NumType sumX = expX1 + expX2;
+        const NumType sumY = expY1 + expY2;
+        const NumType logX = log(1 / sumX + 1);
+        const NumType logY = log(1 / sumY + 1);
+        const NumType dxi = lambda * alpha * logY * (expX1 - expX2) / ((sumX + 1) * sumX);
+        const NumType dyi = lambda * alpha * logX * (expY1 - expY2) / ((sumY + 1) * sumY);
+        _accumulateGradFunc(dxi, _cellIdxI, Orient2DType::HORIZONTAL);
+        _accumulateGradFunc(-dxi, _cellIdxJ, Orient2DType::HORIZONTAL);
+        _accumulateGradFunc(dyi, _cellIdxI, Orient2DType::VERTICAL);
+        _accumulateGradFunc(-dyi, _cellIdxJ, Orient2DType::VERTICAL);
+        return lambda * alpha * alpha * logY * logX;
+    }
+
     IndexType _cellIdxI;
     CoordType _cellWidthI;
     CoordType _cellHeightI;
     IndexType _cellIdxJ;
     CoordType _cellWidthJ;
     CoordType _cellHeightJ;
-    std::function<NumType(void)> _getAlphaFunc; ///< A function to get the current alpha
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getAlphaFunc; ///< The current alpha
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
 };
 
 template<typename op_type>
@@ -397,12 +616,358 @@ struct place_overlap_trait
     }
 };
 
+/// @brief whether the overlapping operator measures the density overflow instead of the pair-wise overlapping area
+template<typename op_type>
+struct is_density_overlap_operator : std::false_type {};
+
 template <typename NumType, typename CoordType>
 struct is_placement_differentiable_concept<CellPairOverlapPenaltyDifferentiable<NumType, CoordType>>
 {
     typedef std::true_type  is_placement_differentiable_concept_type;
 };
 
+/// @brief Verlet neighbor list of the cell pairs that need to be considered for the overlapping penalty
+/// @details The cells are binned by their lower-left locations. A pair is kept if the gaps between the two cells in both directions are within the reach (cutoff + skin).
+/// The list only need to be rebuilt when some cell has moved for more than half of the skin, or the cutoff becomes larger than the one used in the last build.
+/// The pairs are stored with the local indices of the cells, i.e. the order of addCell
+template<typename CoordType>
+class OverlapNeighborList
+{
+    public:
+        explicit OverlapNeighborList() = default;
+        /// @brief add a cell into the list
+        void addCell(IndexType cellIdx, CoordType width, CoordType height)
+        {
+            _cells.emplace_back(cellIdx);
+            _widths.emplace_back(width);
+            _heights.emplace_back(height);
+            _maxCellDim = std::max(_maxCellDim, std::max(width, height));
+            _isBuilt = false;
+        }
+        /// @brief set the skin distance
+        void setSkin(CoordType skin) { _skin = skin; }
+        /// @brief set the ratio between the cutoff distance and alpha
+        void setCutoffAlphaRatio(CoordType ratio) { _cutoffAlphaRatio = ratio; }
+        /// @brief rebuild the pairs if they are no longer valid
+        /// @param a function to get the cell location
+        /// @param the current alpha of the smoothing
+        /// @return true if the list is rebuilt
+        template<typename get_var_func_type>
+        bool refresh(const get_var_func_type &getVarFunc, CoordType alpha)
+        {
+            const CoordType cutoff = _cutoffAlphaRatio * alpha;
+            if (_isBuilt and cutoff <= _cutoff)
+            {
+                // Check the displacement since last build
+                const CoordType halfSkinSquare = _skin * _skin / 4;
+                bool needRebuild = false;
+                for (IndexType idx = 0; idx < _cells.size(); ++idx)
+                {
+                    const CoordType dx = getVarFunc(_cells[idx], Orient2DType::HORIZONTAL) - _refX[idx];
+                    const CoordType dy = getVarFunc(_cells[idx], Orient2DType::VERTICAL) - _refY[idx];
+                    if (dx * dx + dy * dy > halfSkinSquare)
+                    {
+                        needRebuild = true;
+                        break;
+                    }
+                }
+                if (not needRebuild)
+                {
+                    return false;
+                }
+            }
+            rebuild(getVarFunc, cutoff);
+            return true;
+        }
+        /// @brief get the number of cells
+        IndexType numCells() const { return _cells.size(); }
+        /// @brief get the database cell index of a local index
+        IndexType cellIdx(IndexType localIdx) const { return _cells[localIdx]; }
+        /// @brief get the width of a cell with local index
+        CoordType width(IndexType localIdx) const { return _widths[localIdx]; }
+        /// @brief get the height of a cell with local index
+        CoordType height(IndexType localIdx) const { return _heights[localIdx]; }
+        /// @brief get the pairs of local cell indices
+        const std::vector<std::pair<IndexType, IndexType>> & pairs() const { return _pairs; }
+        /// @brief whether the list has been built
+        bool isBuilt() const { return _isBuilt; }
+        /// @brief get the number of rebuilds
+        IndexType numRebuilds() const { return _numRebuilds; }
+    private:
+        template<typename get_var_func_type>
+        void rebuild(const get_var_func_type &getVarFunc, CoordType cutoff)
+        {
+            const IndexType numCells = _cells.size();
+            _cutoff = cutoff;
+            _refX.resize(numCells);
+            _refY.resize(numCells);
+            _pairs.clear();
+            _isBuilt = true;
+            ++_numRebuilds;
+            if (numCells == 0)
+            {
+                return;
+            }
+            CoordType xLo = std::numeric_limits<CoordType>::max();
+            CoordType yLo = std::numeric_limits<CoordType>::max();
+            CoordType xHi = std::numeric_limits<CoordType>::lowest();
+            CoordType yHi = std::numeric_limits<CoordType>::lowest();
+            for (IndexType idx = 0; idx < numCells; ++idx)
+            {
+                _refX[idx] = getVarFunc(_cells[idx], Orient2DType::HORIZONTAL);
+                _refY[idx] = getVarFunc(_cells[idx], Orient2DType::VERTICAL);
+                xLo = std::min(xLo, _refX[idx]);
+                yLo = std::min(yLo, _refY[idx]);
+                xHi = std::max(xHi, _refX[idx]);
+                yHi = std::max(yHi, _refY[idx]);
+            }
+            const CoordType reach = _cutoff + _skin;
+            // Two cells within the reach must be located in the neighboring bins
+            // Limit the number of bins so that far-away outliers don't blow up the grid
+            const IndexType maxNumBinsPerDim = std::max(static_cast<IndexType>(std::ceil(std::sqrt(static_cast<RealType>(numCells)))), 1u);
+            CoordType binSize = _maxCellDim + reach;
+            binSize = std::max(binSize, (xHi - xLo) / maxNumBinsPerDim);
+            binSize = std::max(binSize, (yHi - yLo) / maxNumBinsPerDim);
+            binSize = std::max(binSize, static_cast<CoordType>(REAL_TYPE_TOL));
+            const IndexType numBinsX = std::min(static_cast<IndexType>((xHi - xLo) / binSize) + 1, maxNumBinsPerDim);
+            const IndexType numBinsY = std::min(static_cast<IndexType>((yHi - yLo) / binSize) + 1, maxNumBinsPerDim);
+            auto binIdx = [&](CoordType loc, CoordType lo, IndexType numBins)
+            {
+                return std::min(static_cast<IndexType>((loc - lo) / binSize), numBins - 1);
+            };
+            std::vector<std::vector<IndexType>> bins(numBinsX * numBinsY);
+            std::vector<IndexType> binX(numCells), binY(numCells);
+            for (IndexType idx = 0; idx < numCells; ++idx)
+            {
+                binX[idx] = binIdx(_refX[idx], xLo, numBinsX);
+                binY[idx] = binIdx(_refY[idx], yLo, numBinsY);
+                bins[binX[idx] * numBinsY + binY[idx]].emplace_back(idx);
+            }
+            std::vector<IndexType> neighbors;
+            for (IndexType i = 0; i < numCells; ++i)
+            {
+                neighbors.clear();
+                const IndexType bxLo = binX[i] > 0 ? binX[i] - 1 : 0;
+                const IndexType byLo = binY[i] > 0 ? binY[i] - 1 : 0;
+                const IndexType bxHi = std::min(binX[i] + 1, numBinsX - 1);
+                const IndexType byHi = std::min(binY[i] + 1, numBinsY - 1);
+                for (IndexType bx = bxLo; bx <= bxHi; ++bx)
+                {
+                    for (IndexType by = byLo; by <= byHi; ++by)
+                    {
+                        for (IndexType j : bins[bx * numBinsY + by])
+                        {
+                            if (j <= i)
+                            {
+                                continue;
+                            }
+                            const CoordType gapX = std::max(_refX[i], _refX[j]) - std::min(_refX[i] + _widths[i], _refX[j] + _widths[j]);
+                            const CoordType gapY = std::max(_refY[i], _refY[j]) - std::min(_refY[i] + _heights[i], _refY[j] + _heights[j]);
+                            if (gapX <= reach and gapY <= reach)
+                            {
+                                neighbors.emplace_back(j);
+                            }
+                        }
+                    }
+                }
+                // Keep the order deterministic so that the summation is reproducible
+                std::sort(neighbors.begin(), neighbors.end());
+                for (IndexType j : neighbors)
+                {
+                    _pairs.emplace_back(i, j);
+                }
+            }
+        }
+    private:
+        std::vector<IndexType> _cells; ///< The database indices of the cells
+        std::vector<CoordType> _widths; ///< The widths of the cells
+        std::vector<CoordType> _heights; ///< The heights of the cells
+        std::vector<CoordType> _refX; ///< The x locations of the cells at the last build
+        std::vector<CoordType> _refY; ///< The y locations of the cells at the last build
+        std::vector<std::pair<IndexType, IndexType>> _pairs; ///< The pairs of local cell indices
+        CoordType _maxCellDim = 0; ///< The maximum width/height of the cells
+        CoordType _skin = 0; ///< The skin distance
+        CoordType _cutoffAlphaRatio = 8; ///< The cutoff distance in terms of alpha. The smoothed overlap decays as exp(-gap / alpha)
+        CoordType _cutoff = 0; ///< The cutoff used in the last build
+        bool _isBuilt = false; ///< Whether the list has been built
+        IndexType _numRebuilds = 0; ///< The number of rebuilds
+};
+
+/// @brief cell pair overlapping penalty on the pairs from a Verlet neighbor list.
+/// @details Multiple operators can share one neighbor list. Each of them evaluates a strided slice of the pairs, so that the operators can be evaluated in parallel.
+/// The neighbor list needs to be refreshed (refreshNeighborList) before the evaluations whenever the placement has changed.
+/// The partials are accumulated by the local indices of the neighbor list, so the partial task need to use them as its own
+template<typename NumType, typename CoordType>
+struct CellPairOverlapNeighborListPenaltyDifferentiable
+{
+    typedef NumType numerical_type;
+    typedef CoordType coordinate_type;
+    typedef OverlapNeighborList<CoordType> neighbor_list_type;
+
+    CellPairOverlapNeighborListPenaltyDifferentiable(const std::shared_ptr<neighbor_list_type> &neighborList, IndexType sliceIdx, IndexType numSlices,
+                           const NumericRef<NumType> &getAlphaFunc, const NumericRef<NumType> &getLambdaFunc)
+    {
+        _neighborList = neighborList;
+        _sliceIdx = sliceIdx;
+        _numSlices = numSlices;
+        _getAlphaFunc = getAlphaFunc;
+        _getLambdaFunc = getLambdaFunc;
+    }
+
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    /// @brief rebuild the shared neighbor list if needed. Not thread-safe
+    void refreshNeighborList() { _neighborList->refresh(_getVarFunc, op::conv<CoordType>(_getAlphaFunc())); }
+
+    NumType evaluate() const
+    {
+        Assert(_neighborList->isBuilt());
+        const NumType alpha = _getAlphaFunc();
+        const NumType lambda = _getLambdaFunc();
+        const auto &pairs = _neighborList->pairs();
+        NumType ovl = 0;
+        for (IndexType pairIdx = _sliceIdx; pairIdx < pairs.size(); pairIdx += _numSlices)
+        {
+            const IndexType i = pairs[pairIdx].first;
+            const IndexType j = pairs[pairIdx].second;
+            const IndexType cellIdxI = _neighborList->cellIdx(i);
+            const IndexType cellIdxJ = _neighborList->cellIdx(j);
+            const NumType xi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::HORIZONTAL));
+            const NumType yi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::VERTICAL));
+            const NumType xj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::HORIZONTAL));
+            const NumType yj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::VERTICAL));
+            const NumType wi = op::conv<NumType>(_neighborList->width(i));
+            const NumType hi = op::conv<NumType>(_neighborList->height(i));
+            const NumType wj = op::conv<NumType>(_neighborList->width(j));
+            const NumType hj = op::conv<NumType>(_neighborList->height(j));
+            // Same as CellPairOverlapPenaltyDifferentiable
+            const NumType sumX = exp(-(wi + xi - xj) / alpha) + exp(-(wj - xi + xj) / alpha);
+            const NumType sumY = exp(-(hi + yi - yj) / alpha) + exp(-(hj - yi + yj) / alpha);
+            ovl += alpha * alpha * log(1 / sumY + 1) * log(1 / sumX + 1);
+        }
+        return lambda * ovl;
+    }
+
+    void accumlateGradient() const
+    {
+        Assert(_neighborList->isBuilt());
+        const NumType alpha = _getAlphaFunc();
+        const NumType lambda = _getLambdaFunc();
+        const auto &pairs = _neighborList->pairs();
+        for (IndexType pairIdx = _sliceIdx; pairIdx < pairs.size(); pairIdx += _numSlices)
+        {
+            const IndexType i = pairs[pairIdx].first;
+            const IndexType j = pairs[pairIdx].second;
+            const IndexType cellIdxI = _neighborList->cellIdx(i);
+            const IndexType cellIdxJ = _neighborList->cellIdx(j);
+            const NumType xi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::HORIZONTAL));
+            const NumType yi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::VERTICAL));
+            const NumType xj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::HORIZONTAL));
+            const NumType yj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::VERTICAL));
+            const NumType wi = op::conv<NumType>(_neighborList->width(i));
+            const NumType hi = op::conv<NumType>(_neighborList->height(i));
+            const NumType wj = op::conv<NumType>(_neighborList->width(j));
+            const NumType hj = op::conv<NumType>(_neighborList->height(j));
+            // The simplified form of the partials in CellPairOverlapPenaltyDifferentiable
+            const NumType expX1 = exp(-(wi + xi - xj) / alpha);
+            const NumType expX2 = exp(-(wj - xi + xj) / alpha);
+            const NumType expY1 = exp(-(hi + yi - yj) / alpha);
+            const NumType expY2 = exp(-(hj - yi + yj) / alpha);
+            const NumType sumX = expX1 + expX2;
+            const NumType sumY = expY1 + expY2;
+            const NumType dxi = lambda * alpha * log(1 / sumY + 1) * (expX1 - expX2) / ((sumX + 1) * sumX);
+            const NumType dyi = lambda * alpha * log(1 / sumX + 1) * (expY1 - expY2) / ((sumY + 1) * sumY);
+            _accumulateGradFunc.accumulateLocal(dxi, i, Orient2DType::HORIZONTAL);
+            _accumulateGradFunc.accumulateLocal(-dxi, j, Orient2DType::HORIZONTAL);
+            _accumulateGradFunc.accumulateLocal(dyi, i, Orient2DType::VERTICAL);
+            _accumulateGradFunc.accumulateLocal(-dyi, j, Orient2DType::VERTICAL);
+        }
+    }
+
+    /// @brief evaluate and accumulate the gradient with the same exponentials
+    NumType evaluateAndAccumulate() const
+    {
+        Assert(_neighborList->isBuilt());
+        const NumType alpha = _getAlphaFunc();
+        const NumType lambda = _getLambdaFunc();
+        const auto &pairs = _neighborList->pairs();
+        NumType ovl = 0;
+        for (IndexType pairIdx = _sliceIdx; pairIdx < pairs.size(); pairIdx += _numSlices)
+        {
+            const IndexType i = pairs[pairIdx].first;
+            const IndexType j = pairs[pairIdx].second;
+            const IndexType cellIdxI = _neighborList->cellIdx(i);
+            const IndexType cellIdxJ = _neighborList->cellIdx(j);
+            const NumType xi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::HORIZONTAL));
+            const NumType yi = op::conv<NumType>(_getVarFunc(cellIdxI, Orient2DType::VERTICAL));
+            const NumType xj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::HORIZONTAL));
+            const NumType yj = op::conv<NumType>(_getVarFunc(cellIdxJ, Orient2DType::VERTICAL));
+            const NumType wi = op::conv<NumType>(_neighborList->width(i));
+            const NumType hi = op::conv<NumType>(_neighborList->height(i));
+            const NumType wj = op::conv<NumType>(_neighborList->width(j));
+            const NumType hj = op::conv<NumType>(_neighborList->height(j));
+            const NumType expX1 = exp(-(wi + xi - xj) / alpha);
+            const NumType expX2 = exp(-(wj - xi + xj) / alpha);
+            const NumType expY1 = exp(-(hi + yi - yj) / alpha);
+            const NumType expY2 = exp(-(hj - yi + yj) / alpha);
+            const NumType sumX = expX1 + expX2;
+            const NumType sumY = expY1 + expY2;
+            const NumType logX = log(1 / sumX + 1);
+            const NumType logY = log(1 / sumY + 1);
+            const NumType dxi = lambda * alpha * logY * (expX1 - expX2) / ((sumX + 1) * sumX);
+            const NumType dyi = lambda * alpha * logX * (expY1 - expY2) / ((sumY + 1) * sumY);
+            _accumulateGradFunc.accumulateLocal(dxi, i, Orient2DType::HORIZONTAL);
+            _accumulateGradFunc.accumulateLocal(-dxi, j, Orient2DType::HORIZONTAL);
+            _accumulateGradFunc.accumulateLocal(dyi, i, Orient2DType::VERTICAL);
+            _accumulateGradFunc.accumulateLocal(-dyi, j, Orient2DType::VERTICAL);
+            ovl += alpha * alpha * logY * logX;
+        }
+        return lambda * ovl;
+    }
+
+    std::shared_ptr<neighbor_list_type> _neighborList; ///< The shared neighbor list
+    IndexType _sliceIdx = 0; ///< The pairs of _sliceIdx + k * _numSlices are evaluated by this operator
+    IndexType _numSlices = 1; ///< The number of operators sharing the neighbor list
+    NumericRef<NumType> _getAlphaFunc; ///< The current alpha
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials. Indexed by the local indices of the neighbor list
+    IndexType _numRebuildsCleared = INDEX_TYPE_MAX; ///< The neighbor list build of the last clearing of the partials
+};
+
+template<typename NumType, typename CoordType>
+struct place_overlap_trait<CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType>>
+{
+    typedef CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType> op_type;
+    typedef typename op_type::coordinate_type coordinate_type;
+    /// @brief calculate the overlap area of the pairs in the slice of an operator. The pairs not in the neighbor list are guaranteed not overlapping
+    static coordinate_type overlapArea(op_type &ovl)
+    {
+        const auto &nbl = *ovl._neighborList;
+        coordinate_type area = 0;
+        for (IndexType pairIdx = ovl._sliceIdx; pairIdx < nbl.pairs().size(); pairIdx += ovl._numSlices)
+        {
+            const IndexType i = nbl.pairs()[pairIdx].first;
+            const IndexType j = nbl.pairs()[pairIdx].second;
+            const coordinate_type xi = ovl._getVarFunc(nbl.cellIdx(i), Orient2DType::HORIZONTAL);
+            const coordinate_type yi = ovl._getVarFunc(nbl.cellIdx(i), Orient2DType::VERTICAL);
+            const coordinate_type xj = ovl._getVarFunc(nbl.cellIdx(j), Orient2DType::HORIZONTAL);
+            const coordinate_type yj = ovl._getVarFunc(nbl.cellIdx(j), Orient2DType::VERTICAL);
+            const auto overlapX = std::max(std::min(xi + nbl.width(i), xj + nbl.width(j)) - std::max(xi, xj), op::conv<coordinate_type>(0.0));
+            const auto overlapY = std::max(std::min(yi + nbl.height(i), yj + nbl.height(j)) - std::max(yi, yj), op::conv<coordinate_type>(0.0));
+            area += overlapX * overlapY;
+        }
+        return area;
+    }
+};
+
+template <typename NumType, typename CoordType>
+struct is_placement_differentiable_concept<CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType>>
+{
+    typedef std::true_type  is_placement_differentiable_concept_type;
+};
+
 /// @brief the cell out of boundary penalty
 template<typename NumType, typename CoordType>
 struct CellOutOfBoundaryPenaltyDifferentiable
@@ -411,7 +976,7 @@ struct CellOutOfBoundaryPenaltyDifferentiable
     typedef CoordType coordinate_type;
 
     CellOutOfBoundaryPenaltyDifferentiable(IndexType cellIdx, CoordType cellWidth, CoordType cellHeight, Box<CoordType> *boundary,
-            const std::function<NumType(void)> &getAlphaFunc, const std::function<NumType(void)> &getLambdaFunc)
+            const NumericRef<NumType> &getAlphaFunc, const NumericRef<NumType> &getLambdaFunc)
     {
         _cellIdx = cellIdx;
         _cellWidth = cellWidth;
@@ -421,9 +986,9 @@ struct CellOutOfBoundaryPenaltyDifferentiable
         _getLambdaFunc = getLambdaFunc;
     }
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
-    void setGetAlphaFunc(const std::function<NumType(void)> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
 
     NumType evaluate() const
     {
@@ -486,15 +1051,36 @@ struct CellOutOfBoundaryPenaltyDifferentiable
         _accumulateGradFunc(gradObY * lambda, _cellIdx, Orient2DType::VERTICAL);
     }
 
+    /// @brief evaluate and accumulate the gradient with the same exponentials
+    NumType evaluateAndAccumulate() const
+    {
+        const NumType alpha  = _getAlphaFunc();
+        const NumType lambda = _getLambdaFunc();
+        const CoordType xLo = _getVarFunc(_cellIdx, Orient2DType::HORIZONTAL);
+        const CoordType yLo = _getVarFunc(_cellIdx, Orient2DType::VERTICAL);
+        const CoordType xHi = xLo + _cellWidth;
+        const CoordType yHi = yLo + _cellHeight;
+        // logSumExp0 = alpha * log(e + 1), gradLogSumExp0 = e / (e + 1)
+        const NumType expXLo = exp(op::conv<NumType>(_boundary->xLo() - xLo) / alpha);
+        const NumType expXHi = exp(op::conv<NumType>(xHi - _boundary->xHi()) / alpha);
+        const NumType expYLo = exp(op::conv<NumType>(_boundary->yLo() - yLo) / alpha);
+        const NumType expYHi = exp(op::conv<NumType>(yHi - _boundary->yHi()) / alpha);
+        const NumType gradObX = - expXLo / (expXLo + 1) + expXHi / (expXHi + 1);
+        const NumType gradObY = - expYLo / (expYLo + 1) + expYHi / (expYHi + 1);
+        _accumulateGradFunc(gradObX * lambda, _cellIdx, Orient2DType::HORIZONTAL);
+        _accumulateGradFunc(gradObY * lambda, _cellIdx, Orient2DType::VERTICAL);
+        return alpha * (log(expXLo + 1) + log(expXHi + 1) + log(expYLo + 1) + log(expYHi + 1)) * lambda;
+    }
+
 
     IndexType _cellIdx;
     CoordType _cellWidth;
     CoordType _cellHeight;
     Box<CoordType> *_boundary = nullptr;
-    std::function<NumType(void)> _getAlphaFunc;
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getAlphaFunc;
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
 };
 
 
@@ -534,14 +1120,14 @@ struct AsymmetryDifferentiable
     typedef NumType numerical_type;
     typedef CoordType coordinate_type;
 
-    AsymmetryDifferentiable(IndexType symGrpIdx, const std::function<NumType(void)> &getLambdaFunc)
+    AsymmetryDifferentiable(IndexType symGrpIdx, const NumericRef<NumType> &getLambdaFunc)
     {
         _symGrpIdx = symGrpIdx;
         _getLambdaFunc = getLambdaFunc;
     }
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
 
     /// @brief add a symmetric pair. require the cell widths are the same
     void addSymPair(IndexType cellIdxI, IndexType cellIdxJ, CoordType width)
@@ -622,9 +1208,9 @@ struct AsymmetryDifferentiable
     std::vector<NumType> _pairWidths;
     std::vector<IndexType> _selfSymCells;
     std::vector<NumType> _selfSymWidths;
-    std::function<NumType(void)> _getLambdaFunc;
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getLambdaFunc;
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
 };
 
 
@@ -685,7 +1271,7 @@ struct CosineDatapathDifferentiable
             IndexType sCellIdx, const XY<CoordType> &sOffset,
             IndexType midCellIdx, const XY<CoordType> &midOffsetA, const XY<CoordType> &midOffsetB,
             IndexType tCellIdx, const XY<CoordType> &tOffset,
-            const std::function<NumType(void)> &getLambdaFunc)
+            const NumericRef<NumType> &getLambdaFunc)
         : _sCellIdx(sCellIdx),
           _midCellIdx(midCellIdx),
           _tCellIdx(tCellIdx), 
@@ -704,7 +1290,7 @@ struct CosineDatapathDifferentiable
     CosineDatapathDifferentiable(
             IndexType sCellIdx, const XY<CoordType> &sOffset,
             IndexType midCellIdx, const XY<CoordType> &midOffsetA, const XY<CoordType> &midOffsetB,
-            const std::function<NumType(void)> &getLambdaFunc)
+            const NumericRef<NumType> &getLambdaFunc)
         : _sCellIdx(sCellIdx),
           _midCellIdx(midCellIdx),
           _getLambdaFunc(getLambdaFunc)
@@ -721,8 +1307,8 @@ struct CosineDatapathDifferentiable
     
 
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
 
     BoolType isTwoPin() const { return _tCellIdx == INDEX_TYPE_MAX; }
     void markTwoPin() { _tCellIdx = INDEX_TYPE_MAX; }
@@ -736,9 +1322,19 @@ struct CosineDatapathDifferentiable
 
     NumType evaluate() const;
     void accumlateGradient() const;
+    /// @brief evaluate and accumulate the gradient with the same intermediate terms
+    NumType evaluateAndAccumulate() const;
 
     void setWeight(NumType weight) { _weight = weight; }
 
+    /// @brief the current values of the variables: x and y of the source, the middle and the target. The target is at 0 for a two-pin path
+    std::array<NumType, 6> variables() const;
+    /// @brief the cosine of the angle between the two vectors plus one, without lambda and the weight
+    /// @details Written once for both the plain numbers and ad::Dual, which gives the partials and the second partials
+    /// @param the variables in the order of variables()
+    template<typename ValueType>
+    ValueType cosineCost(const std::array<ValueType, 6> &vars) const;
+
     IndexType _sCellIdx = INDEX_TYPE_MAX; ///< Source
     XY<NumType> _sOffset; ///< The offset for x0
     IndexType _midCellIdx = INDEX_TYPE_MAX; ///< Middle
@@ -746,93 +1342,70 @@ struct CosineDatapathDifferentiable
     XY<NumType> _midOffsetB;
     IndexType _tCellIdx = INDEX_TYPE_MAX; ///< Target
     XY<NumType> _tOffset;
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
     NumType _weight = 1.0;
     bool _enable = true;
 };
 
+template<typename NumType, typename CoordType>
+inline std::array<NumType, 6> CosineDatapathDifferentiable<NumType, CoordType>::variables() const
+{
+    std::array<NumType, 6> vars = { 0, 0, 0, 0, 0, 0 };
+    vars[0] = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::HORIZONTAL));
+    vars[1] = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::VERTICAL));
+    vars[2] = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::HORIZONTAL));
+    vars[3] = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::VERTICAL));
+    if (not isTwoPin())
+    {
+        vars[4] = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::HORIZONTAL));
+        vars[5] = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::VERTICAL));
+    }
+    return vars;
+}
+
+template<typename NumType, typename CoordType>
+template<typename ValueType>
+inline ValueType CosineDatapathDifferentiable<NumType, CoordType>::cosineCost(const std::array<ValueType, 6> &vars) const
+{
+    using std::sqrt;
+    using ad::square;
+    // a = s - mid, b = t - mid
+    const ValueType ax = vars[0] - vars[2] + (_sOffset.x() - _midOffsetA.x());
+    const ValueType ay = vars[1] - vars[3] + (_sOffset.y() - _midOffsetA.y());
+    const ValueType bx = vars[4] - vars[2] + (_tOffset.x() - _midOffsetB.x());
+    const ValueType by = vars[5] - vars[3] + (_tOffset.y() - _midOffsetB.y());
+    return (ax * bx + ay * by) / (sqrt(square(ax) + square(ay)) * sqrt(square(bx) + square(by))) + 1;
+}
+
 template<typename NumType, typename CoordType>
 inline NumType CosineDatapathDifferentiable<NumType, CoordType>::evaluate() const
 {
     if (not _enable) { return  0; }
-    const NumType lambda = _getLambdaFunc();
-    const NumType x1 = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::HORIZONTAL));
-    const NumType y1 = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::VERTICAL));
-    const NumType x2 = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::HORIZONTAL));
-    const NumType y2 = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::VERTICAL));
-    NumType x3 = 0;
-    NumType y3 = 0;
-    if (_tCellIdx != INDEX_TYPE_MAX)
-    {
-        x3 = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::HORIZONTAL));
-        y3 = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::VERTICAL));
-    }
-    const NumType ox1 = _sOffset.x();
-    const NumType oy1 = _sOffset.y();
-    const NumType ox2a = _midOffsetA.x();
-    const NumType oy2a = _midOffsetA.y();
-    const NumType ox2b = _midOffsetB.x();
-    const NumType oy2b = _midOffsetB.y();
-    const NumType ox3 = _tOffset.x();
-    const NumType oy3 = _tOffset.y();
-
-    return (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) + 1) * lambda * _weight;
+    return cosineCost(variables()) * _getLambdaFunc() * _weight;
 }
 
 template<typename NumType, typename CoordType>
 inline void CosineDatapathDifferentiable<NumType, CoordType>::accumlateGradient() const
 {
-    if (not _enable) { return; }
-    const NumType lambda = _getLambdaFunc();
-    const NumType x1 = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::HORIZONTAL));
-    const NumType y1 = op::conv<NumType>(_getVarFunc(_sCellIdx, Orient2DType::VERTICAL));
-    const NumType x2 = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::HORIZONTAL));
-    const NumType y2 = op::conv<NumType>(_getVarFunc(_midCellIdx, Orient2DType::VERTICAL));
-    NumType x3 = 0;
-    NumType y3 = 0;
-    if (_tCellIdx != INDEX_TYPE_MAX)
-    {
-        x3 = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::HORIZONTAL));
-        y3 = op::conv<NumType>(_getVarFunc(_tCellIdx, Orient2DType::VERTICAL));
-    }
-    const NumType ox1 = _sOffset.x();
-    const NumType oy1 = _sOffset.y();
-    const NumType ox2a = _midOffsetA.x();
-    const NumType oy2a = _midOffsetA.y();
-    const NumType ox2b = _midOffsetB.x();
-    const NumType oy2b = _midOffsetB.y();
-    const NumType ox3 = _tOffset.x();
-    const NumType oy3 = _tOffset.y();
-
-    NumType dx1 = (ox3 - ox2b - x2 + x3)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*ox1 - 2*ox2a + 2*x1 - 2*x2))/(2*pow(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0)));
-
-    dx1 *= lambda;
-
-    NumType dy1 = (oy3 - oy2b - y2 + y3)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*oy1 - 2*oy2a + 2*y1 - 2*y2))/(2*pow(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0)));
-    dy1 *= lambda;
-
-    NumType dx2 = (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*ox1 - 2*ox2a + 2*x1 - 2*x2))/(2*pow(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (ox1 + ox3 - ox2a - ox2b + x1 - 2*x2 + x3)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) + (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*ox3 - 2*ox2b - 2*x2 + 2*x3))/(2*sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*pow(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
-    dx2 *= lambda;
-
-    NumType dy2 = (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*oy1 - 2*oy2a + 2*y1 - 2*y2))/(2*pow(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (oy1 + oy3 - oy2a - oy2b + y1 - 2*y2 + y3)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) + (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*oy3 - 2*oy2b - 2*y2 + 2*y3))/(2*sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*pow(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
-    dy2 *= lambda;
-
-    NumType dx3 = 
-(ox1 - ox2a + x1 - x2)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*ox3 - 2*ox2b - 2*x2 + 2*x3))/(2*sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*pow(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
-    dx3 *= lambda;
-
-    NumType dy3 = 
-(oy1 - oy2a + y1 - y2)/(sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*sqrt(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0))) - (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*oy3 - 2*oy2b - 2*y2 + 2*y3))/(2*sqrt(pow(ox1 - ox2a + x1 - x2, 2.0) + pow(oy1 - oy2a + y1 - y2, 2.0))*pow(pow(ox3 - ox2b - x2 + x3, 2.0) + pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
-    dy3 *= lambda;
+    evaluateAndAccumulate();
+}
 
-    _accumulateGradFunc(dx1 * _weight, _sCellIdx, Orient2DType::HORIZONTAL);
-    _accumulateGradFunc(dy1 * _weight, _sCellIdx, Orient2DType::VERTICAL);
-    _accumulateGradFunc(dx2 * _weight, _midCellIdx, Orient2DType::HORIZONTAL);
-    _accumulateGradFunc(dy2 * _weight, _midCellIdx, Orient2DType::VERTICAL);
-    _accumulateGradFunc(dx3 * _weight, _tCellIdx, Orient2DType::HORIZONTAL);
-    _accumulateGradFunc(dy3 * _weight, _tCellIdx, Orient2DType::VERTICAL);
+template<typename NumType, typename CoordType>
+inline NumType CosineDatapathDifferentiable<NumType, CoordType>::evaluateAndAccumulate() const
+{
+    if (not _enable) { return 0; }
+    typedef ad::Dual<NumType, 6> dual_type;
+    const dual_type cost = cosineCost(ad::variables<dual_type>(variables()));
+    const NumType scale = _getLambdaFunc() * _weight;
+    _accumulateGradFunc(cost.partial(0) * scale, _sCellIdx, Orient2DType::HORIZONTAL);
+    _accumulateGradFunc(cost.partial(1) * scale, _sCellIdx, Orient2DType::VERTICAL);
+    _accumulateGradFunc(cost.partial(2) * scale, _midCellIdx, Orient2DType::HORIZONTAL);
+    _accumulateGradFunc(cost.partial(3) * scale, _midCellIdx, Orient2DType::VERTICAL);
+    _accumulateGradFunc(cost.partial(4) * scale, _tCellIdx, Orient2DType::HORIZONTAL);
+    _accumulateGradFunc(cost.partial(5) * scale, _tCellIdx, Orient2DType::VERTICAL);
+    return cost.value() * scale;
 }
 
 
@@ -843,11 +1416,11 @@ struct PowerVerQuadraticWireLengthDifferentiable
     typedef NumType numerical_type;
     typedef CoordType coordinate_type;
 
-    PowerVerQuadraticWireLengthDifferentiable(const std::function<NumType(void)> &getLambdaFunc) 
+    PowerVerQuadraticWireLengthDifferentiable(const NumericRef<NumType> &getLambdaFunc) 
     { _getLambdaFunc = getLambdaFunc; }
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
 
     void setVirtualPin(const CoordType &x, const CoordType &y) 
     { 
@@ -917,9 +1490,9 @@ struct PowerVerQuadraticWireLengthDifferentiable
     std::vector<CoordType> _offsetX;
     std::vector<CoordType> _offsetY;
     NumType _weight = 1;
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
 };
 
 
@@ -940,7 +1513,7 @@ struct CurrentFlowDifferentiable
     CurrentFlowDifferentiable(
             IndexType sCellIdx, const CoordType sOffset,
             IndexType tCellIdx, const CoordType tOffset,
-            const std::function<NumType(void)> &getLambdaFunc)
+            const NumericRef<NumType> &getLambdaFunc)
         : _sCellIdx(sCellIdx),
           _tCellIdx(tCellIdx), 
           _getLambdaFunc(getLambdaFunc)
@@ -951,9 +1524,9 @@ struct CurrentFlowDifferentiable
     
 
 
-    void setGetVarFunc(const std::function<CoordType(IndexType, Orient2DType)> &getVarFunc) { _getVarFunc = getVarFunc; }
-    void setAccumulateGradFunc(const std::function<void(NumType, IndexType, Orient2DType)> &func) { _accumulateGradFunc = func; }
-    void setGetAlphaFunc(const std::function<NumType(void)> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
 
     NumType evaluate() const;
     void accumlateGradient() const;
@@ -964,11 +1537,11 @@ struct CurrentFlowDifferentiable
     NumType _sOffset; ///< The offset for source y
     IndexType _tCellIdx = INDEX_TYPE_MAX; ///< Target
     NumType _tOffset; ///< The offset for target y
-    std::function<NumType(void)> _getLambdaFunc; ///< A function to get the current lambda multiplier
-    std::function<CoordType(IndexType cellIdx, Orient2DType orient)> _getVarFunc; ///< A function to get current variable value
-    std::function<void(NumType, IndexType, Orient2DType)> _accumulateGradFunc; ///< A function to update partial
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
     NumType _weight = 1.0;
-    std::function<NumType(void)> _getAlphaFunc;
+    NumericRef<NumType> _getAlphaFunc;
 };
 template<typename NumType, typename CoordType>
 inline NumType CurrentFlowDifferentiable<NumType, CoordType>::evaluate() const
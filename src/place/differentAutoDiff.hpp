@@ -0,0 +1,195 @@
+/**
+ * @file differentAutoDiff.hpp
+ * @brief Forward-mode automatic differentiation for writing the placement operators
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include "global/global.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace diff
+{
+    /// @namespace IDEAPLACE::diff::ad
+    /// @brief dual numbers for the operators with a few variables.
+    /// @details An operator writes its objective once as a template on the value type. Evaluated with plain numbers it gives the value,
+    /// and with Dual it gives the value and all the partials in the same pass. Every intermediate term is a variable of the expression
+    /// and is computed once, so the common subexpressions are shared instead of being repeated in each partial.
+    /// With Order 2 the diagonal of the hessian is carried too, which is what the jacobi hessian approximation needs.
+    /// The number of variables is a compile-time constant, so the loops over the partials are unrolled
+    namespace ad
+    {
+        /// @brief a number with its partials to N variables
+        /// @tparam the numerical type
+        /// @tparam the number of variables
+        /// @tparam 1: the gradient. 2: the gradient and the diagonal of the hessian
+        template<typename T, IndexType N, IndexType Order = 1>
+        struct Dual
+        {
+            static_assert(Order == 1 or Order == 2, "Only the gradient and the diagonal hessian are supported");
+            typedef T value_type;
+            static constexpr IndexType numVars = N;
+            static constexpr bool hasHessian = Order == 2;
+
+            T val = 0; ///< The value
+            std::array<T, N> d = {}; ///< The partials
+            std::array<T, hasHessian ? N : 0> dd = {}; ///< The second partials, d2/dxi2
+
+            Dual() = default;
+            /// @brief a constant
+            Dual(T value) : val(value) {}
+            /// @brief the variable of an index
+            static Dual variable(T value, IndexType varIdx)
+            {
+                Dual x(value);
+                x.d[varIdx] = 1;
+                return x;
+            }
+            T value() const { return val; }
+            T partial(IndexType varIdx) const { return d[varIdx]; }
+            T secondPartial(IndexType varIdx) const { return dd[varIdx]; }
+
+            /// @brief apply a unary function by the chain rule
+            /// @param f(val)
+            /// @param f'(val)
+            /// @param f''(val). Unused for Order 1
+            Dual chain(T f, T df, T ddf) const
+            {
+                Dual r(f);
+                for (IndexType i = 0; i < N; ++i)
+                {
+                    r.d[i] = df * d[i];
+                }
+                if constexpr (hasHessian)
+                {
+                    for (IndexType i = 0; i < N; ++i)
+                    {
+                        r.dd[i] = df * dd[i] + ddf * d[i] * d[i];
+                    }
+                }
+                return r;
+            }
+
+            Dual operator-() const { return chain(-val, -1, 0); }
+            Dual & operator+=(const Dual &rhs)
+            {
+                val += rhs.val;
+                for (IndexType i = 0; i < N; ++i) { d[i] += rhs.d[i]; }
+                if constexpr (hasHessian) { for (IndexType i = 0; i < N; ++i) { dd[i] += rhs.dd[i]; } }
+                return *this;
+            }
+            Dual & operator-=(const Dual &rhs)
+            {
+                val -= rhs.val;
+                for (IndexType i = 0; i < N; ++i) { d[i] -= rhs.d[i]; }
+                if constexpr (hasHessian) { for (IndexType i = 0; i < N; ++i) { dd[i] -= rhs.dd[i]; } }
+                return *this;
+            }
+            Dual & operator*=(const Dual &rhs)
+            {
+                if constexpr (hasHessian)
+                {
+                    for (IndexType i = 0; i < N; ++i) { dd[i] = dd[i] * rhs.val + 2 * d[i] * rhs.d[i] + val * rhs.dd[i]; }
+                }
+                for (IndexType i = 0; i < N; ++i) { d[i] = d[i] * rhs.val + val * rhs.d[i]; }
+                val *= rhs.val;
+                return *this;
+            }
+            Dual & operator/=(const Dual &rhs)
+            {
+                const T inv = 1 / rhs.val;
+                return *this *= rhs.chain(inv, -inv * inv, 2 * inv * inv * inv);
+            }
+            /* The constants only scale or shift */
+            Dual & operator+=(T rhs) { val += rhs; return *this; }
+            Dual & operator-=(T rhs) { val -= rhs; return *this; }
+            Dual & operator*=(T rhs)
+            {
+                val *= rhs;
+                for (IndexType i = 0; i < N; ++i) { d[i] *= rhs; }
+                if constexpr (hasHessian) { for (IndexType i = 0; i < N; ++i) { dd[i] *= rhs; } }
+                return *this;
+            }
+            Dual & operator/=(T rhs) { return *this *= (1 / rhs); }
+        };
+
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator+(Dual<T, N, O> lhs, const Dual<T, N, O> &rhs) { return lhs += rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator-(Dual<T, N, O> lhs, const Dual<T, N, O> &rhs) { return lhs -= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator*(Dual<T, N, O> lhs, const Dual<T, N, O> &rhs) { return lhs *= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator/(Dual<T, N, O> lhs, const Dual<T, N, O> &rhs) { return lhs /= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator+(Dual<T, N, O> lhs, typename Dual<T, N, O>::value_type rhs) { return lhs += rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator-(Dual<T, N, O> lhs, typename Dual<T, N, O>::value_type rhs) { return lhs -= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator*(Dual<T, N, O> lhs, typename Dual<T, N, O>::value_type rhs) { return lhs *= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator/(Dual<T, N, O> lhs, typename Dual<T, N, O>::value_type rhs) { return lhs /= rhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator+(typename Dual<T, N, O>::value_type lhs, Dual<T, N, O> rhs) { return rhs += lhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator-(typename Dual<T, N, O>::value_type lhs, const Dual<T, N, O> &rhs) { return -rhs + lhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator*(typename Dual<T, N, O>::value_type lhs, Dual<T, N, O> rhs) { return rhs *= lhs; }
+        template<typename T, IndexType N, IndexType O> inline Dual<T, N, O> operator/(typename Dual<T, N, O>::value_type lhs, const Dual<T, N, O> &rhs)
+        {
+            const T inv = 1 / rhs.val;
+            return rhs.chain(lhs * inv, -lhs * inv * inv, 2 * lhs * inv * inv * inv);
+        }
+
+        /// @brief make the variables of an operator
+        /// @param the values of the variables. The i-th is the variable of index i
+        template<typename DualType, std::size_t N>
+        inline std::array<DualType, N> variables(const std::array<typename DualType::value_type, N> &values)
+        {
+            static_assert(N == DualType::numVars, "The number of the values must be that of the variables");
+            std::array<DualType, N> vars;
+            for (IndexType i = 0; i < N; ++i)
+            {
+                vars[i] = DualType::variable(values[i], i);
+            }
+            return vars;
+        }
+
+        /* The functions. Found by argument-dependent lookup, so an objective written with the unqualified names works for both the plain numbers (std::) and Dual */
+        template<typename T, IndexType N, IndexType O>
+        inline Dual<T, N, O> sqrt(const Dual<T, N, O> &x)
+        {
+            const T s = std::sqrt(x.val);
+            const T df = 1 / (2 * s);
+            return x.chain(s, df, -2 * df * df * df);
+        }
+        template<typename T, IndexType N, IndexType O>
+        inline Dual<T, N, O> exp(const Dual<T, N, O> &x)
+        {
+            const T e = std::exp(x.val);
+            return x.chain(e, e, e);
+        }
+        template<typename T, IndexType N, IndexType O>
+        inline Dual<T, N, O> log(const Dual<T, N, O> &x)
+        {
+            const T inv = 1 / x.val;
+            return x.chain(std::log(x.val), inv, -inv * inv);
+        }
+        /// @brief x^p. Each derivative is computed with its own power so that they stay finite at x = 0 where they exist:
+        /// x^(p-2) is inf at zero for p < 2 and would turn the lower derivatives into NaN.
+        /// The second derivative is computed only with the hessian, and the terms with a zero coefficient are dropped
+        template<typename T, IndexType N, IndexType O>
+        inline Dual<T, N, O> pow(const Dual<T, N, O> &x, typename Dual<T, N, O>::value_type p)
+        {
+            const T df = p == 0 ? T(0) : p * std::pow(x.val, p - 1);
+            T ddf = 0;
+            if constexpr (Dual<T, N, O>::hasHessian)
+            {
+                ddf = p == 0 or p == 1 ? T(0) : p * (p - 1) * std::pow(x.val, p - 2);
+            }
+            return x.chain(std::pow(x.val, p), df, ddf);
+        }
+        /// @brief x * x. Cheaper than pow(x, 2)
+        template<typename T, IndexType N, IndexType O>
+        inline Dual<T, N, O> square(const Dual<T, N, O> &x) { return x.chain(x.val * x.val, 2 * x.val, 2); }
+        template<typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+        inline T square(T x) { return x * x; }
+    } // namespace ad
+} // namespace diff
+
+PROJECT_NAMESPACE_END
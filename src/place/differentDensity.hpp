@@ -0,0 +1,458 @@
+/**
+ * @file differentDensity.hpp
+ * @brief The electrostatic density penalty. Alternative to the pair-wise overlapping penalty for large designs
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <complex>
+#include <unsupported/Eigen/FFT>
+#include "different.h"
+#include "differentSecondOrder.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace diff
+{
+
+/// @brief The electrostatic system of the cell density, in the style of ePlace.
+/// @details The cell areas are deposited into M x M bins over the placement region as charges. The Poisson equation is solved spectrally with DCT, computed with FFT.
+/// The penalty is the potential energy 1/2 * sum(q_i * psi_i) of the binned charges. Its gradient is the exact derivative of the binned energy:
+/// moving a cell changes its overlapping areas with the bins at its edges, weighted by the potential of those bins.
+/// The cells smaller than sqrt(2) bins are stretched to sqrt(2) bins with lowered density to keep the penalty smooth.
+/// The bins are indexed with local cell indices, i.e. the order of addCell
+template<typename NumType, typename CoordType>
+class ElectrostaticDensityMap
+{
+    public:
+        typedef Eigen::Matrix<NumType, Eigen::Dynamic, Eigen::Dynamic> matrix_type;
+        typedef std::vector<std::complex<NumType>> complex_vector_type;
+
+        /// @param the placement region. The pointer need to be kept valid
+        /// @param the number of bins in each direction. Should be power of two
+        explicit ElectrostaticDensityMap(const Box<CoordType> *region, IndexType numBinsPerDim)
+            : _region(region), _numBins(numBinsPerDim)
+        {
+            _density.resize(_numBins, _numBins);
+            _exactArea.resize(_numBins, _numBins);
+            _potential.resize(_numBins, _numBins);
+            _coef.resize(_numBins, _numBins);
+            _tmp.resize(_numBins, _numBins);
+            _fft.SetFlag(Eigen::FFT<NumType>::Unscaled);
+        }
+        /// @brief add a cell into the system
+        void addCell(IndexType cellIdx, CoordType width, CoordType height)
+        {
+            _cells.emplace_back(cellIdx);
+            _widths.emplace_back(width);
+            _heights.emplace_back(height);
+        }
+        /// @brief deposit the charges and solve the potential
+        template<typename get_var_func_type>
+        void update(const get_var_func_type &getVarFunc)
+        {
+            const IndexType numCells = _cells.size();
+            _binW = std::max(_region->xLen() / _numBins, static_cast<CoordType>(REAL_TYPE_TOL));
+            _binH = std::max(_region->yLen() / _numBins, static_cast<CoordType>(REAL_TYPE_TOL));
+            _smoothX.resize(numCells); _smoothY.resize(numCells);
+            _smoothW.resize(numCells); _smoothH.resize(numCells);
+            _smoothScale.resize(numCells);
+            _smoothMovableX.resize(numCells); _smoothMovableY.resize(numCells);
+            _exactX.resize(numCells); _exactY.resize(numCells);
+            _density.setZero();
+            _exactArea.setZero();
+            const CoordType minW = std::sqrt(2.0) * _binW;
+            const CoordType minH = std::sqrt(2.0) * _binH;
+            for (IndexType idx = 0; idx < numCells; ++idx)
+            {
+                const CoordType x = getVarFunc(_cells[idx], Orient2DType::HORIZONTAL);
+                const CoordType y = getVarFunc(_cells[idx], Orient2DType::VERTICAL);
+                // Exact footprint for the overflow
+                _exactX[idx] = clampIntoRegion(x, _widths[idx], _region->xLo(), _region->xHi());
+                _exactY[idx] = clampIntoRegion(y, _heights[idx], _region->yLo(), _region->yHi());
+                forEachBin(_exactX[idx], _exactY[idx], _widths[idx], _heights[idx], [&](IndexType bx, IndexType by, CoordType area)
+                        {
+                            _exactArea(bx, by) += area;
+                        });
+                // Smoothed footprint for the potential
+                _smoothW[idx] = std::max(_widths[idx], minW);
+                _smoothH[idx] = std::max(_heights[idx], minH);
+                _smoothScale[idx] = (_widths[idx] * _heights[idx]) / (_smoothW[idx] * _smoothH[idx]);
+                const CoordType smoothXLo = x + (_widths[idx] - _smoothW[idx]) / 2;
+                const CoordType smoothYLo = y + (_heights[idx] - _smoothH[idx]) / 2;
+                _smoothX[idx] = clampIntoRegion(smoothXLo, _smoothW[idx], _region->xLo(), _region->xHi());
+                _smoothY[idx] = clampIntoRegion(smoothYLo, _smoothH[idx], _region->yLo(), _region->yHi());
+                // The clamped footprint does not follow the cell
+                _smoothMovableX[idx] = _smoothX[idx] == smoothXLo;
+                _smoothMovableY[idx] = _smoothY[idx] == smoothYLo;
+                const NumType scale = _smoothScale[idx] / (_binW * _binH);
+                forEachBin(_smoothX[idx], _smoothY[idx], _smoothW[idx], _smoothH[idx], [&](IndexType bx, IndexType by, CoordType area)
+                        {
+                            _density(bx, by) += area * scale;
+                        });
+            }
+            solvePoisson();
+            _isUpdated = true;
+        }
+        /// @brief the potential energy of a cell: q_i * psi_i
+        NumType cellEnergy(IndexType localIdx) const
+        {
+            NumType energy = 0;
+            forEachBin(_smoothX[localIdx], _smoothY[localIdx], _smoothW[localIdx], _smoothH[localIdx], [&](IndexType bx, IndexType by, CoordType area)
+                    {
+                        energy += area * _potential(bx, by);
+                    });
+            return energy * _smoothScale[localIdx];
+        }
+        /// @brief the gradient of the total energy with respect to a cell location
+        /// @details The energy is 1/2 rho^T G rho with the symmetric Green's operator G, so the partial of x_i is q_i * sum_b (d a_ib / dx_i) * psi_b,
+        /// where a_ib is the overlapping area with bin b. Only the bins under the left and right edges have d a_ib / dx_i, of -ovlY and +ovlY
+        void cellGradient(IndexType localIdx, NumType &dx, NumType &dy) const
+        {
+            const CoordType xLo = _smoothX[localIdx];
+            const CoordType yLo = _smoothY[localIdx];
+            const CoordType xHi = xLo + _smoothW[localIdx];
+            const CoordType yHi = yLo + _smoothH[localIdx];
+            dx = 0;
+            dy = 0;
+            if (_smoothMovableX[localIdx])
+            {
+                dx = edgeSum(xLo, xHi, yLo, yHi, true);
+            }
+            if (_smoothMovableY[localIdx])
+            {
+                dy = edgeSum(yLo, yHi, xLo, xHi, false);
+            }
+            dx *= _smoothScale[localIdx];
+            dy *= _smoothScale[localIdx];
+        }
+        /// @brief the distance from the moving edges of the smoothed footprint of a cell to the nearest bin edge.
+        /// @details The binned energy is piecewise quadratic in the cell location, with kinks where an edge crosses a bin edge.
+        /// A footprint clamped by the region is on a bin edge, i.e. at the kink of the clamping
+        /// @param the local index of the cell
+        /// @param true: the horizontal edges. false: the vertical edges
+        CoordType distanceToBinEdge(IndexType localIdx, bool isHor) const
+        {
+            const CoordType lo = isHor ? _smoothX[localIdx] : _smoothY[localIdx];
+            const CoordType hi = lo + (isHor ? _smoothW[localIdx] : _smoothH[localIdx]);
+            const CoordType regionLo = isHor ? _region->xLo() : _region->yLo();
+            const CoordType binLen = isHor ? _binW : _binH;
+            auto distance = [&](CoordType loc)
+            {
+                const CoordType offset = (loc - regionLo) / binLen;
+                return std::min(offset - std::floor(offset), std::ceil(offset) - offset) * binLen;
+            };
+            return std::min(distance(lo), distance(hi));
+        }
+        /// @brief the area of the cells exceeding the target density in a bin
+        CoordType binOverflowArea(IndexType binIdx, CoordType targetDensity) const
+        {
+            const IndexType bx = binIdx / _numBins;
+            const IndexType by = binIdx % _numBins;
+            return std::max(_exactArea(bx, by) - targetDensity * _binW * _binH, static_cast<CoordType>(0));
+        }
+        /// @brief get the number of cells
+        IndexType numCells() const { return _cells.size(); }
+        /// @brief get the database cell index of a local index
+        IndexType cellIdx(IndexType localIdx) const { return _cells[localIdx]; }
+        /// @brief get the charge of a cell
+        NumType charge(IndexType localIdx) const { return _widths[localIdx] * _heights[localIdx]; }
+        /// @brief get the total number of bins
+        IndexType numTotalBins() const { return _numBins * _numBins; }
+        /// @brief whether the system has been solved
+        bool isUpdated() const { return _isUpdated; }
+    private:
+        static CoordType clampIntoRegion(CoordType lo, CoordType len, CoordType regionLo, CoordType regionHi)
+        {
+            return std::max(std::min(lo, regionHi - len), regionLo);
+        }
+        /// @brief sum_b psi_b * (the overlapping length with the bin along the other direction), over the bins under the high edge minus those under the low edge
+        /// @param the low edge in the moving direction
+        /// @param the high edge in the moving direction
+        /// @param the low edge in the other direction
+        /// @param the high edge in the other direction
+        /// @param true: moving horizontally. false: vertically
+        NumType edgeSum(CoordType lo, CoordType hi, CoordType otherLo, CoordType otherHi, bool isHor) const
+        {
+            const CoordType regionLo = isHor ? _region->xLo() : _region->yLo();
+            const CoordType regionHi = isHor ? _region->xHi() : _region->yHi();
+            const CoordType otherRegionLo = isHor ? _region->yLo() : _region->xLo();
+            const CoordType binLen = isHor ? _binW : _binH;
+            const CoordType otherBinLen = isHor ? _binH : _binW;
+            otherHi = std::min(otherHi, isHor ? _region->yHi() : _region->xHi());
+            const IndexType otherLoIdx = binIdx(otherLo, otherRegionLo, otherBinLen);
+            const IndexType otherHiIdx = binIdx(otherHi, otherRegionLo, otherBinLen);
+            auto sumAlongEdge = [&](IndexType edgeBin)
+            {
+                NumType sum = 0;
+                for (IndexType idx = otherLoIdx; idx <= otherHiIdx; ++idx)
+                {
+                    const CoordType binLo = otherRegionLo + idx * otherBinLen;
+                    const CoordType ovl = std::min(otherHi, binLo + otherBinLen) - std::max(otherLo, binLo);
+                    if (ovl <= 0) { continue; }
+                    sum += ovl * (isHor ? _potential(edgeBin, idx) : _potential(idx, edgeBin));
+                }
+                return sum;
+            };
+            NumType sum = 0;
+            // The edges on the region boundary do not change the areas inside the region
+            if (hi < regionHi)
+            {
+                sum += sumAlongEdge(binIdx(hi, regionLo, binLen));
+            }
+            if (lo >= regionLo)
+            {
+                sum -= sumAlongEdge(binIdx(lo, regionLo, binLen));
+            }
+            return sum;
+        }
+        /// @brief call func(bx, by, overlapping area) for the bins overlapping with a rectangle
+        template<typename func_type>
+        void forEachBin(CoordType xLo, CoordType yLo, CoordType w, CoordType h, func_type &&func) const
+        {
+            const CoordType xHi = std::min(xLo + w, _region->xHi());
+            const CoordType yHi = std::min(yLo + h, _region->yHi());
+            const IndexType bxLo = binIdx(xLo, _region->xLo(), _binW);
+            const IndexType bxHi = binIdx(xHi, _region->xLo(), _binW);
+            const IndexType byLo = binIdx(yLo, _region->yLo(), _binH);
+            const IndexType byHi = binIdx(yHi, _region->yLo(), _binH);
+            for (IndexType bx = bxLo; bx <= bxHi; ++bx)
+            {
+                const CoordType binXLo = _region->xLo() + bx * _binW;
+                const CoordType ovlX = std::min(xHi, binXLo + _binW) - std::max(xLo, binXLo);
+                if (ovlX <= 0) { continue; }
+                for (IndexType by = byLo; by <= byHi; ++by)
+                {
+                    const CoordType binYLo = _region->yLo() + by * _binH;
+                    const CoordType ovlY = std::min(yHi, binYLo + _binH) - std::max(yLo, binYLo);
+                    if (ovlY <= 0) { continue; }
+                    func(bx, by, ovlX * ovlY);
+                }
+            }
+        }
+        IndexType binIdx(CoordType loc, CoordType lo, CoordType binSize) const
+        {
+            const CoordType idx = std::floor((loc - lo) / binSize);
+            if (idx < 0) { return 0; }
+            return std::min(static_cast<IndexType>(idx), _numBins - 1);
+        }
+        /// @brief DCT-II: out_k = sum_n in_n cos(pi k (n + 1/2) / M)
+        void dct(const NumType *in, IndexType stride, NumType *out, IndexType outStride)
+        {
+            const IndexType m = _numBins;
+            for (IndexType n = 0; n < m; ++n)
+            {
+                _timeBuf[n] = in[n * stride];
+                _timeBuf[2 * m - 1 - n] = in[n * stride];
+            }
+            _fft.fwd(_freqBuf, _timeBuf);
+            for (IndexType k = 0; k < m; ++k)
+            {
+                out[k * outStride] = 0.5 * std::real(_twiddleNeg[k] * _freqBuf[k]);
+            }
+        }
+        /// @brief cosOut_n = sum_k in_k cos(pi k (n + 1/2) / M), sinOut_n = sum_k in_k sin(pi k (n + 1/2) / M)
+        void cosSinSum(const NumType *in, IndexType stride, NumType *cosOut, NumType *sinOut, IndexType outStride)
+        {
+            const IndexType m = _numBins;
+            for (IndexType k = 0; k < m; ++k)
+            {
+                _freqBuf[k] = in[k * stride] * _twiddlePos[k];
+                _freqBuf[k + m] = 0;
+            }
+            _fft.inv(_timeBuf, _freqBuf);
+            for (IndexType n = 0; n < m; ++n)
+            {
+                if (cosOut) { cosOut[n * outStride] = std::real(_timeBuf[n]); }
+                if (sinOut) { sinOut[n * outStride] = std::imag(_timeBuf[n]); }
+            }
+        }
+        void solvePoisson()
+        {
+            const IndexType m = _numBins;
+            if (_twiddlePos.size() != m)
+            {
+                _twiddlePos.resize(m);
+                _twiddleNeg.resize(m);
+                _freq.resize(m);
+                for (IndexType k = 0; k < m; ++k)
+                {
+                    const NumType theta = M_PI * k / (2 * m);
+                    _twiddlePos[k] = std::complex<NumType>(std::cos(theta), std::sin(theta));
+                    _twiddleNeg[k] = std::complex<NumType>(std::cos(theta), -std::sin(theta));
+                    _freq[k] = M_PI * k / m;
+                }
+                _timeBuf.resize(2 * m);
+                _freqBuf.resize(2 * m);
+            }
+            // Eigen matrices are column major. (bx, by) -> data[bx + by * m]
+            matrix_type &coef = _coef;
+            matrix_type &tmp = _tmp;
+            for (IndexType by = 0; by < m; ++by)
+            {
+                dct(_density.data() + by * m, 1, tmp.data() + by * m, 1);
+            }
+            for (IndexType u = 0; u < m; ++u)
+            {
+                dct(tmp.data() + u, m, coef.data() + u, m);
+            }
+            // a_uv = c_u c_v / M^2 * DCT(rho), psi_uv = a_uv / (w_u^2 + w_v^2)
+            for (IndexType u = 0; u < m; ++u)
+            {
+                for (IndexType v = 0; v < m; ++v)
+                {
+                    if (u == 0 and v == 0)
+                    {
+                        coef(u, v) = 0;
+                        continue;
+                    }
+                    const NumType cu = u == 0 ? 1 : 2;
+                    const NumType cv = v == 0 ? 1 : 2;
+                    const NumType a = coef(u, v) * cu * cv / (m * m);
+                    const NumType psi = a / (_freq[u] * _freq[u] + _freq[v] * _freq[v]);
+                    coef(u, v) = psi;
+                }
+            }
+            // psi = sum coef cos cos
+            for (IndexType v = 0; v < m; ++v)
+            {
+                cosSinSum(coef.data() + v * m, 1, tmp.data() + v * m, nullptr, 1);
+            }
+            for (IndexType bx = 0; bx < m; ++bx)
+            {
+                cosSinSum(tmp.data() + bx, m, _potential.data() + bx, nullptr, m);
+            }
+        }
+    private:
+        const Box<CoordType> *_region = nullptr; ///< The placement region
+        IndexType _numBins = 0; ///< The number of bins in each direction
+        CoordType _binW = 1; ///< The width of the bins
+        CoordType _binH = 1; ///< The height of the bins
+        std::vector<IndexType> _cells; ///< The database indices of the cells
+        std::vector<CoordType> _widths; ///< The widths of the cells
+        std::vector<CoordType> _heights; ///< The heights of the cells
+        std::vector<CoordType> _exactX, _exactY; ///< The lower-left of the cells clamped into the region
+        std::vector<CoordType> _smoothX, _smoothY, _smoothW, _smoothH; ///< The smoothed footprint of the cells
+        std::vector<NumType> _smoothScale; ///< The density scaling of the smoothed footprint
+        std::vector<char> _smoothMovableX, _smoothMovableY; ///< Whether the smoothed footprint is not clamped by the region, i.e. moves with the cell
+        matrix_type _density; ///< The smoothed charge density of the bins
+        matrix_type _exactArea; ///< The exact cell area in the bins
+        matrix_type _potential; ///< The potential of the bins
+        matrix_type _coef, _tmp; ///< The buffers of the spectral solve
+        Eigen::FFT<NumType> _fft; ///< The FFT engine
+        complex_vector_type _timeBuf, _freqBuf; ///< The buffers for FFT
+        complex_vector_type _twiddlePos, _twiddleNeg; ///< exp(+/- i pi k / 2M)
+        std::vector<NumType> _freq; ///< The frequencies pi k / M
+        bool _isUpdated = false;
+};
+
+/// @brief electrostatic density penalty. Multiple operators can share one density map. Each of them evaluates a strided slice of the cells
+/// @details The density map need to be updated (updateDensityMap) before the evaluations whenever the placement has changed
+template<typename NumType, typename CoordType>
+struct ElectrostaticDensityPenaltyDifferentiable
+{
+    typedef NumType numerical_type;
+    typedef CoordType coordinate_type;
+    typedef ElectrostaticDensityMap<NumType, CoordType> density_map_type;
+
+    ElectrostaticDensityPenaltyDifferentiable(const std::shared_ptr<density_map_type> &densityMap, IndexType sliceIdx, IndexType numSlices,
+                           const NumericRef<NumType> &getAlphaFunc, const NumericRef<NumType> &getLambdaFunc)
+    {
+        _densityMap = densityMap;
+        _sliceIdx = sliceIdx;
+        _numSlices = numSlices;
+        _getAlphaFunc = getAlphaFunc;
+        _getLambdaFunc = getLambdaFunc;
+    }
+
+    void setGetVarFunc(const PlaceVarView<CoordType, CoordType> &getVarFunc) { _getVarFunc = getVarFunc; }
+    void setAccumulateGradFunc(const PartialAccumulator<NumType> &func) { _accumulateGradFunc = func; }
+    /// @brief the density penalty is smoothed by the bins. Alpha is not used
+    void setGetAlphaFunc(const NumericRef<NumType> &getAlphaFunc) { _getAlphaFunc = getAlphaFunc; }
+    /// @brief solve the shared density map. Not thread-safe
+    void updateDensityMap() { _densityMap->update(_getVarFunc); }
+
+    NumType evaluate() const
+    {
+        Assert(_densityMap->isUpdated());
+        const NumType lambda = _getLambdaFunc();
+        NumType energy = 0;
+        for (IndexType idx = _sliceIdx; idx < _densityMap->numCells(); idx += _numSlices)
+        {
+            energy += _densityMap->cellEnergy(idx);
+        }
+        return lambda * 0.5 * energy;
+    }
+
+    void accumlateGradient() const
+    {
+        Assert(_densityMap->isUpdated());
+        const NumType lambda = _getLambdaFunc();
+        for (IndexType idx = _sliceIdx; idx < _densityMap->numCells(); idx += _numSlices)
+        {
+            NumType dx, dy;
+            _densityMap->cellGradient(idx, dx, dy);
+            _accumulateGradFunc(lambda * dx, _densityMap->cellIdx(idx), Orient2DType::HORIZONTAL);
+            _accumulateGradFunc(lambda * dy, _densityMap->cellIdx(idx), Orient2DType::VERTICAL);
+        }
+    }
+
+    std::shared_ptr<density_map_type> _densityMap; ///< The shared density map
+    IndexType _sliceIdx = 0; ///< The cells of _sliceIdx + k * _numSlices are evaluated by this operator
+    IndexType _numSlices = 1; ///< The number of operators sharing the density map
+    NumericRef<NumType> _getAlphaFunc; ///< The current alpha
+    NumericRef<NumType> _getLambdaFunc; ///< The current lambda multiplier
+    PlaceVarView<CoordType, CoordType> _getVarFunc; ///< The view of the current variable values
+    PartialAccumulator<NumType> _accumulateGradFunc; ///< The accumulator of the partials
+};
+
+template<typename NumType, typename CoordType>
+struct place_overlap_trait<ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType>>
+{
+    typedef ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType> op_type;
+    typedef typename op_type::coordinate_type coordinate_type;
+    static constexpr coordinate_type targetDensity = 1.0;
+    /// @brief the density overflow area of the slice of bins of an operator
+    static coordinate_type overlapArea(op_type &ovl)
+    {
+        coordinate_type area = 0;
+        for (IndexType binIdx = ovl._sliceIdx; binIdx < ovl._densityMap->numTotalBins(); binIdx += ovl._numSlices)
+        {
+            area += ovl._densityMap->binOverflowArea(binIdx, targetDensity);
+        }
+        return area;
+    }
+};
+
+template<typename NumType, typename CoordType>
+struct is_density_overlap_operator<ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType>> : std::true_type {};
+
+template <typename NumType, typename CoordType>
+struct is_placement_differentiable_concept<ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType>>
+{
+    typedef std::true_type  is_placement_differentiable_concept_type;
+};
+
+/// @brief the charge-based preconditioner of ePlace
+template<typename NumType, typename CoordType>
+struct jacobi_hessian_approx_trait<ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType>>
+{
+    typedef ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType> operator_type;
+    static void accumulateHessian(const operator_type & op, const std::function<void(NumType, IndexType, IndexType, Orient2DType, Orient2DType)> &accumulateHessianFunc)
+    {
+        const NumType lambda = op._getLambdaFunc();
+        const auto &densityMap = *op._densityMap;
+        for (IndexType idx = op._sliceIdx; idx < densityMap.numCells(); idx += op._numSlices)
+        {
+            const IndexType cellIdx = densityMap.cellIdx(idx);
+            accumulateHessianFunc(lambda * densityMap.charge(idx), cellIdx, cellIdx, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
+            accumulateHessianFunc(lambda * densityMap.charge(idx), cellIdx, cellIdx, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
+        }
+    }
+};
+
+} // namespace diff
+
+PROJECT_NAMESPACE_END
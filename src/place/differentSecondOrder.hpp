@@ -24,6 +24,10 @@ namespace diff
     template<typename operator_type>
     struct is_diagnol_matrix<jacobi_hessian_approx_trait<operator_type>> : std::true_type {};
 
+    /// @brief the exact hessian, including the entries coupling different variables
+    template<typename operator_type>
+    struct full_hessian_trait {};
+
 
     template<typename NumType, typename CoordType>
     struct jacobi_hessian_approx_trait<LseHpwlDifferentiable<NumType, CoordType>>
@@ -79,6 +83,67 @@ namespace diff
     };
 
 
+    /// @brief the hessian of the LSE HPWL is (lambda * weight / alpha) * (diag(p) - p p^T + diag(q) - q q^T) in each direction,
+    /// where p and q are the softmax weights of the pins for the max and the min. It couples all the pins of the net
+    template<typename NumType, typename CoordType>
+    struct full_hessian_trait<LseHpwlDifferentiable<NumType, CoordType>>
+    {
+        typedef LseHpwlDifferentiable<NumType, CoordType> operator_type;
+        static void accumulateHessian(const operator_type & op, const std::function<void(NumType, IndexType, IndexType, Orient2DType, Orient2DType)> &accumulateHessianFunc)
+        {
+            if (! op.validHpwl())
+            {
+                return;
+            }
+            const NumType alpha = op._getAlphaFunc();
+            const NumType scale = op._getLambdaFunc() * op._weight / alpha;
+            const IndexType numPins = op._cells.size();
+            std::vector<NumType> coord(numPins), maxWeight(numPins), minWeight(numPins);
+            for (Orient2DType orient : { Orient2DType::HORIZONTAL, Orient2DType::VERTICAL })
+            {
+                const bool isHor = orient == Orient2DType::HORIZONTAL;
+                const NumType virtualPin = op::conv<NumType>(isHor ? op._virtualPinX : op._virtualPinY);
+                NumType hi = op._validVirtualPin == 1 ? virtualPin : std::numeric_limits<NumType>::lowest();
+                NumType lo = op._validVirtualPin == 1 ? virtualPin : std::numeric_limits<NumType>::max();
+                for (IndexType pinIdx = 0; pinIdx < numPins; ++pinIdx)
+                {
+                    coord[pinIdx] = op::conv<NumType>(
+                            op._getVarFunc(op._cells[pinIdx], orient) + (isHor ? op._offsetX[pinIdx] : op._offsetY[pinIdx])
+                            );
+                    hi = std::max(hi, coord[pinIdx]);
+                    lo = std::min(lo, coord[pinIdx]);
+                }
+                // Shift the exponents by the extremes so that they do not overflow
+                NumType maxSum = op._validVirtualPin == 1 ? std::exp((virtualPin - hi) / alpha) : 0;
+                NumType minSum = op._validVirtualPin == 1 ? std::exp((lo - virtualPin) / alpha) : 0;
+                for (IndexType pinIdx = 0; pinIdx < numPins; ++pinIdx)
+                {
+                    maxWeight[pinIdx] = std::exp((coord[pinIdx] - hi) / alpha);
+                    minWeight[pinIdx] = std::exp((lo - coord[pinIdx]) / alpha);
+                    maxSum += maxWeight[pinIdx];
+                    minSum += minWeight[pinIdx];
+                }
+                for (IndexType pinIdx = 0; pinIdx < numPins; ++pinIdx)
+                {
+                    maxWeight[pinIdx] /= maxSum;
+                    minWeight[pinIdx] /= minSum;
+                }
+                for (IndexType i = 0; i < numPins; ++i)
+                {
+                    for (IndexType j = 0; j < numPins; ++j)
+                    {
+                        NumType value = - maxWeight[i] * maxWeight[j] - minWeight[i] * minWeight[j];
+                        if (i == j)
+                        {
+                            value += maxWeight[i] + minWeight[i];
+                        }
+                        accumulateHessianFunc(scale * value, op._cells[i], op._cells[j], orient, orient);
+                    }
+                }
+            }
+        }
+    };
+
     template<typename NumType, typename CoordType>
     struct jacobi_hessian_approx_trait<CellPairOverlapPenaltyDifferentiable<NumType, CoordType>>
     {
@@ -96,6 +161,14 @@ namespace diff
             const NumType hi = op::conv<NumType>(op._cellHeightI);
             const NumType wj = op::conv<NumType>(op._cellWidthJ);
             const NumType hj = op::conv<NumType>(op._cellHeightJ);
+            accumulatePairHessian(alpha, lambda, op._cellIdxI, xi, yi, wi, hi, op._cellIdxJ, xj, yj, wj, hj, accumulateHessianFunc);
+        }
+        /// @brief accumulate the jacobi hessian of a single pair of cells
+        static void accumulatePairHessian(NumType alpha, NumType lambda,
+                IndexType cellIdxI, NumType xi, NumType yi, NumType wi, NumType hi,
+                IndexType cellIdxJ, NumType xj, NumType yj, NumType wj, NumType hj,
+                const std::function<void(NumType, IndexType, IndexType, Orient2DType, Orient2DType)> &accumulateHessianFunc)
+        {
 
             const NumType dxi2 = (2*std::pow(alpha, 2.0)*log(1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1)*std::pow(exp(-(wi + xi - xj)/alpha)/alpha - exp(-(wj - xi + xj)/alpha)/alpha, 2.0))/((1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1)*std::pow(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha), 3.0)) - (std::pow(alpha, 2.0)*log(1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1)*std::pow(exp(-(wi + xi - xj)/alpha)/alpha - exp(-(wj - xi + xj)/alpha)/alpha, 2.0))/(std::pow(1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1, 2.0)*std::pow(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha), 4.0)) - (std::pow(alpha, 2.0)*log(1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1)*(exp(-(wi + xi - xj)/alpha)/std::pow(alpha, 2.0) + exp(-(wj - xi + xj)/alpha)/std::pow(alpha, 2.0)))/((1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1)*std::pow(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha), 2.0));
  
@@ -108,14 +181,44 @@ namespace diff
  
             const NumType dyj2 = (2*std::pow(alpha, 2.0)*log(1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1)*std::pow(exp(-(hi + yi - yj)/alpha)/alpha - exp(-(hj - yi + yj)/alpha)/alpha, 2.0))/((1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1)*std::pow(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha), 3.0)) - (std::pow(alpha, 2.0)*log(1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1)*std::pow(exp(-(hi + yi - yj)/alpha)/alpha - exp(-(hj - yi + yj)/alpha)/alpha, 2.0))/(std::pow(1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1, 2.0)*std::pow(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha), 4.0)) - (std::pow(alpha, 2.0)*log(1/(exp(-(wi + xi - xj)/alpha) + exp(-(wj - xi + xj)/alpha)) + 1)*(exp(-(hi + yi - yj)/alpha)/std::pow(alpha, 2.0) + exp(-(hj - yi + yj)/alpha)/std::pow(alpha, 2.0)))/((1/(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha)) + 1)*std::pow(exp(-(hi + yi - yj)/alpha) + exp(-(hj - yi + yj)/alpha), 2.0));
 
-            accumulateHessianFunc(lambda * dxi2, op._cellIdxI, op._cellIdxI, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
-            accumulateHessianFunc(lambda * dyi2, op._cellIdxI, op._cellIdxI, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
-            accumulateHessianFunc(lambda * dxj2, op._cellIdxJ, op._cellIdxJ, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
-            accumulateHessianFunc(lambda * dyj2, op._cellIdxJ, op._cellIdxJ, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
+            accumulateHessianFunc(lambda * dxi2, cellIdxI, cellIdxI, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
+            accumulateHessianFunc(lambda * dyi2, cellIdxI, cellIdxI, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
+            accumulateHessianFunc(lambda * dxj2, cellIdxJ, cellIdxJ, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
+            accumulateHessianFunc(lambda * dyj2, cellIdxJ, cellIdxJ, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
  
         }
     };
 
+    template<typename NumType, typename CoordType>
+    struct jacobi_hessian_approx_trait<CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType>>
+    {
+        typedef CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType> operator_type;
+        typedef jacobi_hessian_approx_trait<CellPairOverlapPenaltyDifferentiable<NumType, CoordType>> pair_trait;
+        static void accumulateHessian(const operator_type & op, const std::function<void(NumType, IndexType, IndexType, Orient2DType, Orient2DType)> &accumulateHessianFunc)
+        {
+            const NumType alpha = op._getAlphaFunc();
+            const NumType lambda = op._getLambdaFunc();
+            const auto &nbl = *op._neighborList;
+            for (IndexType pairIdx = op._sliceIdx; pairIdx < nbl.pairs().size(); pairIdx += op._numSlices)
+            {
+                const IndexType i = nbl.pairs()[pairIdx].first;
+                const IndexType j = nbl.pairs()[pairIdx].second;
+                const IndexType cellIdxI = nbl.cellIdx(i);
+                const IndexType cellIdxJ = nbl.cellIdx(j);
+                pair_trait::accumulatePairHessian(alpha, lambda,
+                        cellIdxI,
+                        op::conv<NumType>(op._getVarFunc(cellIdxI, Orient2DType::HORIZONTAL)),
+                        op::conv<NumType>(op._getVarFunc(cellIdxI, Orient2DType::VERTICAL)),
+                        op::conv<NumType>(nbl.width(i)), op::conv<NumType>(nbl.height(i)),
+                        cellIdxJ,
+                        op::conv<NumType>(op._getVarFunc(cellIdxJ, Orient2DType::HORIZONTAL)),
+                        op::conv<NumType>(op._getVarFunc(cellIdxJ, Orient2DType::VERTICAL)),
+                        op::conv<NumType>(nbl.width(j)), op::conv<NumType>(nbl.height(j)),
+                        accumulateHessianFunc);
+            }
+        }
+    };
+
 
     template<typename NumType, typename CoordType>
     struct jacobi_hessian_approx_trait<CellOutOfBoundaryPenaltyDifferentiable<NumType, CoordType>>
@@ -151,37 +254,14 @@ namespace diff
         static void accumulateHessian(const operator_type & op, const std::function<void(NumType, IndexType, IndexType, Orient2DType, Orient2DType)> &accumulateHessianFunc)
         {
             const NumType lambda = op._getLambdaFunc();
-            const NumType x1 = op::conv<NumType>(op._getVarFunc(op._sCellIdx, Orient2DType::HORIZONTAL));
-            const NumType y1 = op::conv<NumType>(op._getVarFunc(op._sCellIdx, Orient2DType::VERTICAL));
-            const NumType x2 = op::conv<NumType>(op._getVarFunc(op._midCellIdx, Orient2DType::HORIZONTAL));
-            const NumType y2 = op::conv<NumType>(op._getVarFunc(op._midCellIdx, Orient2DType::VERTICAL));
-            const NumType x3 = op::conv<NumType>(op._getVarFunc(op._tCellIdx, Orient2DType::HORIZONTAL));
-            const NumType y3 = op::conv<NumType>(op._getVarFunc(op._tCellIdx, Orient2DType::VERTICAL));
-            const NumType ox1 = op._sOffset.x();
-            const NumType oy1 = op._sOffset.y();
-            const NumType ox2a = op._midOffsetA.x();
-            const NumType oy2a = op._midOffsetA.y();
-            const NumType ox2b = op._midOffsetB.x();
-            const NumType oy2b = op._midOffsetB.y();
-            const NumType ox3 = op._tOffset.x();
-            const NumType oy3 = op._tOffset.y();
-
-            const NumType dx1_2 = (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*ox1 - 2*ox2a + 2*x1 - 2*x2, 2.0))/(4*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 2.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*ox1 - 2*ox2a + 2*x1 - 2*x2)*(ox3 - ox2b - x2 + x3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0)));
- 
- 
-            const NumType dy1_2 = (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*oy1 - 2*oy2a + 2*y1 - 2*y2, 2.0))/(4*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 2.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*oy1 - 2*oy2a + 2*y1 - 2*y2)*(oy3 - oy2b - y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0)));
- 
- 
-            const NumType dx2_2 = 2/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*ox1 - 2*ox2a + 2*x1 - 2*x2)*(ox1 + ox3 - ox2a - ox2b + x1 - 2*x2 + x3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*ox3 - 2*ox2b - 2*x2 + 2*x3)*(ox1 + ox3 - ox2a - ox2b + x1 - 2*x2 + x3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) + (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*ox1 - 2*ox2a + 2*x1 - 2*x2, 2.0))/(4*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 2.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) + (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*ox3 - 2*ox2b - 2*x2 + 2*x3, 2.0))/(4*std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 2.5)) + (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*ox1 - 2*ox2a + 2*x1 - 2*x2)*(2*ox3 - 2*ox2b - 2*x2 + 2*x3))/(2*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
- 
- 
-            const NumType dy2_2 = 2/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*oy1 - 2*oy2a + 2*y1 - 2*y2)*(oy1 + oy3 - oy2a - oy2b + y1 - 2*y2 + y3))/(std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) - ((2*oy3 - 2*oy2b - 2*y2 + 2*y3)*(oy1 + oy3 - oy2a - oy2b + y1 - 2*y2 + y3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) + (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*oy1 - 2*oy2a + 2*y1 - 2*y2, 2.0))/(4*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 2.5)*std::sqrt(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0))) + (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*oy3 - 2*oy2b - 2*y2 + 2*y3, 2.0))/(4*std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 2.5)) + (((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*(2*oy1 - 2*oy2a + 2*y1 - 2*y2)*(2*oy3 - 2*oy2b - 2*y2 + 2*y3))/(2*std::pow(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0), 1.5)*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
- 
- 
-            const NumType dx3_2 = (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*ox3 - 2*ox2b - 2*x2 + 2*x3, 2.0))/(4*std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 2.5)) - ((2*ox3 - 2*ox2b - 2*x2 + 2*x3)*(ox1 - ox2a + x1 - x2))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
- 
- 
-            const NumType dy3_2 = (3*((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))*std::pow(2*oy3 - 2*oy2b - 2*y2 + 2*y3, 2.0))/(4*std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 2.5)) - ((2*oy3 - 2*oy2b - 2*y2 + 2*y3)*(oy1 - oy2a + y1 - y2))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5)) - ((ox1 - ox2a + x1 - x2)*(ox3 - ox2b - x2 + x3) + (oy1 - oy2a + y1 - y2)*(oy3 - oy2b - y2 + y3))/(std::sqrt(std::pow(ox1 - ox2a + x1 - x2, 2.0) + std::pow(oy1 - oy2a + y1 - y2, 2.0))*std::pow(std::pow(ox3 - ox2b - x2 + x3, 2.0) + std::pow(oy3 - oy2b - y2 + y3, 2.0), 1.5));
+            typedef ad::Dual<NumType, 6, 2> dual_type;
+            const dual_type cost = op.cosineCost(ad::variables<dual_type>(op.variables()));
+            const NumType dx1_2 = cost.secondPartial(0);
+            const NumType dy1_2 = cost.secondPartial(1);
+            const NumType dx2_2 = cost.secondPartial(2);
+            const NumType dy2_2 = cost.secondPartial(3);
+            const NumType dx3_2 = cost.secondPartial(4);
+            const NumType dy3_2 = cost.secondPartial(5);
 
             accumulateHessianFunc(dx1_2 * lambda, op._sCellIdx, op._sCellIdx, Orient2DType::HORIZONTAL, Orient2DType::HORIZONTAL);
             accumulateHessianFunc(dy1_2 * lambda, op._sCellIdx, op._sCellIdx, Orient2DType::VERTICAL, Orient2DType::VERTICAL);
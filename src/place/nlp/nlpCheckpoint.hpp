@@ -0,0 +1,236 @@
+/**
+ * @file nlpCheckpoint.hpp
+ * @brief Binary checkpoints of the global placement state between the outer iterations
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <Eigen/Dense>
+#include "global/global.h"
+#include "nlpOuterOptm.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    /// @brief checkpoints of the outer problem.
+    /// @details A checkpoint is a header followed by one block per state. Each block is prefixed by its size in bytes,
+    /// so that a checkpoint from another setting or another design is rejected instead of being misread.
+    /// The states are read in place: the operators keep pointers into the multipliers and alpha
+    namespace checkpoint
+    {
+        constexpr char magic[4] = { 'I', 'P', 'C', 'K' };
+        constexpr IndexType version = 1;
+
+        /// @brief writes into a temporary file next to the target, and replaces the target only once the whole checkpoint is written.
+        /// An interrupted write leaves the last complete checkpoint in place
+        class Writer
+        {
+            public:
+                explicit Writer(const std::string &filename)
+                    : _filename(filename), _tmpFilename(filename + ".tmp"), _os(_tmpFilename, std::ios::binary) {}
+                bool good() const { return _os.good(); }
+                /// @brief flush the temporary file and rename it over the target
+                /// @return whether the target is replaced. The temporary file is removed otherwise
+                bool commit()
+                {
+                    _os.flush();
+                    const bool written = _os.good();
+                    _os.close();
+                    if (not written or std::rename(_tmpFilename.c_str(), _filename.c_str()) != 0)
+                    {
+                        std::remove(_tmpFilename.c_str());
+                        return false;
+                    }
+                    return true;
+                }
+                template<typename T>
+                void pod(const T &val)
+                {
+                    static_assert(std::is_trivially_copyable<T>::value, "nlp::checkpoint: needs a checkpoint_trait for a non-trivially-copyable state");
+                    array(&val, 1);
+                }
+                template<typename T>
+                void array(const T *data, IndexType size)
+                {
+                    const IndexType numBytes = size * sizeof(T);
+                    _os.write(reinterpret_cast<const char *>(&numBytes), sizeof(IndexType));
+                    _os.write(reinterpret_cast<const char *>(data), numBytes);
+                }
+            private:
+                std::string _filename; ///< The target
+                std::string _tmpFilename; ///< Written first, and renamed to the target when complete
+                std::ofstream _os;
+        };
+
+        /// @brief reads the checkpoint from memory. In a dry run, only the block sizes are checked and nothing is written
+        class Reader
+        {
+            public:
+                explicit Reader(const std::string &filename)
+                {
+                    std::ifstream is(filename, std::ios::binary);
+                    _buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+                }
+                void setDryRun(bool dryRun) { _dryRun = dryRun; }
+                void rewind() { _pos = 0; }
+                /// @brief whether all the bytes have been read
+                bool atEnd() const { return _pos == _buffer.size(); }
+                template<typename T>
+                bool pod(T &val)
+                {
+                    static_assert(std::is_trivially_copyable<T>::value, "nlp::checkpoint: needs a checkpoint_trait for a non-trivially-copyable state");
+                    return array(&val, 1);
+                }
+                template<typename T>
+                bool array(T *data, IndexType size)
+                {
+                    IndexType numBytes = 0;
+                    if (_pos + sizeof(IndexType) > _buffer.size())
+                    {
+                        return false;
+                    }
+                    std::copy(_buffer.begin() + _pos, _buffer.begin() + _pos + sizeof(IndexType), reinterpret_cast<char *>(&numBytes));
+                    _pos += sizeof(IndexType);
+                    if (numBytes != size * sizeof(T) or _pos + numBytes > _buffer.size())
+                    {
+                        return false;
+                    }
+                    if (not _dryRun)
+                    {
+                        std::copy(_buffer.begin() + _pos, _buffer.begin() + _pos + numBytes, reinterpret_cast<char *>(data));
+                    }
+                    _pos += numBytes;
+                    return true;
+                }
+            private:
+                std::vector<char> _buffer;
+                IndexType _pos = 0;
+                bool _dryRun = false;
+        };
+
+        /// @brief how a state is saved and loaded. The trivially copyable ones, e.g. the update lists and the stop conditions, are copied as they are
+        template<typename T>
+        struct checkpoint_trait
+        {
+            static void save(Writer &w, const T &val) { w.pod(val); }
+            static bool load(Reader &r, T &val) { return r.pod(val); }
+        };
+
+        template<typename T>
+        struct checkpoint_trait<std::vector<T>>
+        {
+            static void save(Writer &w, const std::vector<T> &vec) { w.array(vec.data(), vec.size()); }
+            static bool load(Reader &r, std::vector<T> &vec) { return r.array(vec.data(), vec.size()); }
+        };
+
+        template<typename T>
+        struct checkpoint_trait<Eigen::Matrix<T, Eigen::Dynamic, 1>>
+        {
+            typedef Eigen::Matrix<T, Eigen::Dynamic, 1> vector_type;
+            static void save(Writer &w, const vector_type &vec) { w.array(vec.data(), vec.size()); }
+            static bool load(Reader &r, vector_type &vec) { return r.array(vec.data(), vec.size()); }
+        };
+
+        template<typename nlp_numerical_type, typename init_type, typename update_type>
+        struct checkpoint_trait<outer_multiplier::mult_const_hpwl_cos_and_penalty_by_type<nlp_numerical_type, init_type, update_type>>
+        {
+            typedef outer_multiplier::mult_const_hpwl_cos_and_penalty_by_type<nlp_numerical_type, init_type, update_type> mult_type;
+            static void save(Writer &w, const mult_type &mult)
+            {
+                checkpoint_trait<std::vector<nlp_numerical_type>>::save(w, mult._constMults);
+                checkpoint_trait<std::vector<nlp_numerical_type>>::save(w, mult._variedMults);
+                checkpoint_trait<update_type>::save(w, mult.update);
+            }
+            static bool load(Reader &r, mult_type &mult)
+            {
+                return checkpoint_trait<std::vector<nlp_numerical_type>>::load(r, mult._constMults)
+                    and checkpoint_trait<std::vector<nlp_numerical_type>>::load(r, mult._variedMults)
+                    and checkpoint_trait<update_type>::load(r, mult.update);
+            }
+        };
+
+        template<typename nlp_numerical_type>
+        struct checkpoint_trait<outer_multiplier::update::subgradient_normalized_by_init<nlp_numerical_type>>
+        {
+            typedef outer_multiplier::update::subgradient_normalized_by_init<nlp_numerical_type> update_type;
+            static void save(Writer &w, const update_type &update) { checkpoint_trait<std::vector<nlp_numerical_type>>::save(w, update.normalizeFactor); }
+            static bool load(Reader &r, update_type &update) { return checkpoint_trait<std::vector<nlp_numerical_type>>::load(r, update.normalizeFactor); }
+        };
+
+        template<typename nlp_numerical_type>
+        struct checkpoint_trait<alpha::alpha_hpwl_ovl_oob<nlp_numerical_type>>
+        {
+            typedef alpha::alpha_hpwl_ovl_oob<nlp_numerical_type> alpha_type;
+            static void save(Writer &w, const alpha_type &alpha) { checkpoint_trait<std::vector<nlp_numerical_type>>::save(w, alpha._alpha); }
+            static bool load(Reader &r, alpha_type &alpha) { return checkpoint_trait<std::vector<nlp_numerical_type>>::load(r, alpha._alpha); }
+        };
+
+        inline void saveStates(Writer &) {}
+        template<typename T, typename... others>
+        void saveStates(Writer &w, const T &state, const others &... rest)
+        {
+            checkpoint_trait<T>::save(w, state);
+            saveStates(w, rest...);
+        }
+
+        inline bool loadStates(Reader &) { return true; }
+        template<typename T, typename... others>
+        bool loadStates(Reader &r, T &state, others &... rest)
+        {
+            return checkpoint_trait<T>::load(r, state) and loadStates(r, rest...);
+        }
+
+        /// @brief save the states into a file
+        /// @param the file name
+        /// @param the number of variables of the problem. Checked when loading
+        /// @param the states
+        /// @return whether the file is written successfully. The file is not touched otherwise
+        template<typename... state_types>
+        bool save(const std::string &filename, IndexType numVariables, const state_types &... states)
+        {
+            Writer w(filename);
+            w.pod(magic);
+            w.pod(version);
+            w.pod(numVariables);
+            saveStates(w, states...);
+            return w.commit();
+        }
+
+        /// @brief load the states from a file. The states are untouched unless the whole file matches them
+        /// @return whether the states are loaded
+        template<typename... state_types>
+        bool load(const std::string &filename, IndexType numVariables, state_types &... states)
+        {
+            Reader r(filename);
+            char fileMagic[4];
+            IndexType fileVersion = 0, fileNumVariables = 0;
+            r.setDryRun(true);
+            if (not (r.pod(fileMagic) and loadStates(r, fileVersion, fileNumVariables, states...) and r.atEnd()))
+            {
+                return false;
+            }
+            r.rewind();
+            r.setDryRun(false);
+            r.pod(fileMagic);
+            r.pod(fileVersion);
+            r.pod(fileNumVariables);
+            if (not std::equal(magic, magic + 4, fileMagic) or fileVersion != version or fileNumVariables != numVariables)
+            {
+                return false;
+            }
+            return loadStates(r, states...);
+        }
+    } // namespace checkpoint
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
@@ -9,6 +9,7 @@
 
 #include "global/global.h"
 #include "nlpOptmKernels.hpp"
+#include "nlpStepSize.hpp"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -28,12 +29,14 @@ namespace nlp
                 static constexpr RealType _stepSize = 0.001;
                 converge_criteria_type _converge;
             };
-            /// @brief adam
-            template<typename converge_criteria_type, typename nlp_numerical_type>
+            /// @brief adam. Warm up with plain gradient steps sized by the step size policy
+            template<typename converge_criteria_type, typename nlp_numerical_type, typename step_size_policy_type = step_size::constant<>>
             struct adam
             {
                 typedef converge_criteria_type converge_type;
+                typedef step_size_policy_type step_size_type;
                 converge_criteria_type _converge;
+                step_size_type _stepSize;
                 static constexpr nlp_numerical_type alpha = 0.005;
                 static constexpr nlp_numerical_type beta1 = 0.9;
                 static constexpr nlp_numerical_type beta2 = 0.999;
@@ -42,15 +45,33 @@ namespace nlp
                 static constexpr nlp_numerical_type naiveGradientDescentStepSize = 0.001;
 
             };
-            /// @brief nesterov accelerated gradient
-            template<typename converge_criteria_type, typename nlp_numerical_type>
+            /// @brief nesterov accelerated gradient. The step size and the momentum restart are decided by the step size policy
+            template<typename converge_criteria_type, typename nlp_numerical_type, typename step_size_policy_type = step_size::constant<>>
             struct nesterov
             {
                 typedef converge_criteria_type converge_type;
+                typedef step_size_policy_type step_size_type;
                 converge_criteria_type _converge;
+                step_size_type _stepSize;
                 static constexpr nlp_numerical_type eta = 0.003;
 
             };
+            /// @brief limited-memory BFGS with a strong Wolfe line search.
+            /// @details Not a placer setting: as the kernel of the global placement, the HPWL is from 13% better to 22% worse than adam on the synthetic designs.
+            /// A fixed iteration budget instead of the gradient norm criterion does not close the gap, the line search stalls in the nearest local minimum
+            /// @tparam the number of the correction pairs kept
+            template<typename converge_criteria_type, typename nlp_numerical_type, IndexType memory_size = 10>
+            struct lbfgs
+            {
+                typedef converge_criteria_type converge_type;
+                converge_criteria_type _converge;
+                static constexpr IndexType memorySize = memory_size;
+                static constexpr nlp_numerical_type c1 = 1e-4; ///< sufficient decrease
+                static constexpr nlp_numerical_type c2 = 0.9; ///< curvature
+                static constexpr IndexType maxLineSearchIter = 20;
+                static constexpr nlp_numerical_type initStepSize = 0.1; ///< The largest move of a variable in the first iteration, when there is no curvature information yet
+                static constexpr nlp_numerical_type curvatureEpsilon = 1e-10; ///< skip the correction pair if s^T y is not larger than this ratio of ||s|| ||y||
+            };
         } // namspace first_order
         template<typename converge_criteria_type>
         struct optm_trait<first_order::naive_gradient_descent<converge_criteria_type>>
@@ -76,16 +97,18 @@ namespace nlp
 #endif
             }
         };
-        template<typename converge_criteria_type, typename nlp_numerical_type>
-        struct optm_trait<first_order::adam<converge_criteria_type, nlp_numerical_type>>
+        template<typename converge_criteria_type, typename nlp_numerical_type, typename step_size_policy_type>
+        struct optm_trait<first_order::adam<converge_criteria_type, nlp_numerical_type, step_size_policy_type>>
         {
-            typedef first_order::adam<converge_criteria_type, nlp_numerical_type> optm_type;
+            typedef first_order::adam<converge_criteria_type, nlp_numerical_type, step_size_policy_type> optm_type;
             typedef typename optm_type::converge_type converge_type;
             typedef nlp::converge::converge_criteria_trait<converge_type> converge_trait;
+            typedef step_size::step_size_trait<typename optm_type::step_size_type> step_size_trait;
             template<typename nlp_type, std::enable_if_t<nlp::is_first_order_diff<nlp_type>::value, void>* = nullptr>
             static void optimize(nlp_type &n, optm_type &o)
             {
                 converge_trait::clear(o._converge);
+                step_size_trait::clear(o._stepSize);
                 const IndexType numVars = n._numVariables;
                 typename nlp_type::EigenVector m, v;
                 m.resize(numVars); m.setZero();
@@ -94,7 +117,14 @@ namespace nlp
                 do 
                 {
                     ++iter;
-                    n.calcGrad();
+                    if (step_size_trait::needObj)
+                    {
+                        n.calcObjAndGrad();
+                    }
+                    else
+                    {
+                        n.calcGrad();
+                    }
 
                     n._optimizerKernelStopWatch->start();
 
@@ -103,13 +133,14 @@ namespace nlp
                     auto mt = m / (1 - pow(o.beta1, iter));
                     auto vt = v / (1 - pow(o.beta2, iter));
                     auto bot = vt.array().sqrt() + o.epsilon;
-                    if (iter > 1000)
+                    if (!step_size_trait::inWarmUp(n, o._stepSize, iter))
                     {
                         n._pl = n._pl - o.alpha * ( mt.array() / bot).matrix();
                     }
                     else
                     {
-                        n._pl -= optm_type::naiveGradientDescentStepSize * n._grad;
+                        const nlp_numerical_type stepSize = step_size_trait::stepSize(n, o._stepSize, optm_type::naiveGradientDescentStepSize);
+                        n._pl -= stepSize * n._grad;
                     }
 
                     n._optimizerKernelStopWatch->stop();
@@ -126,16 +157,18 @@ namespace nlp
             }
         };
 
-        template<typename converge_criteria_type, typename nlp_numerical_type>
-        struct optm_trait<first_order::nesterov<converge_criteria_type, nlp_numerical_type>>
+        template<typename converge_criteria_type, typename nlp_numerical_type, typename step_size_policy_type>
+        struct optm_trait<first_order::nesterov<converge_criteria_type, nlp_numerical_type, step_size_policy_type>>
         {
-            typedef first_order::nesterov<converge_criteria_type, nlp_numerical_type> optm_type;
+            typedef first_order::nesterov<converge_criteria_type, nlp_numerical_type, step_size_policy_type> optm_type;
             typedef typename optm_type::converge_type converge_type;
             typedef nlp::converge::converge_criteria_trait<converge_type> converge_trait;
+            typedef step_size::step_size_trait<typename optm_type::step_size_type> step_size_trait;
             template<typename nlp_type, std::enable_if_t<nlp::is_first_order_diff<nlp_type>::value, void>* = nullptr>
             static void optimize(nlp_type &n, optm_type &o)
             {
                 converge_trait::clear(o._converge);
+                step_size_trait::clear(o._stepSize);
                 const IndexType numVars = n._numVariables;
                 IndexType iter = 0;
                 nlp_numerical_type lambdaPrev = 0;
@@ -147,8 +180,24 @@ namespace nlp
                 do 
                 {
                     ++iter;
-                    n.calcGrad();
-                    yCurr = n._pl - o.eta * n._grad;
+                    if (step_size_trait::needObj)
+                    {
+                        n.calcObjAndGrad();
+                    }
+                    else
+                    {
+                        n.calcGrad();
+                    }
+                    const nlp_numerical_type eta = step_size_trait::stepSize(n, o._stepSize, optm_type::eta);
+                    yCurr = n._pl - eta * n._grad;
+                    if (step_size_trait::restart(n, o._stepSize, yCurr, yPrev))
+                    {
+                        // Drop the momentum
+                        lambdaPrev = 0;
+                        lambdaCurr = 1;
+                        gamma = 1;
+                        yPrev = yCurr;
+                    }
                     n._pl = (1 - gamma) * yCurr + gamma * yPrev;
 
                     yPrev = yCurr;
@@ -170,6 +219,201 @@ namespace nlp
             }
         };
 
+        template<typename converge_criteria_type, typename nlp_numerical_type, IndexType memory_size>
+        struct optm_trait<first_order::lbfgs<converge_criteria_type, nlp_numerical_type, memory_size>>
+        {
+            typedef first_order::lbfgs<converge_criteria_type, nlp_numerical_type, memory_size> optm_type;
+            typedef typename optm_type::converge_type converge_type;
+            typedef nlp::converge::converge_criteria_trait<converge_type> converge_trait;
+            template<typename nlp_type, std::enable_if_t<nlp::is_first_order_diff<nlp_type>::value, void>* = nullptr>
+            static void optimize(nlp_type &n, optm_type &o)
+            {
+                typedef typename nlp_type::EigenVector EigenVector;
+                typedef typename EigenVector::Scalar scalar_type;
+                converge_trait::clear(o._converge);
+                const IndexType numVars = n._numVariables;
+                // The correction pairs in a ring buffer. The problem changes between the outer iterations, so always start from empty
+                std::vector<EigenVector> sHist(optm_type::memorySize, EigenVector(numVars));
+                std::vector<EigenVector> yHist(optm_type::memorySize, EigenVector(numVars));
+                std::vector<scalar_type> rhoHist(optm_type::memorySize, 0);
+                std::vector<scalar_type> alphaHist(optm_type::memorySize, 0);
+                IndexType histBegin = 0, histSize = 0;
+                EigenVector dir(numVars), plPrev(numVars), gradPrev(numVars);
+                IndexType iter = 0;
+                IndexType numEvals = 1;
+                n.calcObjAndGrad();
+                do 
+                {
+                    ++iter;
+                    n._optimizerKernelStopWatch->start();
+                    // Two-loop recursion for dir = - H * grad
+                    dir = - n._grad;
+                    for (IndexType k = histSize; k > 0; --k)
+                    {
+                        const IndexType idx = (histBegin + k - 1) % optm_type::memorySize;
+                        alphaHist[idx] = rhoHist[idx] * sHist[idx].dot(dir);
+                        dir -= alphaHist[idx] * yHist[idx];
+                    }
+                    if (histSize > 0)
+                    {
+                        const IndexType last = (histBegin + histSize - 1) % optm_type::memorySize;
+                        dir *= sHist[last].dot(yHist[last]) / yHist[last].squaredNorm();
+                    }
+                    for (IndexType k = 0; k < histSize; ++k)
+                    {
+                        const IndexType idx = (histBegin + k) % optm_type::memorySize;
+                        const scalar_type beta = rhoHist[idx] * yHist[idx].dot(dir);
+                        dir += (alphaHist[idx] - beta) * sHist[idx];
+                    }
+                    if (dir.dot(n._grad) >= 0)
+                    {
+                        // Not a descent direction. Drop the history
+                        histSize = 0;
+                        dir = - n._grad;
+                    }
+                    scalar_type step = 1;
+                    if (histSize == 0)
+                    {
+                        step = optm_type::initStepSize / std::max(dir.template lpNorm<Eigen::Infinity>(), static_cast<scalar_type>(1e-12));
+                    }
+                    plPrev = n._pl;
+                    gradPrev = n._grad;
+                    const auto objPrev = n._obj;
+                    n._optimizerKernelStopWatch->stop();
+
+                    if (not lineSearch(n, o, dir, step, numEvals))
+                    {
+                        // Restore the last point if the line search can not even decrease the objective
+                        if (n._obj > objPrev)
+                        {
+                            n._pl = plPrev;
+                            n.calcObjAndGrad();
+                            ++numEvals;
+                        }
+                        if (histSize == 0)
+                        {
+                            break;
+                        }
+                        histSize = 0;
+                        continue;
+                    }
+
+                    n._optimizerKernelStopWatch->start();
+                    // Record the correction pair if the curvature is positive
+                    const IndexType idx = (histBegin + histSize) % optm_type::memorySize;
+                    sHist[idx] = n._pl - plPrev;
+                    yHist[idx] = n._grad - gradPrev;
+                    const scalar_type sy = sHist[idx].dot(yHist[idx]);
+                    if (sy > optm_type::curvatureEpsilon * sHist[idx].norm() * yHist[idx].norm())
+                    {
+                        rhoHist[idx] = 1 / sy;
+                        if (histSize < optm_type::memorySize)
+                        {
+                            ++histSize;
+                        }
+                        else
+                        {
+                            histBegin = (histBegin + 1) % optm_type::memorySize;
+                        }
+                    }
+                    n._optimizerKernelStopWatch->stop();
+                } while (!converge_trait::stopCriteria(n, o, o._converge) );
+#ifdef DEBUG_GR
+                DBG("lbfgs: %f hpwl %f cos %f ovl %f oob %f asym %f \n", n._obj, n._objHpwl, n._objCos, n._objOvl, n._objOob, n._objAsym);
+                DBG("gradient norm %f \n", n._grad.norm());
+                DBG("converge at iter %d with %d evaluations \n", iter, numEvals);
+#endif
+            }
+        private:
+            /// @brief move _pl along dir to a point satisfying the strong Wolfe conditions. The objective and gradient are kept up to date
+            /// @param the initial trial step
+            /// @return false if no such a point is found within maxLineSearchIter evaluations
+            template<typename nlp_type, typename vector_type>
+            static bool lineSearch(nlp_type &n, optm_type &, const vector_type &dir, typename vector_type::Scalar step, IndexType &numEvals)
+            {
+                typedef typename vector_type::Scalar scalar_type;
+                const vector_type pl0 = n._pl;
+                const scalar_type phi0 = n._obj;
+                const scalar_type dphi0 = n._grad.dot(dir);
+                scalar_type stepLo = 0, phiLo = phi0, dphiLo = dphi0;
+                scalar_type stepHi = 0, phiHi = 0, dphiHi = 0;
+                bool bracketed = false;
+                for (IndexType lsIter = 0; lsIter < optm_type::maxLineSearchIter; ++lsIter)
+                {
+                    if (bracketed)
+                    {
+                        step = interpolate(stepLo, phiLo, dphiLo, stepHi, phiHi, dphiHi);
+                    }
+                    n._pl = pl0 + step * dir;
+                    n.calcObjAndGrad();
+                    ++numEvals;
+                    const scalar_type phi = n._obj;
+                    const scalar_type dphi = n._grad.dot(dir);
+                    if (phi > phi0 + optm_type::c1 * step * dphi0 or (phi >= phiLo and step != stepLo))
+                    {
+                        // Too far. The minimizer is between lo and this step
+                        stepHi = step; phiHi = phi; dphiHi = dphi;
+                        bracketed = true;
+                        continue;
+                    }
+                    if (std::abs(dphi) <= - optm_type::c2 * dphi0)
+                    {
+                        return true;
+                    }
+                    if (bracketed)
+                    {
+                        if (dphi * (stepHi - stepLo) >= 0)
+                        {
+                            stepHi = stepLo; phiHi = phiLo; dphiHi = dphiLo;
+                        }
+                        stepLo = step; phiLo = phi; dphiLo = dphi;
+                    }
+                    else if (dphi >= 0)
+                    {
+                        // Passed the minimizer
+                        stepHi = stepLo; phiHi = phiLo; dphiHi = dphiLo;
+                        stepLo = step; phiLo = phi; dphiLo = dphi;
+                        bracketed = true;
+                    }
+                    else
+                    {
+                        stepLo = step; phiLo = phi; dphiLo = dphi;
+                        step *= 2;
+                    }
+                }
+                // Keep the best point found if it decreases the objective sufficiently
+                if (stepLo > 0)
+                {
+                    n._pl = pl0 + stepLo * dir;
+                    n.calcObjAndGrad();
+                    ++numEvals;
+                    return true;
+                }
+                return false;
+            }
+            /// @brief the minimizer of the cubic interpolation between two steps, safeguarded into the middle of the interval
+            template<typename scalar_type>
+            static scalar_type interpolate(scalar_type stepLo, scalar_type phiLo, scalar_type dphiLo, scalar_type stepHi, scalar_type phiHi, scalar_type dphiHi)
+            {
+                const scalar_type d1 = dphiLo + dphiHi - 3 * (phiLo - phiHi) / (stepLo - stepHi);
+                const scalar_type discriminant = d1 * d1 - dphiLo * dphiHi;
+                scalar_type step = (stepLo + stepHi) / 2;
+                if (discriminant >= 0)
+                {
+                    const scalar_type d2 = std::copysign(std::sqrt(discriminant), stepHi - stepLo);
+                    step = stepHi - (stepHi - stepLo) * (dphiHi + d2 - d1) / (dphiHi - dphiLo + 2 * d2);
+                }
+                const scalar_type lo = std::min(stepLo, stepHi);
+                const scalar_type hi = std::max(stepLo, stepHi);
+                const scalar_type margin = 0.1 * (hi - lo);
+                if (not std::isfinite(step) or step < lo + margin or step > hi - margin)
+                {
+                    step = (stepLo + stepHi) / 2;
+                }
+                return step;
+            }
+        };
+
     } // namespace optm
 } // namespace nlp
 
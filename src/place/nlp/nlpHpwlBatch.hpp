@@ -0,0 +1,279 @@
+/**
+ * @file nlpHpwlBatch.hpp
+ * @brief Batched LSE-smoothed HPWL over all the nets in a structure-of-arrays layout
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include "global/global.h"
+#include "place/different.h"
+#include "nlpSimdExp.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    /// @brief evaluate all the LseHpwlDifferentiable operators at once.
+    /// @details The pins of all the nets are stored in CSR: _netStart[net] .. _netStart[net + 1] index the pin arrays.
+    /// The exponentials of all the pins are computed in one vectorized pass, and then summed per net.
+    /// The operators still own the weights, alpha, lambda and virtual pins, so that the outer-problem traits work on them unchanged
+    template<typename hpwl_op_type>
+    class LseHpwlBatch
+    {
+        public:
+            typedef typename hpwl_op_type::numerical_type numerical_type;
+            typedef typename hpwl_op_type::coordinate_type coordinate_type;
+            static constexpr IndexType blockSize = 1024; ///< The number of pins processed together in the vectorized pass
+
+            /// @brief build the CSR from the operators. The operators need to be kept valid
+            void build(const std::vector<hpwl_op_type> &ops)
+            {
+                _ops = &ops;
+                _netStart.clear();
+                _pinCells.clear();
+                _pinOffsetX.clear();
+                _pinOffsetY.clear();
+                _netStart.reserve(ops.size() + 1);
+                _netStart.emplace_back(0);
+                for (const auto &op : ops)
+                {
+                    for (IndexType idx = 0; idx < op._cells.size(); ++idx)
+                    {
+                        _pinCells.emplace_back(op._cells[idx]);
+                        _pinOffsetX.emplace_back(op._offsetX[idx]);
+                        _pinOffsetY.emplace_back(op._offsetY[idx]);
+                    }
+                    _netStart.emplace_back(_pinCells.size());
+                }
+                const IndexType numPins = _pinCells.size();
+                // The pins of each cell in CSR, for gathering the partials per cell
+                IndexType numPinCells = 0;
+                for (IndexType cellIdx : _pinCells)
+                {
+                    numPinCells = std::max(numPinCells, cellIdx + 1);
+                }
+                _cellPinStart.assign(numPinCells + 1, 0);
+                for (IndexType cellIdx : _pinCells)
+                {
+                    ++_cellPinStart[cellIdx + 1];
+                }
+                for (IndexType cellIdx = 0; cellIdx < numPinCells; ++cellIdx)
+                {
+                    _cellPinStart[cellIdx + 1] += _cellPinStart[cellIdx];
+                }
+                _cellPins.resize(numPins);
+                std::vector<IndexType> fill(_cellPinStart.begin(), _cellPinStart.end() - 1);
+                for (IndexType pin = 0; pin < numPins; ++pin)
+                {
+                    _cellPins[fill[_pinCells[pin]]++] = pin;
+                }
+                _pinX.resize(numPins); _pinY.resize(numPins);
+                _expXPos.resize(numPins); _expXNeg.resize(numPins);
+                _expYPos.resize(numPins); _expYNeg.resize(numPins);
+                _pinGradX.resize(numPins); _pinGradY.resize(numPins);
+                _netObj.resize(ops.size());
+            }
+            /// @brief evaluate the total objective
+            numerical_type evaluate()
+            {
+                return run<true, false>(static_cast<numerical_type *>(nullptr), 0);
+            }
+            /// @brief add the gradient into a vector in the layout of the placement variables: x of cell i at [i], y at [i + numCells]
+            template<typename grad_type>
+            void accumulateGradient(grad_type *grad, IndexType numCells)
+            {
+                run<false, true>(grad, numCells);
+            }
+            /// @brief evaluate the total objective and add the gradient into a vector with one pass of the exponentials
+            /// @return the total objective
+            template<typename grad_type>
+            numerical_type evaluateAndAccumulateGradient(grad_type *grad, IndexType numCells)
+            {
+                return run<true, true>(grad, numCells);
+            }
+            IndexType numNets() const { return _netStart.size() - 1; }
+            IndexType numPins() const { return _pinCells.size(); }
+            bool empty() const { return _ops == nullptr or _ops->empty(); }
+
+            /* The phases for running inside an enclosing parallel region. Each of them is a worksharing loop without the implied barrier.
+             * The caller needs to call prepare() beforehand, put barriers between the phases, and call sumObj() afterwards.
+             * Outside of a parallel region they simply run serially */
+            /// @brief read alpha and lambda. Not thread-safe
+            void prepare()
+            {
+                if (empty())
+                {
+                    return;
+                }
+                _alpha = _ops->front()._getAlphaFunc();
+                _lambda = _ops->front()._getLambdaFunc();
+            }
+            /// @brief phase 1: compute the exponentials of all the pins
+            void computeExpShared()
+            {
+                if (empty())
+                {
+                    return;
+                }
+                const auto &getVar = _ops->front()._getVarFunc;
+                const numerical_type invAlpha = 1.0 / _alpha;
+                const IndexType numBlocks = (numPins() + blockSize - 1) / blockSize;
+                #pragma omp for schedule(static) nowait
+                for (IndexType block = 0; block < numBlocks; ++block)
+                {
+                    const IndexType begin = block * blockSize;
+                    const IndexType size = std::min(blockSize, numPins() - begin);
+                    for (IndexType pin = begin; pin < begin + size; ++pin)
+                    {
+                        _pinX[pin] = diff::op::conv<numerical_type>(getVar(_pinCells[pin], Orient2DType::HORIZONTAL) + _pinOffsetX[pin]);
+                        _pinY[pin] = diff::op::conv<numerical_type>(getVar(_pinCells[pin], Orient2DType::VERTICAL) + _pinOffsetY[pin]);
+                    }
+                    simd::expScaled(&_pinX[begin], &_expXPos[begin], size, invAlpha);
+                    simd::expScaled(&_pinX[begin], &_expXNeg[begin], size, -invAlpha);
+                    simd::expScaled(&_pinY[begin], &_expYPos[begin], size, invAlpha);
+                    simd::expScaled(&_pinY[begin], &_expYNeg[begin], size, -invAlpha);
+                }
+            }
+            /// @brief phase 2: the objectives and the pin partials of the nets
+            template<bool needObj, bool needGrad>
+            void calcNetsShared()
+            {
+                if (empty())
+                {
+                    return;
+                }
+                #pragma omp for schedule(static) nowait
+                for (IndexType netIdx = 0; netIdx < numNets(); ++netIdx)
+                {
+                    const auto &op = (*_ops)[netIdx];
+                    _netObj[netIdx] = 0;
+                    if (! op.validHpwl())
+                    {
+                        if (needGrad)
+                        {
+                            for (IndexType pin = _netStart[netIdx]; pin < _netStart[netIdx + 1]; ++pin)
+                            {
+                                _pinGradX[pin] = 0;
+                                _pinGradY[pin] = 0;
+                            }
+                        }
+                        continue;
+                    }
+                    std::array<numerical_type, 4> sums = netSums(netIdx, op, _alpha);
+                    if (needObj)
+                    {
+                        numerical_type obj = 0;
+                        for (IndexType i = 0; i < 4; ++i)
+                        {
+                            obj += std::log(sums[i]);
+                        }
+                        _netObj[netIdx] = _alpha * obj * op._weight * _lambda;
+                    }
+                    if (! needGrad)
+                    {
+                        continue;
+                    }
+                    // avoid overflow
+                    for (IndexType i = 0; i < 4; ++i)
+                    {
+                        sums[i] = std::max(sums[i], diff::op::conv<numerical_type>(1e-8));
+                    }
+                    const numerical_type scale = _lambda * op._weight;
+                    for (IndexType pin = _netStart[netIdx]; pin < _netStart[netIdx + 1]; ++pin)
+                    {
+                        _pinGradX[pin] = scale * (_expXPos[pin] / sums[0] - _expXNeg[pin] / sums[1]);
+                        _pinGradY[pin] = scale * (_expYPos[pin] / sums[2] - _expYNeg[pin] / sums[3]);
+                    }
+                }
+            }
+            /// @brief phase 3: gather the pin partials per cell. The pins of a cell are added in the same order as a serial scatter
+            template<typename grad_type>
+            void gatherShared(grad_type *grad, IndexType numCells)
+            {
+                const IndexType numPinCells = _cellPinStart.size() - 1;
+                #pragma omp for schedule(static) nowait
+                for (IndexType cellIdx = 0; cellIdx < numPinCells; ++cellIdx)
+                {
+                    grad_type gradX = 0;
+                    grad_type gradY = 0;
+                    for (IndexType idx = _cellPinStart[cellIdx]; idx < _cellPinStart[cellIdx + 1]; ++idx)
+                    {
+                        gradX += _pinGradX[_cellPins[idx]];
+                        gradY += _pinGradY[_cellPins[idx]];
+                    }
+                    grad[cellIdx] += gradX;
+                    grad[cellIdx + numCells] += gradY;
+                }
+            }
+            /// @brief the total objective from phase 2. Summed in order to keep the result deterministic
+            numerical_type sumObj() const
+            {
+                numerical_type obj = 0;
+                for (IndexType netIdx = 0; netIdx < numNets(); ++netIdx)
+                {
+                    obj += _netObj[netIdx];
+                }
+                return obj;
+            }
+        private:
+            template<bool needObj, bool needGrad, typename grad_type>
+            numerical_type run(grad_type *grad, IndexType numCells)
+            {
+                if (empty())
+                {
+                    return 0;
+                }
+                prepare();
+                #pragma omp parallel
+                {
+                    computeExpShared();
+                    #pragma omp barrier
+                    calcNetsShared<needObj, needGrad>();
+                    if (needGrad)
+                    {
+                        #pragma omp barrier
+                        gatherShared(grad, numCells);
+                    }
+                }
+                return needObj ? sumObj() : 0;
+            }
+            /// @brief the four exponential sums of a net: xmax xmin ymax ymin
+            std::array<numerical_type, 4> netSums(IndexType netIdx, const hpwl_op_type &op, numerical_type alpha) const
+            {
+                std::array<numerical_type, 4> sums = { 0, 0, 0, 0 };
+                for (IndexType pin = _netStart[netIdx]; pin < _netStart[netIdx + 1]; ++pin)
+                {
+                    sums[0] += _expXPos[pin];
+                    sums[1] += _expXNeg[pin];
+                    sums[2] += _expYPos[pin];
+                    sums[3] += _expYNeg[pin];
+                }
+                if (op._validVirtualPin == 1)
+                {
+                    sums[0] += std::exp(op._virtualPinX / alpha);
+                    sums[1] += std::exp(- op._virtualPinX / alpha);
+                    sums[2] += std::exp(op._virtualPinY / alpha);
+                    sums[3] += std::exp(- op._virtualPinY / alpha);
+                }
+                return sums;
+            }
+        private:
+            const std::vector<hpwl_op_type> *_ops = nullptr; ///< The operators of the nets
+            std::vector<IndexType> _netStart = { 0 }; ///< The start of the pins of each net. numNets + 1
+            std::vector<IndexType> _pinCells; ///< The cell indices of the pins
+            std::vector<coordinate_type> _pinOffsetX; ///< The x offsets of the pins to their cells
+            std::vector<coordinate_type> _pinOffsetY; ///< The y offsets of the pins to their cells
+            std::vector<IndexType> _cellPinStart = { 0 }; ///< The start of the pins of each cell in _cellPins
+            std::vector<IndexType> _cellPins; ///< The pins grouped by their cells
+            std::vector<numerical_type> _pinX, _pinY; ///< The pin locations
+            std::vector<numerical_type> _expXPos, _expXNeg, _expYPos, _expYNeg; ///< exp(+/- x / alpha), exp(+/- y / alpha)
+            std::vector<numerical_type> _pinGradX, _pinGradY; ///< The partials of the pins
+            std::vector<numerical_type> _netObj; ///< The objective of each net
+            numerical_type _alpha = 1; ///< The alpha read by prepare()
+            numerical_type _lambda = 1; ///< The lambda read by prepare()
+    };
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
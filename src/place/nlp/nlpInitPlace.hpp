@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <map>
 #include <random>
 #include "global/global.h"
 
@@ -82,7 +83,8 @@ namespace nlp {
                 const auto yCenter = (nlp._boundary.yLo() + nlp._boundary.yHi()) / 2;
                 XY<coord_type> initLoc(xCenter, yCenter);
                 const IndexType numCells = nlp._db.numCells();
-                std::default_random_engine gen(0);
+                // The engine takes seed 0 as 1. Shift by one, so that seed 0 gives the same placement as before and the seeds are all distinct
+                std::default_random_engine gen(nlp._db.parameters().nlpInitSeed() + 1);
                 RealType stddev = init_random_placement_with_normal_distribution_near_center::randomInitPlaceStddev * std::min(nlp._boundary.xLen(), nlp._boundary.yLen());
                 std::normal_distribution<coord_type> movDistrX(initLoc.x(), stddev);
                 std::normal_distribution<coord_type> movDistrY(initLoc.y(), stddev);
@@ -100,6 +102,61 @@ namespace nlp {
                 //nlp.alignToSym();
             }
         };
+
+        /// @brief warm start from the cell locations in the database. The placement is moved to the center of the boundary
+        struct init_from_database {};
+
+        template<>
+        struct init_place_trait<init_from_database>
+        {
+            typedef init_from_database T;
+            template<typename NlpType>
+            static T construct(NlpType &) { return T(); }
+            template<typename NlpType>
+            static void initPlace(T &, NlpType &nlp)
+            {
+                using coord_type = typename NlpType::nlp_coordinate_type;
+                const IndexType numCells = nlp._db.numCells();
+                Box<LocType> placeBox(LOC_TYPE_MAX, LOC_TYPE_MAX, LOC_TYPE_MIN, LOC_TYPE_MIN);
+                for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+                {
+                    placeBox.unionBox(nlp._db.cell(cellIdx).cellBBoxOff());
+                }
+                const coord_type xShift = (nlp._boundary.xLo() + nlp._boundary.xHi()) / 2 - placeBox.center().x() * nlp._scale;
+                const coord_type yShift = (nlp._boundary.yLo() + nlp._boundary.yHi()) / 2 - placeBox.center().y() * nlp._scale;
+                for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+                {
+                    const auto cellBox = nlp._db.cell(cellIdx).cellBBoxOff();
+                    nlp._pl(nlp.plIdx(cellIdx, Orient2DType::HORIZONTAL)) = cellBox.xLo() * nlp._scale + xShift;
+                    nlp._pl(nlp.plIdx(cellIdx, Orient2DType::VERTICAL)) = cellBox.yLo() * nlp._scale + yShift;
+                }
+                // The symmetric axes from the centers of the cells in the groups. The groups may share one axis variable
+                std::map<IndexType, std::pair<coord_type, IndexType>> axisSums;
+                for (IndexType symGrpIdx = 0; symGrpIdx < nlp._db.numSymGroups(); ++symGrpIdx)
+                {
+                    auto &axisSum = axisSums[nlp.plIdx(symGrpIdx, Orient2DType::NONE)];
+                    const auto &symGrp = nlp._db.symGroup(symGrpIdx);
+                    for (const auto &symPair : symGrp.vSymPairs())
+                    {
+                        axisSum.first += (nlp._db.cell(symPair.firstCell()).cellBBoxOff().center().x()
+                                + nlp._db.cell(symPair.secondCell()).cellBBoxOff().center().x()) * 0.5 * nlp._scale + xShift;
+                        axisSum.second += 1;
+                    }
+                    for (IndexType selfSymCellIdx : symGrp.vSelfSyms())
+                    {
+                        axisSum.first += nlp._db.cell(selfSymCellIdx).cellBBoxOff().center().x() * nlp._scale + xShift;
+                        axisSum.second += 1;
+                    }
+                }
+                for (const auto &axisSum : axisSums)
+                {
+                    if (axisSum.second.second > 0)
+                    {
+                        nlp._pl(axisSum.first) = axisSum.second.first / axisSum.second.second;
+                    }
+                }
+            }
+        };
     } // namespace init_placement
 } //namespae nlp
 
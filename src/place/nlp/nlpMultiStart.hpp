@@ -0,0 +1,92 @@
+/**
+ * @file nlpMultiStart.hpp
+ * @brief Sharing the progress among the concurrent global placement runs of a multi-start
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "global/global.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    /// @brief the runs report their objective after each outer iteration.
+    /// @details A run is cancelled if its objective is much worse than another live run at the same outer iteration of the same stage.
+    /// The run with the best objective at an iteration is never cancelled, so at least one run finishes.
+    /// A stage is one of the problems a run solves in turn, e.g. a level of the multilevel placement, whose objectives are only comparable among themselves
+    class MultiStartMonitor
+    {
+        public:
+            static constexpr IndexType minOuterIterBeforeCancel = 3; ///< Let the multipliers settle before comparing
+            static constexpr RealType cancelRatio = 2.0; ///< Cancel if the objective is this times of another live run
+
+            explicit MultiStartMonitor(IndexType numRuns) : _objs(numRuns), _cancelled(numRuns, false) {}
+            /// @brief report the objective of a run after an outer iteration. Thread-safe
+            /// @param the index of the run
+            /// @param the objective after the outer iteration
+            /// @param the stage of the run
+            /// @return whether the run should be cancelled
+            bool report(IndexType runIdx, RealType obj, IndexType stage = 0)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto &runObjs = _objs.at(runIdx);
+                if (runObjs.size() <= stage)
+                {
+                    runObjs.resize(stage + 1);
+                }
+                auto &objs = runObjs[stage];
+                objs.emplace_back(obj);
+                const IndexType iter = objs.size() - 1;
+                if (_cancelled[runIdx] or iter < minOuterIterBeforeCancel or obj <= 0)
+                {
+                    return _cancelled[runIdx];
+                }
+                for (IndexType otherIdx = 0; otherIdx < _objs.size(); ++otherIdx)
+                {
+                    if (otherIdx == runIdx or _cancelled[otherIdx] or _objs[otherIdx].size() <= stage or _objs[otherIdx][stage].size() <= iter)
+                    {
+                        continue;
+                    }
+                    const RealType otherObj = _objs[otherIdx][stage][iter];
+                    if (otherObj > 0 and obj > cancelRatio * otherObj)
+                    {
+                        _cancelled[runIdx] = true;
+                        break;
+                    }
+                }
+                return _cancelled[runIdx];
+            }
+            /// @brief whether a run has been cancelled. Thread-safe
+            bool cancelled(IndexType runIdx) const
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                return _cancelled.at(runIdx);
+            }
+            IndexType numRuns() const { return _objs.size(); }
+            /// @brief the name of a stop watch of a run, so that the concurrent runs do not record into the same watch
+            /// @param the name of the watch when running alone
+            /// @param the monitor of the multi-start. nullptr if running alone
+            /// @param the index of the run
+            /// @return the name with a suffix of the run, or the same name if running alone
+            static std::string stopWatchName(const std::string &name, const MultiStartMonitor *monitor, IndexType runIdx)
+            {
+                if (monitor == nullptr)
+                {
+                    return name;
+                }
+                return name + "_run" + std::to_string(runIdx);
+            }
+        private:
+            mutable std::mutex _mutex;
+            std::vector<std::vector<std::vector<RealType>>> _objs; ///< The objectives of each run after each of its outer iterations, by stage
+            std::vector<bool> _cancelled; ///< Whether each run has been cancelled
+    };
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
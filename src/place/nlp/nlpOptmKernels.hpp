@@ -129,7 +129,41 @@ namespace nlp
             }
         };
 
+        /// @brief stop by the wall-clock budget of the run. The cap of the iterations is adapted to the measured cost of an iteration. See nlp::TimeBudget
+        /// It counts the inner iterations for that measurement, so put it ahead of the other stop criteria of a converge_list
+        struct converge_criteria_time_budget {};
+
+        template<>
+        struct converge_criteria_trait<converge_criteria_time_budget>
+        {
+            typedef converge_criteria_time_budget converge_type;
+            static void clear(converge_type &) {}
+            template<typename nlp_type, typename optm_type>
+            static BoolType stopCriteria(nlp_type &n, optm_type &, converge_type &)
+            {
+                return n._timeBudget.stopInner();
+            }
+        };
+
+        /// @brief never stops. Records the trace after each inner iteration. See nlp::trace::TraceRecorder
+        /// Put it at the head of a converge_list, so that the record is taken before any criterion stops the inner loop
+        struct converge_criteria_trace {};
+
+        template<>
+        struct converge_criteria_trait<converge_criteria_trace>
+        {
+            typedef converge_criteria_trace converge_type;
+            static void clear(converge_type &) {}
+            template<typename nlp_type, typename optm_type>
+            static BoolType stopCriteria(nlp_type &n, optm_type &, converge_type &)
+            {
+                n._trace.recordInner(n);
+                return false;
+            }
+        };
+
         /// @brief a convenient wrapper for combining different types of converge condition. the list in the template will be check one by one and return converge if any of them say so
+        /// Every criterion is checked in each iteration, in the order of the list, even after an earlier one says so
         template<typename converge_type, typename... others>
         struct converge_list 
         {
@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include <ratio>
 #include "global/global.h"
 #include "nlpTypes.hpp"
 #include "place/different.h"
+#include "nlpOverlapOps.hpp"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -61,6 +63,7 @@ namespace nlp
         struct stop_after_violate_small
         {
             static constexpr RealType overlapRatio = 0.01; ///< with respect to total cell area
+            static constexpr RealType densityOverflowRatio = 0.1; ///< with respect to total cell area. For the density-based overlapping operators
             static constexpr RealType outOfBoundaryRatio = 0.05; ///< with respect to boundary
             static constexpr RealType asymRatio = 0.05; ///< with respect to sqrt(total cell area)
         };
@@ -83,43 +86,42 @@ namespace nlp
             {
                 using CoordType = typename NlpType::nlp_coordinate_type;
                 // check whether overlapping is small than threshold
-                CoordType ovlArea = 0;
-                const CoordType ovlThreshold = stop.overlapRatio * n._totalCellArea;
-                for (auto &op : n._ovlOps)
+                constexpr bool isDensity = diff::is_density_overlap_operator<typename NlpType::nlp_ovl_type>::value;
+                const CoordType ovlThreshold = (isDensity ? stop.densityOverflowRatio : stop.overlapRatio) * n._totalCellArea;
+                const CoordType ovlArea = ovl_ops::ovl_ops_trait<typename NlpType::nlp_ovl_type>::overlapArea(n, ovlThreshold);
+                if (ovlArea > ovlThreshold)
                 {
-                    ovlArea += diff::place_overlap_trait<typename NlpType::nlp_ovl_type>::overlapArea(op);
-                    if (ovlArea > ovlThreshold)
-                    {
-                        return false;
-                    }
+                    return false;
                 }
                 // Check whether out of boundary is smaller than threshold
                 CoordType oobArea = 0;
                 const CoordType oobThreshold = stop.outOfBoundaryRatio * n._boundary.area();
-                for (auto &op : n._oobOps)
+                #pragma omp parallel for schedule(static) reduction(+:oobArea)
+                for (IndexType idx = 0; idx < n._oobOps.size(); ++idx)
+                {
+                    oobArea +=  diff::place_out_of_boundary_trait<typename NlpType::nlp_oob_type>::oobArea(n._oobOps[idx]);
+                }
+                if (oobArea > oobThreshold)
                 {
-                    oobArea +=  diff::place_out_of_boundary_trait<typename NlpType::nlp_oob_type>::oobArea(op);
-                    if (oobArea > oobThreshold)
-                    {
 #ifdef DEBUG_GR
-                        DBG("fail on oob \n");
+                    DBG("fail on oob \n");
 #endif
-                        return false;
-                    }
+                    return false;
                 }
                 // Check whether asymmetry distance is smaller than threshold
                 CoordType asymDist = 0;
                 const CoordType asymThreshold = stop.asymRatio * std::sqrt(n._totalCellArea);
-                for (auto & op : n._asymOps)
+                #pragma omp parallel for schedule(static) reduction(+:asymDist)
+                for (IndexType idx = 0; idx < n._asymOps.size(); ++idx)
+                {
+                    asymDist += diff::place_asym_trait<typename NlpType::nlp_asym_type>::asymDistanceNormalized(n._asymOps[idx]);
+                }
+                if (asymDist > asymThreshold)
                 {
-                    asymDist += diff::place_asym_trait<typename NlpType::nlp_asym_type>::asymDistanceNormalized(op);
-                    if (asymDist > asymThreshold)
-                    {
 #ifdef DEBUG_GR
-                        DBG("fail on asym \n");
+                    DBG("fail on asym \n");
 #endif
-                        return false;
-                    }
+                    return false;
                 }
 
 #ifdef DEBUG_GR
@@ -665,13 +667,13 @@ namespace nlp
             {
                 init::multiplier_init_trait<init_type>::init(nlp, mult);
                 update::multiplier_update_trait<update_type>::init(nlp, mult, mult.update);
-                for (auto &op : nlp._hpwlOps) { op._getLambdaFunc = [&](){ return mult._constMults[0]; }; }
-                for (auto &op : nlp._cosOps) { op._getLambdaFunc = [&](){ return mult._constMults[1]; }; }
-                for (auto &op : nlp._ovlOps) { op._getLambdaFunc = [&](){ return mult._variedMults[0]; }; }
-                for (auto &op : nlp._oobOps) { op._getLambdaFunc = [&](){ return mult._variedMults[1]; }; }
-                for (auto &op : nlp._asymOps) { op._getLambdaFunc = [&](){ return mult._variedMults[2]; }; }
-                for (auto &op : nlp._powerWlOps) { op._getLambdaFunc = [&](){ return mult._constMults[2]; }; }
-                for (auto &op : nlp._crfOps) { op._getLambdaFunc = [&](){ return mult._variedMults[3]; }; }
+                for (auto &op : nlp._hpwlOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._constMults[0]); }
+                for (auto &op : nlp._cosOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._constMults[1]); }
+                for (auto &op : nlp._ovlOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._variedMults[0]); }
+                for (auto &op : nlp._oobOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._variedMults[1]); }
+                for (auto &op : nlp._asymOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._variedMults[2]); }
+                for (auto &op : nlp._powerWlOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._constMults[2]); }
+                for (auto &op : nlp._crfOps) { op._getLambdaFunc = diff::NumericRef<typename nlp_type::nlp_numerical_type>(&mult._variedMults[3]); }
             }
 
             template<typename nlp_type>
@@ -731,19 +733,19 @@ namespace nlp
             {
                 for (auto & op : nlp._hpwlOps)
                 {
-                    op.setGetAlphaFunc([&](){ return alpha._alpha[0]; });
+                    op.setGetAlphaFunc(diff::NumericRef<typename nlp_type::nlp_numerical_type>(&alpha._alpha[0]));
                 }
                 for (auto & op : nlp._ovlOps)
                 {
-                    op.setGetAlphaFunc([&](){ return alpha._alpha[1]; });
+                    op.setGetAlphaFunc(diff::NumericRef<typename nlp_type::nlp_numerical_type>(&alpha._alpha[1]));
                 }
                 for (auto & op : nlp._oobOps)
                 {
-                    op.setGetAlphaFunc([&](){ return alpha._alpha[2]; });
+                    op.setGetAlphaFunc(diff::NumericRef<typename nlp_type::nlp_numerical_type>(&alpha._alpha[2]));
                 }
                 for (auto & op : nlp._crfOps)
                 {
-                    op.setGetAlphaFunc([&](){ return alpha._alpha[3]; });
+                    op.setGetAlphaFunc(diff::NumericRef<typename nlp_type::nlp_numerical_type>(&alpha._alpha[3]));
                 }
             }
 
@@ -890,19 +892,20 @@ namespace nlp
 
             /// @breif update the alpha that mapping objective function to alpha, from [0, init_obj] -> [min, max]
             /// @tparam the index of which alpha to update
-            template<typename nlp_numerical_type, IndexType alphaIdx>
+            /// @tparam the max alpha as a std::ratio. A warm start uses a smaller one, since its cells are already spread
+            template<typename nlp_numerical_type, IndexType alphaIdx, typename alpha_max_ratio = std::ratio<2>>
             struct linear_by_obj
             {
                 // alpha = a / (x - k * obj_init) + b
-                static constexpr nlp_numerical_type alphaMax = 2.0;
+                static constexpr nlp_numerical_type alphaMax = static_cast<nlp_numerical_type>(alpha_max_ratio::num) / alpha_max_ratio::den;
                 static constexpr nlp_numerical_type alphaMin = 0.4;
                 nlp_numerical_type objInit = -1.0;
             };
 
-            template<typename nlp_numerical_type, IndexType alphaIdx>
-            struct alpha_update_trait<linear_by_obj<nlp_numerical_type, alphaIdx>> 
+            template<typename nlp_numerical_type, IndexType alphaIdx, typename alpha_max_ratio>
+            struct alpha_update_trait<linear_by_obj<nlp_numerical_type, alphaIdx, alpha_max_ratio>> 
             {
-                typedef linear_by_obj<nlp_numerical_type, alphaIdx> update_type;
+                typedef linear_by_obj<nlp_numerical_type, alphaIdx, alpha_max_ratio> update_type;
 
                 template<typename nlp_type>
                 static constexpr typename nlp_type::nlp_numerical_type obj(nlp_type &nlp) 
@@ -0,0 +1,264 @@
+/**
+ * @file nlpOverlapOps.hpp
+ * @brief The construction and maintenance of the overlapping operators for global plaement
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
+#include "global/global.h"
+#include "util/Box.h"
+#include "place/different.h"
+#include "place/differentDensity.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    namespace ovl_ops
+    {
+        /// @brief trait for building the overlapping operators of a type and keep them up to date. Need partial specification
+        template<typename op_type>
+        struct ovl_ops_trait
+        {
+            // template<typename nlp_type> static void construct(nlp_type &, getAlphaFunc, getLambdaFunc, getVarFunc)
+            // template<typename nlp_type> static void refresh(nlp_type &)
+            // template<typename nlp_type> static nlp_coordinate_type overlapArea(nlp_type &, nlp_coordinate_type stopAbove)
+        };
+
+        /// @brief the total pair-wise overlapping area of boxes, by a sweep line along x.
+        /// @details The boxes crossing the sweep line are kept ordered by their bottom, so only the boxes within the largest height are visited for each box.
+        /// O(n log n + k) for k overlapping pairs when the heights are comparable, instead of visiting all the pairs
+        /// @param the boxes
+        /// @param return early once the area is larger than this
+        template<typename coordinate_type>
+        coordinate_type sweepPairOverlapArea(const std::vector<Box<coordinate_type>> &boxes, coordinate_type stopAbove)
+        {
+            coordinate_type maxHeight = 0;
+            std::vector<IndexType> order(boxes.size());
+            for (IndexType idx = 0; idx < boxes.size(); ++idx)
+            {
+                order[idx] = idx;
+                maxHeight = std::max(maxHeight, boxes[idx].yLen());
+            }
+            std::sort(order.begin(), order.end(), [&](IndexType lhs, IndexType rhs) { return boxes[lhs].xLo() < boxes[rhs].xLo(); });
+
+            typedef std::multimap<coordinate_type, IndexType> active_type;
+            active_type active; // The boxes crossing the sweep line, by their bottom
+            std::vector<typename active_type::iterator> activeIters(boxes.size());
+            typedef std::pair<coordinate_type, IndexType> leaving_type;
+            std::priority_queue<leaving_type, std::vector<leaving_type>, std::greater<leaving_type>> leaving; // The active boxes by their right
+            coordinate_type area = 0;
+            for (IndexType idx : order)
+            {
+                const auto &box = boxes[idx];
+                while (not leaving.empty() and leaving.top().first <= box.xLo())
+                {
+                    active.erase(activeIters[leaving.top().second]);
+                    leaving.pop();
+                }
+                for (auto iter = active.lower_bound(box.yLo() - maxHeight); iter != active.end() and iter->first < box.yHi(); ++iter)
+                {
+                    const auto &other = boxes[iter->second];
+                    const coordinate_type overlapX = std::max(std::min(box.xHi(), other.xHi()) - std::max(box.xLo(), other.xLo()), static_cast<coordinate_type>(0.0));
+                    const coordinate_type overlapY = std::max(std::min(box.yHi(), other.yHi()) - std::max(box.yLo(), other.yLo()), static_cast<coordinate_type>(0.0));
+                    area += overlapX * overlapY;
+                }
+                if (area > stopAbove)
+                {
+                    return area;
+                }
+                activeIters[idx] = active.emplace(box.yLo(), idx);
+                leaving.emplace(box.xHi(), idx);
+            }
+            return area;
+        }
+
+        /// @brief all-pairs. One operator for each pair of cells
+        template<typename NumType, typename CoordType>
+        struct ovl_ops_trait<diff::CellPairOverlapPenaltyDifferentiable<NumType, CoordType>>
+        {
+            typedef diff::CellPairOverlapPenaltyDifferentiable<NumType, CoordType> op_type;
+
+            template<typename nlp_type, typename alpha_func_type, typename lambda_func_type, typename var_func_type>
+            static void construct(nlp_type &n, const alpha_func_type &getAlphaFunc, const lambda_func_type &getLambdaFunc, const var_func_type &getVarFunc)
+            {
+                for (IndexType cellIdxI = 0; cellIdxI < n._db.numCells(); ++cellIdxI)
+                {
+                    const auto cellBBoxI = n._db.cell(cellIdxI).cellBBox();
+                    for (IndexType cellIdxJ = cellIdxI + 1; cellIdxJ < n._db.numCells(); ++cellIdxJ)
+                    {
+                        const auto cellBBoxJ = n._db.cell(cellIdxJ).cellBBox();
+                        n._ovlOps.emplace_back(op_type(
+                                    cellIdxI,
+                                    cellBBoxI.xLen() * n._scale,
+                                    cellBBoxI.yLen() * n._scale,
+                                    cellIdxJ,
+                                    cellBBoxJ.xLen() * n._scale,
+                                    cellBBoxJ.yLen() * n._scale,
+                                    getAlphaFunc,
+                                    getLambdaFunc
+                                    ));
+                        n._ovlOps.back().setGetVarFunc(getVarFunc);
+                    }
+                }
+            }
+
+            template<typename nlp_type>
+            static void refresh(nlp_type &) {}
+
+            /// @brief the total overlapping area of the pairs. The same as summing the operators, without visiting all the pairs
+            template<typename nlp_type>
+            static typename nlp_type::nlp_coordinate_type overlapArea(nlp_type &n, typename nlp_type::nlp_coordinate_type stopAbove)
+            {
+                typedef typename nlp_type::nlp_coordinate_type coordinate_type;
+                std::vector<Box<coordinate_type>> cellBoxes;
+                cellBoxes.reserve(n._db.numCells());
+                for (IndexType cellIdx = 0; cellIdx < n._db.numCells(); ++cellIdx)
+                {
+                    const auto cellBBox = n._db.cell(cellIdx).cellBBox();
+                    const coordinate_type x = n._pl(n.plIdx(cellIdx, Orient2DType::HORIZONTAL));
+                    const coordinate_type y = n._pl(n.plIdx(cellIdx, Orient2DType::VERTICAL));
+                    cellBoxes.emplace_back(x, y, x + cellBBox.xLen() * n._scale, y + cellBBox.yLen() * n._scale);
+                }
+                return sweepPairOverlapArea(cellBoxes, stopAbove);
+            }
+        };
+
+        /// @brief Verlet neighbor list. The pairs are shared among a few operators, so that they can be evaluated in parallel
+        template<typename NumType, typename CoordType>
+        struct ovl_ops_trait<diff::CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType>>
+        {
+            typedef diff::CellPairOverlapNeighborListPenaltyDifferentiable<NumType, CoordType> op_type;
+            typedef typename op_type::neighbor_list_type neighbor_list_type;
+            static constexpr CoordType skinRatio = 0.5; ///< The skin distance with respect to the average cell dimension
+            static constexpr CoordType cutoffAlphaRatio = 8; ///< The cutoff distance in terms of alpha
+
+            template<typename nlp_type, typename alpha_func_type, typename lambda_func_type, typename var_func_type>
+            static void construct(nlp_type &n, const alpha_func_type &getAlphaFunc, const lambda_func_type &getLambdaFunc, const var_func_type &getVarFunc)
+            {
+                const IndexType numCells = n._db.numCells();
+                if (numCells < 2)
+                {
+                    return;
+                }
+                auto neighborList = std::make_shared<neighbor_list_type>();
+                for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+                {
+                    const auto cellBBox = n._db.cell(cellIdx).cellBBox();
+                    neighborList->addCell(cellIdx, cellBBox.xLen() * n._scale, cellBBox.yLen() * n._scale);
+                }
+                neighborList->setSkin(skinRatio * std::sqrt(n._totalCellArea / numCells));
+                neighborList->setCutoffAlphaRatio(cutoffAlphaRatio);
+                const IndexType numSlices = std::max(std::min(n._db.parameters().numThreads(), numCells), static_cast<IndexType>(1));
+                for (IndexType sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+                {
+                    n._ovlOps.emplace_back(op_type(neighborList, sliceIdx, numSlices, getAlphaFunc, getLambdaFunc));
+                    n._ovlOps.back().setGetVarFunc(getVarFunc);
+                }
+            }
+
+            /// @brief rebuild the neighbor list if needed. All the operators share the same list
+            template<typename nlp_type>
+            static void refresh(nlp_type &n)
+            {
+                if (n._ovlOps.empty())
+                {
+                    return;
+                }
+                n._ovlOps.front().refreshNeighborList();
+            }
+
+            /// @brief the total overlapping area of the pairs. Does not need the neighbor list to be up to date
+            template<typename nlp_type>
+            static typename nlp_type::nlp_coordinate_type overlapArea(nlp_type &n, typename nlp_type::nlp_coordinate_type stopAbove)
+            {
+                typedef typename nlp_type::nlp_coordinate_type coordinate_type;
+                std::vector<Box<coordinate_type>> cellBoxes;
+                cellBoxes.reserve(n._db.numCells());
+                for (IndexType cellIdx = 0; cellIdx < n._db.numCells(); ++cellIdx)
+                {
+                    const auto cellBBox = n._db.cell(cellIdx).cellBBox();
+                    const coordinate_type x = n._pl(n.plIdx(cellIdx, Orient2DType::HORIZONTAL));
+                    const coordinate_type y = n._pl(n.plIdx(cellIdx, Orient2DType::VERTICAL));
+                    cellBoxes.emplace_back(x, y, x + cellBBox.xLen() * n._scale, y + cellBBox.yLen() * n._scale);
+                }
+                return sweepPairOverlapArea(cellBoxes, stopAbove);
+            }
+        };
+
+        /// @brief electrostatic density. The cells are shared among a few operators, so that they can be evaluated in parallel
+        template<typename NumType, typename CoordType>
+        struct ovl_ops_trait<diff::ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType>>
+        {
+            typedef diff::ElectrostaticDensityPenaltyDifferentiable<NumType, CoordType> op_type;
+            typedef typename op_type::density_map_type density_map_type;
+            static constexpr IndexType minNumBinsPerDim = 16;
+            static constexpr IndexType maxNumBinsPerDim = 512;
+
+            template<typename nlp_type, typename alpha_func_type, typename lambda_func_type, typename var_func_type>
+            static void construct(nlp_type &n, const alpha_func_type &getAlphaFunc, const lambda_func_type &getLambdaFunc, const var_func_type &getVarFunc)
+            {
+                const IndexType numCells = n._db.numCells();
+                if (numCells < 2)
+                {
+                    return;
+                }
+                // Around one cell per bin. Power of two for the FFT
+                IndexType numBinsPerDim = minNumBinsPerDim;
+                while (numBinsPerDim * numBinsPerDim < numCells and numBinsPerDim < maxNumBinsPerDim)
+                {
+                    numBinsPerDim *= 2;
+                }
+                auto densityMap = std::make_shared<density_map_type>(&n._boundary, numBinsPerDim);
+                for (IndexType cellIdx = 0; cellIdx < numCells; ++cellIdx)
+                {
+                    const auto cellBBox = n._db.cell(cellIdx).cellBBox();
+                    densityMap->addCell(cellIdx, cellBBox.xLen() * n._scale, cellBBox.yLen() * n._scale);
+                }
+                const IndexType numSlices = std::max(std::min(n._db.parameters().numThreads(), numCells), static_cast<IndexType>(1));
+                for (IndexType sliceIdx = 0; sliceIdx < numSlices; ++sliceIdx)
+                {
+                    n._ovlOps.emplace_back(op_type(densityMap, sliceIdx, numSlices, getAlphaFunc, getLambdaFunc));
+                    n._ovlOps.back().setGetVarFunc(getVarFunc);
+                }
+            }
+
+            /// @brief re-solve the density map for the current placement. All the operators share the same map
+            template<typename nlp_type>
+            static void refresh(nlp_type &n)
+            {
+                if (n._ovlOps.empty())
+                {
+                    return;
+                }
+                n._ovlOps.front().updateDensityMap();
+            }
+
+            /// @brief the total density overflow area of the bins
+            template<typename nlp_type>
+            static typename nlp_type::nlp_coordinate_type overlapArea(nlp_type &n, typename nlp_type::nlp_coordinate_type stopAbove)
+            {
+                refresh(n);
+                typename nlp_type::nlp_coordinate_type area = 0;
+                for (auto &op : n._ovlOps)
+                {
+                    area += diff::place_overlap_trait<op_type>::overlapArea(op);
+                    if (area > stopAbove)
+                    {
+                        return area;
+                    }
+                }
+                return area;
+            }
+        };
+    } // namespace ovl_ops
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
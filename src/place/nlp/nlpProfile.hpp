@@ -0,0 +1,196 @@
+/**
+ * @file nlpProfile.hpp
+ * @brief The profiling counters of the operator families in the global placement
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "global/global.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    namespace profile
+    {
+        /// @brief the families of the operators
+        enum class OpFamily
+        {
+            HPWL = 0,
+            OVL = 1,
+            OOB = 2,
+            ASYM = 3,
+            COS = 4,
+            POWER_WL = 5,
+            CRF = 6
+        };
+        constexpr IndexType numOpFamilies = 7;
+
+        inline const char * opFamilyName(IndexType family)
+        {
+            constexpr const char *names[numOpFamilies] = { "hpwl", "ovl", "oob", "asym", "cos", "powerWl", "crf" };
+            return names[family];
+        }
+
+        /// @brief the counters of a family
+        struct OpFamilyCounters
+        {
+            std::uint64_t numEvals = 0; ///< The number of the gradient evaluations
+            std::uint64_t numOps = 0; ///< The number of the operators in an evaluation
+            std::uint64_t calcNs = 0; ///< The time of calculating the partials, summed over the threads
+            std::uint64_t scatterNs = 0; ///< The time of gathering the partials into the gradient, summed over the threads
+            RealType nsPerOp() const { return numEvals * numOps > 0 ? static_cast<RealType>(calcNs) / (numEvals * numOps) : 0; }
+        };
+
+        /// @brief the profile of one or more global placement runs. Owned by the caller of the placers, which merges the runs explicitly
+        struct Profile
+        {
+            std::array<OpFamilyCounters, numOpFamilies> families;
+            std::vector<IndexType> innerIters; ///< The gradient evaluations in each outer iteration, i.e. the inner iterations of the adam and nesterov kernels
+
+            /// @brief add the counters of another run. The number of operators is the total of the runs
+            void merge(const Profile &other)
+            {
+                for (IndexType family = 0; family < numOpFamilies; ++family)
+                {
+                    auto &counters = families[family];
+                    const auto &otherCounters = other.families[family];
+                    // Keep the time per operator right when the runs have different numbers of operators
+                    const std::uint64_t opEvals = counters.numEvals * counters.numOps + otherCounters.numEvals * otherCounters.numOps;
+                    counters.numEvals += otherCounters.numEvals;
+                    counters.numOps = counters.numEvals > 0 ? opEvals / counters.numEvals : 0;
+                    counters.calcNs += otherCounters.calcNs;
+                    counters.scatterNs += otherCounters.scatterNs;
+                }
+                innerIters.insert(innerIters.end(), other.innerIters.begin(), other.innerIters.end());
+            }
+            /// @brief the counters of each family by name
+            std::map<std::string, std::map<std::string, RealType>> toMap() const
+            {
+                std::map<std::string, std::map<std::string, RealType>> map;
+                for (IndexType family = 0; family < numOpFamilies; ++family)
+                {
+                    const auto &counters = families[family];
+                    auto &entry = map[opFamilyName(family)];
+                    entry["numEvals"] = counters.numEvals;
+                    entry["numOps"] = counters.numOps;
+                    entry["ns"] = counters.calcNs;
+                    entry["nsPerOp"] = counters.nsPerOp();
+                    entry["scatterNs"] = counters.scatterNs;
+                }
+                return map;
+            }
+            /// @brief write the profile as JSON
+            /// @return whether the file is written successfully
+            bool writeJson(const std::string &filename) const
+            {
+                std::ofstream os(filename);
+                os << "{\n  \"families\": {\n";
+                for (IndexType family = 0; family < numOpFamilies; ++family)
+                {
+                    const auto &counters = families[family];
+                    os << "    \"" << opFamilyName(family) << "\": { "
+                       << "\"numEvals\": " << counters.numEvals << ", "
+                       << "\"numOps\": " << counters.numOps << ", "
+                       << "\"ns\": " << counters.calcNs << ", "
+                       << "\"nsPerOp\": " << counters.nsPerOp() << ", "
+                       << "\"scatterNs\": " << counters.scatterNs << " }"
+                       << (family + 1 < numOpFamilies ? ",\n" : "\n");
+                }
+                os << "  },\n  \"innerIters\": [";
+                for (IndexType iter = 0; iter < innerIters.size(); ++iter)
+                {
+                    os << (iter > 0 ? ", " : "") << innerIters[iter];
+                }
+                os << "]\n}\n";
+                return os.good();
+            }
+        };
+
+        /// @brief collects the counters of a run. Each thread adds to its own counters, so nothing is shared in the hot loops
+        class OpProfiler
+        {
+            public:
+                typedef std::chrono::steady_clock clock_type;
+                /// @brief reset the counters
+                /// @param the number of operators of each family
+                void init(const std::array<std::uint64_t, numOpFamilies> &numOps)
+                {
+                    _threads.assign(omp_get_max_threads(), ThreadCounters());
+                    _profile = Profile();
+                    for (IndexType family = 0; family < numOpFamilies; ++family)
+                    {
+                        _profile.families[family].numOps = numOps[family];
+                    }
+                    _numEvals = 0;
+                    _numEvalsAtOuterBegin = 0;
+                }
+                static clock_type::time_point now() { return clock_type::now(); }
+                /// @brief add the time since a time point to the calculation of a family. Called by any thread
+                /// @return the current time, to be the start of the next measurement
+                clock_type::time_point addCalc(OpFamily family, clock_type::time_point since) { return add(family, since, false); }
+                /// @brief add the time since a time point to the scatter of a family. Called by any thread
+                /// @return the current time, to be the start of the next measurement
+                clock_type::time_point addScatter(OpFamily family, clock_type::time_point since) { return add(family, since, true); }
+                /// @brief count an evaluation of all the families. Called by one thread
+                void countEval() { ++_numEvals; }
+                /// @brief record the number of evaluations of the finished outer iteration
+                void endOuterIter()
+                {
+                    _profile.innerIters.emplace_back(_numEvals - _numEvalsAtOuterBegin);
+                    _numEvalsAtOuterBegin = _numEvals;
+                }
+                /// @brief the profile of the run so far
+                Profile profile() const
+                {
+                    Profile result = _profile;
+                    for (IndexType family = 0; family < numOpFamilies; ++family)
+                    {
+                        auto &counters = result.families[family];
+                        counters.numEvals = _numEvals;
+                        for (const auto &thread : _threads)
+                        {
+                            counters.calcNs += thread.calcNs[family];
+                            counters.scatterNs += thread.scatterNs[family];
+                        }
+                    }
+                    return result;
+                }
+            private:
+                /// @brief padded to a cache line, so that the threads do not write to the same line
+                struct alignas(64) ThreadCounters
+                {
+                    std::array<std::uint64_t, numOpFamilies> calcNs = {};
+                    std::array<std::uint64_t, numOpFamilies> scatterNs = {};
+                };
+                clock_type::time_point add(OpFamily family, clock_type::time_point since, bool scatter)
+                {
+                    const auto curr = clock_type::now();
+                    const IndexType threadIdx = omp_get_thread_num();
+                    if (threadIdx < _threads.size())
+                    {
+                        auto &counters = scatter ? _threads[threadIdx].scatterNs : _threads[threadIdx].calcNs;
+                        counters[static_cast<IndexType>(family)] += std::chrono::duration_cast<std::chrono::nanoseconds>(curr - since).count();
+                    }
+                    return curr;
+                }
+            private:
+                std::vector<ThreadCounters> _threads;
+                Profile _profile;
+                std::uint64_t _numEvals = 0;
+                std::uint64_t _numEvalsAtOuterBegin = 0;
+        };
+    } // namespace profile
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
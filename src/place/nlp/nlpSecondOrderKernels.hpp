@@ -64,7 +64,7 @@ namespace nlp
                 {
                     n.calcGrad();
                     n.calcHessian();;
-                    n._pl -= optm_type::_stepSize * n.inverseHessian() * n._grad;
+                    n._pl -= optm_type::_stepSize * n.newtonDirection(n._grad);
                     ++iter;
                 } while (!converge_trait::stopCriteria(n, o, o._converge) );
                 n.calcObj();
@@ -93,7 +93,7 @@ namespace nlp
                     ++iter;
                     n.calcGrad();
                     n.calcHessian();
-                    auto grad = n.inverseHessian() * n._grad;
+                    const typename nlp_type::EigenVector grad = n.newtonDirection(n._grad);
                     m = o.beta1 * m + (1 - o.beta1) * grad;
                     v = o.beta2 * v + (1 - o.beta2) * grad.cwiseProduct(grad);
                     auto mt = m / (1 - pow(o.beta1, iter));
@@ -135,7 +135,7 @@ namespace nlp
                     ++iter;
                     n.calcGrad();
                     n.calcHessian();
-                    yCurr = n._pl - o.eta * n.inverseHessian() * n._grad;
+                    yCurr = n._pl - o.eta * n.newtonDirection(n._grad);
                     n._pl = (1 - gamma) * yCurr + gamma * yPrev;
 
                     yPrev = yCurr;
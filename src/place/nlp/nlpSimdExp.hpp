@@ -0,0 +1,186 @@
+/**
+ * @file nlpSimdExp.hpp
+ * @brief Vectorized exponential for the batched kernels. AVX-512/AVX2 with runtime dispatch and a scalar fallback
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "global/global.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IDEAPLACE_SIMD_EXP_X86_
+#include <immintrin.h>
+#endif
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    namespace simd
+    {
+        /// @brief the instruction set used by the vectorized kernels
+        enum class SimdIsaType
+        {
+            SCALAR,
+            AVX2,
+            AVX512
+        };
+
+        namespace _exp_details
+        {
+            /* exp(x) = 2^n * exp(r), x = n * ln2 + r, |r| <= ln2 / 2. exp(r) by degree-12 Taylor series.
+             * n reaches 1024 at the top and -1075 at the bottom, out of the normal exponents, so 2^n is applied as two halves.
+             * Above expHi (the log of the largest double) the result saturates instead of overflowing. Below expLo it is 0, as in std::exp */
+            constexpr double expHi = 709.78;
+            constexpr double expLo = -745.13;
+            constexpr double log2e = 1.4426950408889634074;
+            constexpr double ln2Hi = 0.693145751953125;
+            constexpr double ln2Lo = 1.42860682030941723212e-6;
+            constexpr double coef[13] = {
+                1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+                1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600 };
+
+            /// @brief out[i] = exp(scale * in[i])
+            inline void expScaledScalar(const double *in, double *out, std::size_t n, double scale)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    out[i] = std::exp(scale * in[i]);
+                }
+            }
+
+#ifdef IDEAPLACE_SIMD_EXP_X86_
+            __attribute__((target("avx2,fma")))
+            inline __m256d expAvx2(__m256d in)
+            {
+                const __m256d underflow = _mm256_cmp_pd(in, _mm256_set1_pd(expLo), _CMP_LT_OQ);
+                const __m256d x = _mm256_min_pd(_mm256_max_pd(in, _mm256_set1_pd(expLo)), _mm256_set1_pd(expHi));
+                const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2Hi), x);
+                r = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2Lo), r);
+                __m256d p = _mm256_set1_pd(coef[12]);
+                for (IntType k = 11; k >= 0; --k)
+                {
+                    p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(coef[k]));
+                }
+                // 2^n = 2^n1 * 2^n2 from the exponent bits. Both halves are normal
+                const __m128i ni = _mm256_cvtpd_epi32(n);
+                const __m128i n1 = _mm_srai_epi32(ni, 1);
+                const __m128i n2 = _mm_sub_epi32(ni, n1);
+                const __m256i bias = _mm256_set1_epi64x(1023);
+                const __m256i e1 = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(n1), bias), 52);
+                const __m256i e2 = _mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(n2), bias), 52);
+                const __m256d result = _mm256_mul_pd(_mm256_mul_pd(p, _mm256_castsi256_pd(e1)), _mm256_castsi256_pd(e2));
+                return _mm256_andnot_pd(underflow, result);
+            }
+
+            __attribute__((target("avx2,fma")))
+            inline void expScaledAvx2(const double *in, double *out, std::size_t n, double scale)
+            {
+                const __m256d vScale = _mm256_set1_pd(scale);
+                std::size_t i = 0;
+                for (; i + 4 <= n; i += 4)
+                {
+                    _mm256_storeu_pd(out + i, expAvx2(_mm256_mul_pd(_mm256_loadu_pd(in + i), vScale)));
+                }
+                expScaledScalar(in + i, out + i, n - i, scale);
+            }
+
+            // The AVX-512 intrinsics of some GCC versions leave the pass-through operand undefined on purpose
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+            __attribute__((target("avx512f")))
+            inline __m512d expAvx512(__m512d in)
+            {
+                const __mmask8 underflow = _mm512_cmp_pd_mask(in, _mm512_set1_pd(expLo), _CMP_LT_OQ);
+                const __m512d x = _mm512_min_pd(_mm512_max_pd(in, _mm512_set1_pd(expLo)), _mm512_set1_pd(expHi));
+                const __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Hi), x);
+                r = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Lo), r);
+                __m512d p = _mm512_set1_pd(coef[12]);
+                for (IntType k = 11; k >= 0; --k)
+                {
+                    p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(coef[k]));
+                }
+                // scalef takes any n, including the subnormal results
+                return _mm512_maskz_mov_pd(static_cast<__mmask8>(~underflow), _mm512_scalef_pd(p, n));
+            }
+
+            __attribute__((target("avx512f")))
+            inline void expScaledAvx512(const double *in, double *out, std::size_t n, double scale)
+            {
+                const __m512d vScale = _mm512_set1_pd(scale);
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    _mm512_storeu_pd(out + i, expAvx512(_mm512_mul_pd(_mm512_loadu_pd(in + i), vScale)));
+                }
+                expScaledScalar(in + i, out + i, n - i, scale);
+            }
+#pragma GCC diagnostic pop
+#endif // IDEAPLACE_SIMD_EXP_X86_
+
+            inline SimdIsaType detectIsa()
+            {
+#ifdef IDEAPLACE_SIMD_EXP_X86_
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f"))
+                {
+                    return SimdIsaType::AVX512;
+                }
+                if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                {
+                    return SimdIsaType::AVX2;
+                }
+#endif
+                return SimdIsaType::SCALAR;
+            }
+
+            inline SimdIsaType & isaRef()
+            {
+                static SimdIsaType isa = detectIsa();
+                return isa;
+            }
+        } // namespace _exp_details
+
+        /// @brief the instruction set in use
+        inline SimdIsaType simdIsa() { return _exp_details::isaRef(); }
+
+        /// @brief limit the instruction set. It can not exceed what the CPU supports
+        inline void setSimdIsa(SimdIsaType isa)
+        {
+            const auto supported = _exp_details::detectIsa();
+            _exp_details::isaRef() = static_cast<IntType>(isa) < static_cast<IntType>(supported) ? isa : supported;
+        }
+
+        /// @brief out[i] = exp(scale * in[i])
+        template<typename NumType>
+        inline void expScaled(const NumType *in, NumType *out, std::size_t n, NumType scale)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                out[i] = std::exp(scale * in[i]);
+            }
+        }
+
+        /// @brief out[i] = exp(scale * in[i]). Vectorized for double
+        template<>
+        inline void expScaled<double>(const double *in, double *out, std::size_t n, double scale)
+        {
+            switch (simdIsa())
+            {
+#ifdef IDEAPLACE_SIMD_EXP_X86_
+                case SimdIsaType::AVX512: _exp_details::expScaledAvx512(in, out, n, scale); return;
+                case SimdIsaType::AVX2: _exp_details::expScaledAvx2(in, out, n, scale); return;
+#endif
+                default: _exp_details::expScaledScalar(in, out, n, scale); return;
+            }
+        }
+    } // namespace simd
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
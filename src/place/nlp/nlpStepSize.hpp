@@ -0,0 +1,225 @@
+/**
+ * @file nlpStepSize.hpp
+ * @brief The step size policies for the first-order optimization kernels
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include "global/global.h"
+#include "nlpTypes.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    namespace optm
+    {
+        /// @brief the step size policies. Plugged into the kernels as a template parameter.
+        /// @details A policy decides the step size of the plain gradient steps, how long the warm-up of the kernel takes, and whether the momentum needs to be restarted
+        namespace step_size
+        {
+            template<typename step_size_type>
+            struct step_size_trait
+            {
+                // static constexpr bool needObj: whether the objective at the current point is needed by stepSize()
+                // static void clear(step_size_type &)
+                // template<typename nlp_type> static bool inWarmUp(nlp_type &, step_size_type &, IndexType iter)
+                // template<typename nlp_type, typename num_type> static num_type stepSize(nlp_type &, step_size_type &, num_type defaultStep)
+                // template<typename nlp_type, typename vector_type> static bool restart(nlp_type &, step_size_type &, const vector_type &yCurr, const vector_type &yPrev)
+            };
+
+            /// @brief the default step of the kernel. Warm up for a fixed number of iterations
+            template<IndexType warm_up_iter = 1000>
+            struct constant
+            {
+                static constexpr IndexType warmUpIter = warm_up_iter;
+            };
+
+            template<IndexType warm_up_iter>
+            struct step_size_trait<constant<warm_up_iter>>
+            {
+                typedef constant<warm_up_iter> step_size_type;
+                static constexpr bool needObj = false;
+                static void clear(step_size_type &) {}
+                template<typename nlp_type>
+                static bool inWarmUp(nlp_type &, step_size_type &, IndexType iter) { return iter <= step_size_type::warmUpIter; }
+                template<typename nlp_type, typename num_type>
+                static num_type stepSize(nlp_type &, step_size_type &, num_type defaultStep) { return defaultStep; }
+                template<typename nlp_type, typename vector_type>
+                static bool restart(nlp_type &, step_size_type &, const vector_type &, const vector_type &) { return false; }
+            };
+
+            /// @brief Barzilai-Borwein spectral step s^T s / s^T y from the last two gradient steps, clamped around the default step
+            template<typename nlp_numerical_type, IndexType warm_up_iter = 100>
+            struct barzilai_borwein
+            {
+                static constexpr IndexType warmUpIter = warm_up_iter;
+                static constexpr nlp_numerical_type minStepRatio = 0.01; ///< with respect to the default step
+                static constexpr nlp_numerical_type maxStepRatio = 100; ///< with respect to the default step
+                std::vector<nlp_numerical_type> _plPrev; ///< The variables at the last step
+                std::vector<nlp_numerical_type> _gradPrev; ///< The gradient at the last step
+            };
+
+            template<typename nlp_numerical_type, IndexType warm_up_iter>
+            struct step_size_trait<barzilai_borwein<nlp_numerical_type, warm_up_iter>>
+            {
+                typedef barzilai_borwein<nlp_numerical_type, warm_up_iter> step_size_type;
+                static constexpr bool needObj = false;
+                static void clear(step_size_type &s)
+                {
+                    s._plPrev.clear();
+                    s._gradPrev.clear();
+                }
+                template<typename nlp_type>
+                static bool inWarmUp(nlp_type &, step_size_type &, IndexType iter) { return iter <= step_size_type::warmUpIter; }
+                template<typename nlp_type, typename num_type>
+                static num_type stepSize(nlp_type &n, step_size_type &s, num_type defaultStep)
+                {
+                    const IndexType numVars = n._numVariables;
+                    num_type step = defaultStep;
+                    if (s._plPrev.size() == numVars)
+                    {
+                        nlp_numerical_type ss = 0, sy = 0;
+                        for (IndexType idx = 0; idx < numVars; ++idx)
+                        {
+                            const nlp_numerical_type sv = n._pl(idx) - s._plPrev[idx];
+                            const nlp_numerical_type yv = n._grad(idx) - s._gradPrev[idx];
+                            ss += sv * sv;
+                            sy += sv * yv;
+                        }
+                        // Keep the last step if the curvature along the step is not positive
+                        step = sy > 0 ? static_cast<num_type>(ss / sy) : defaultStep;
+                        step = std::max(step, static_cast<num_type>(step_size_type::minStepRatio * defaultStep));
+                        step = std::min(step, static_cast<num_type>(step_size_type::maxStepRatio * defaultStep));
+                    }
+                    s._plPrev.assign(n._pl.data(), n._pl.data() + numVars);
+                    s._gradPrev.assign(n._grad.data(), n._grad.data() + numVars);
+                    return step;
+                }
+                template<typename nlp_type, typename vector_type>
+                static bool restart(nlp_type &, step_size_type &, const vector_type &, const vector_type &) { return false; }
+            };
+
+            /// @brief all the objective members of the problem, i.e. the weighted and the raw terms.
+            /// Kept by the policies that evaluate the objective at trial points, so that the current point reads the same afterwards
+            template<typename nlp_numerical_type>
+            struct objective_snapshot
+            {
+                template<typename nlp_type>
+                void save(const nlp_type &n)
+                {
+                    obj = n._obj;
+                    hpwl = n._objHpwl; ovl = n._objOvl; oob = n._objOob; asym = n._objAsym; cos = n._objCos;
+                    powerWl = n._objPowerWl; crf = n._objCrf;
+                    hpwlRaw = n._objHpwlRaw; ovlRaw = n._objOvlRaw; oobRaw = n._objOobRaw; asymRaw = n._objAsymRaw; cosRaw = n._objCosRaw;
+                    powerWlRaw = n._objPowrWlRaw; crfRaw = n._objCrfRaw;
+                }
+                template<typename nlp_type>
+                void restore(nlp_type &n) const
+                {
+                    n._obj = obj;
+                    n._objHpwl = hpwl; n._objOvl = ovl; n._objOob = oob; n._objAsym = asym; n._objCos = cos;
+                    n._objPowerWl = powerWl; n._objCrf = crf;
+                    n._objHpwlRaw = hpwlRaw; n._objOvlRaw = ovlRaw; n._objOobRaw = oobRaw; n._objAsymRaw = asymRaw; n._objCosRaw = cosRaw;
+                    n._objPowrWlRaw = powerWlRaw; n._objCrfRaw = crfRaw;
+                }
+                nlp_numerical_type obj = 0;
+                nlp_numerical_type hpwl = 0, ovl = 0, oob = 0, asym = 0, cos = 0, powerWl = 0, crf = 0;
+                nlp_numerical_type hpwlRaw = 0, ovlRaw = 0, oobRaw = 0, asymRaw = 0, cosRaw = 0, powerWlRaw = 0, crfRaw = 0;
+            };
+
+            /// @brief Armijo backtracking along the negative gradient. Starts from twice the last accepted step
+            template<typename nlp_numerical_type, IndexType warm_up_iter = 100>
+            struct armijo_backtracking
+            {
+                static constexpr IndexType warmUpIter = warm_up_iter;
+                static constexpr nlp_numerical_type c1 = 1e-4; ///< sufficient decrease
+                static constexpr nlp_numerical_type shrink = 0.5;
+                static constexpr nlp_numerical_type grow = 2;
+                static constexpr nlp_numerical_type maxStepRatio = 100; ///< with respect to the default step
+                static constexpr IndexType maxBacktrack = 20;
+                nlp_numerical_type _step = -1; ///< The last accepted step. Negative if none
+            };
+
+            template<typename nlp_numerical_type, IndexType warm_up_iter>
+            struct step_size_trait<armijo_backtracking<nlp_numerical_type, warm_up_iter>>
+            {
+                typedef armijo_backtracking<nlp_numerical_type, warm_up_iter> step_size_type;
+                static constexpr bool needObj = true;
+                static void clear(step_size_type &s) { s._step = -1; }
+                template<typename nlp_type>
+                static bool inWarmUp(nlp_type &, step_size_type &, IndexType iter) { return iter <= step_size_type::warmUpIter; }
+                /// @brief need the objective and gradient at the current point. The objective is evaluated at the trial points, and _pl is restored afterwards
+                template<typename nlp_type, typename num_type>
+                static num_type stepSize(nlp_type &n, step_size_type &s, num_type defaultStep)
+                {
+                    const auto pl0 = n._pl;
+                    // The converge criteria and the trace read the objectives of the current point
+                    objective_snapshot<nlp_numerical_type> obj0;
+                    obj0.save(n);
+                    const num_type gradSqr = n._grad.squaredNorm();
+                    num_type step = s._step > 0 ? static_cast<num_type>(s._step * step_size_type::grow) : defaultStep;
+                    step = std::min(step, static_cast<num_type>(step_size_type::maxStepRatio * defaultStep));
+                    for (IndexType iter = 0; iter < step_size_type::maxBacktrack; ++iter)
+                    {
+                        n._pl = pl0 - step * n._grad;
+                        n.calcObj();
+                        if (n._obj <= obj0.obj - step_size_type::c1 * step * gradSqr)
+                        {
+                            break;
+                        }
+                        step *= step_size_type::shrink;
+                    }
+                    n._pl = pl0;
+                    obj0.restore(n);
+                    s._step = step;
+                    return step;
+                }
+                template<typename nlp_type, typename vector_type>
+                static bool restart(nlp_type &, step_size_type &, const vector_type &, const vector_type &) { return false; }
+            };
+
+            /// @brief gradient-based adaptive restart of the momentum on top of another policy.
+            /// @details Restart if the gradient at the extrapolated point makes an acute angle with the last move, i.e. the momentum is pointing uphill
+            template<typename base_step_size_type>
+            struct adaptive_restart
+            {
+                base_step_size_type _base;
+                IndexType _numRestarts = 0;
+            };
+
+            template<typename base_step_size_type>
+            struct step_size_trait<adaptive_restart<base_step_size_type>>
+            {
+                typedef adaptive_restart<base_step_size_type> step_size_type;
+                typedef step_size_trait<base_step_size_type> base_trait;
+                static constexpr bool needObj = base_trait::needObj;
+                static void clear(step_size_type &s)
+                {
+                    base_trait::clear(s._base);
+                    s._numRestarts = 0;
+                }
+                template<typename nlp_type>
+                static bool inWarmUp(nlp_type &n, step_size_type &s, IndexType iter) { return base_trait::inWarmUp(n, s._base, iter); }
+                template<typename nlp_type, typename num_type>
+                static num_type stepSize(nlp_type &n, step_size_type &s, num_type defaultStep) { return base_trait::stepSize(n, s._base, defaultStep); }
+                /// @param the gradient step from the extrapolated point
+                /// @param the last gradient step
+                template<typename nlp_type, typename vector_type>
+                static bool restart(nlp_type &n, step_size_type &s, const vector_type &yCurr, const vector_type &yPrev)
+                {
+                    if (n._grad.dot(yCurr - yPrev) > 0)
+                    {
+                        ++s._numRestarts;
+                        return true;
+                    }
+                    return false;
+                }
+            };
+        } // namespace step_size
+    } // namespace optm
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
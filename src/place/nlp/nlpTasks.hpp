@@ -6,11 +6,13 @@
  */
 
 #pragma once
+#include <Eigen/Sparse>
 #include "global/global.h"
 #ifdef IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ_
 #include <taskflow/taskflow.hpp>
 #endif // IDEAPLACE_TASKFLOR_FOR_GRAD_OBJ
 #include "place/different.h"
+#include "place/differentDensity.hpp"
 
 PROJECT_NAMESPACE_BEGIN
 
@@ -116,80 +118,10 @@ namespace nt
     template<typename op_type, typename eigen_vector_type>
     class CalculateOperatorPartialTask;
 
-    // @brief The tasks for transfer from CalculateOperatorPartialTask to a target matrix
     template<typename nlp_op_type, typename eigen_vector_type>
-    class UpdateGradientFromPartialTask
-    {
-        typedef typename nlp_op_type::numerical_type nlp_numerical_type;
-        typedef typename nlp_op_type::coordinate_type nlp_coordiante_type;
-        typedef eigen_vector_type EigenVector;
-        public:
-            UpdateGradientFromPartialTask() = delete;
-            UpdateGradientFromPartialTask(const UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &other)  = delete;
-            UpdateGradientFromPartialTask(UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &other)  = delete;
-            UpdateGradientFromPartialTask(UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &&other)
-                : _calcTask(std::move(other._calcTask)), _target(std::move(other._target)), _idxFunc(std::move(other._idxFunc))
-            {
-            }
-            UpdateGradientFromPartialTask(std::shared_ptr<CalculateOperatorPartialTask<nlp_op_type, eigen_vector_type>> calcTask, EigenVector *target,
-                    const std::function<IndexType(IndexType, Orient2DType)> &idxFunc) 
-            { 
-                _calcTask = calcTask; 
-                _target = target; 
-                _idxFunc = idxFunc;  
-            }
-            static void run(UpdateGradientFromPartialTask &task)
-            {
-                for (IndexType idx = 0; idx < task._calcTask->numCells(); ++idx)
-                {
-                    IndexType cellIdx = task._calcTask->_inverseCellMap[idx];
-                    (*task._target)(task._idxFunc(cellIdx, Orient2DType::HORIZONTAL)) += task._calcTask->_partialsX(idx);
-                    (*task._target)(task._idxFunc(cellIdx, Orient2DType::VERTICAL)) += task._calcTask->_partialsY(idx);
-                }
-            }
-        private:
-            std::shared_ptr<CalculateOperatorPartialTask<nlp_op_type, eigen_vector_type>> _calcTask;
-            EigenVector *_target;
-            std::function<IndexType(IndexType, Orient2DType)> _idxFunc; //< convert cell idx to eigen vector idx
-    };
+    class GatherGradientFromPartialTask;
 
-#ifdef MULTI_SYM_GROUP
-    template<typename nlp_numerical_type, typename nlp_coordinate_type, typename eigen_vector_type>
-    class UpdateGradientFromPartialTask<diff::AsymmetryDifferentiable<nlp_numerical_type, nlp_coordinate_type>, eigen_vector_type>
-    {
-        typedef diff::AsymmetryDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_op_type;
-        typedef eigen_vector_type EigenVector;
-        public:
-            UpdateGradientFromPartialTask() {}
-            UpdateGradientFromPartialTask(const UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &other)  = delete;
-            UpdateGradientFromPartialTask(UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &other)  = delete;
-            UpdateGradientFromPartialTask(UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type> &&other)
-                : _calcTask(std::move(other._calcTask)), _target(std::move(other._target)), _idxFunc(std::move(other._idxFunc))
-            {
-            }
-            UpdateGradientFromPartialTask(std::shared_ptr<CalculateOperatorPartialTask<nlp_op_type, eigen_vector_type>> calcTask, EigenVector *target,
-                    const std::function<IndexType(IndexType, Orient2DType)> &idxFunc) 
-            { 
-                _calcTask = calcTask; 
-                _target = target; 
-                _idxFunc = idxFunc;  
-            }
-            static void run(UpdateGradientFromPartialTask &task)
-            {
-                for (IndexType idx = 0; idx < task._calcTask->numCells(); ++idx)
-                {
-                    IndexType cellIdx = task._calcTask->_inverseCellMap[idx];
-                    (*task._target)(task._idxFunc(cellIdx, Orient2DType::HORIZONTAL)) = task._calcTask->_partialsX(idx);
-                    (*task._target)(task._idxFunc(cellIdx, Orient2DType::VERTICAL)) = task._calcTask->_partialsY(idx);
-                }
-                (*task._target)(task._idxFunc(task._calcTask->_symGrpIdx, Orient2DType::HORIZONTAL)) = task._calcTask->_partialsX(idx);
-            }
-        private:
-            std::shared_ptr<CalculateOperatorPartialTask<nlp_op_type, eigen_vector_type>> _calcTask;
-            EigenVector *_target;
-            std::function<IndexType(IndexType, Orient2DType)> _idxFunc; //< convert cell idx to eigen vector idx
-    };
-#endif
+    typedef diff::OperatorCellMap OperatorCellMap;
 
     /// @brief trait template for building the _cellMap and _inverseCellMap from the different types opeartor. This template need partial specification.
     /// @tparam the differentiable operator type
@@ -201,6 +133,16 @@ namespace nt
         static void build(op_type *, calc_type *) {}
     };
 
+    /// @brief trait template for zeroing the partials before a calculation. By default all of them.
+    /// Specialize for the operators that can tell which entries they have written
+    /// @tparam the differentiable operator type
+    template<typename op_type>
+    struct calc_operator_partial_clear_trait
+    {
+        template<typename calc_type>
+        static void clear(op_type &, calc_type &calc) { calc.clearAll(); }
+    };
+
 
     template<typename op_type, typename eigen_vector_type>
     class CalculateOperatorPartialTask
@@ -209,9 +151,10 @@ namespace nt
         typedef typename nlp_op_type::numerical_type nlp_numerical_type;
         typedef typename nlp_op_type::coordinate_type nlp_coordiante_type;
         typedef eigen_vector_type EigenVector;
-        friend UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type>;
+        typedef Eigen::Matrix<nlp_numerical_type, Eigen::Dynamic, 1> partial_vector_type; ///< In the precision of the operator, which may differ from the target
+        friend GatherGradientFromPartialTask<nlp_op_type, eigen_vector_type>;
         friend calc_operator_partial_build_cellmap_trait<nlp_op_type>;
-        static constexpr IntType MAX_NUM_CELLS = IDEAPLACE_DEFAULT_MAX_NUM_CELLS;
+        friend calc_operator_partial_clear_trait<nlp_op_type>;
         public:
             CalculateOperatorPartialTask() = delete;
             CalculateOperatorPartialTask(CalculateOperatorPartialTask &other) = delete;
@@ -227,6 +170,7 @@ namespace nt
                 _op = op; 
                 // Use this trait to speficify different number of cells for different operators
                 calc_operator_partial_build_cellmap_trait<nlp_op_type>::build(*op, *this); 
+                _cellMap.build(_inverseCellMap);
                 _partialsX.resize(_inverseCellMap.size());
                 _partialsY.resize(_inverseCellMap.size());
                 clear();
@@ -245,10 +189,15 @@ namespace nt
             }
             void setAccumulateGradFunc()
             {
-                _op->setAccumulateGradFunc([&](nlp_numerical_type num, IndexType cellIdx, Orient2DType orient){ accumatePartial(num, cellIdx, orient);});
+                _op->setAccumulateGradFunc(diff::PartialAccumulator<nlp_numerical_type>(_partialsX.data(), _partialsY.data(), &_cellMap));
             }
             virtual void clear() 
             { 
+                calc_operator_partial_clear_trait<nlp_op_type>::clear(*_op, *this);
+            }
+            /// @brief zero all the partials
+            void clearAll()
+            {
                 for (IndexType idx = 0; idx < numCells(); ++idx)
                 {
                     _partialsX(idx) = 0.0;
@@ -261,11 +210,20 @@ namespace nt
                 task.clear(); 
                 diff::placement_differentiable_traits<nlp_op_type>::accumlateGradient(*(task._op)); 
             }
+            /// @brief calculate the partials and evaluate the operator in the same pass. The value is kept in obj()
+            static void runWithObj(CalculateOperatorPartialTask &task)
+            {
+                task.clear();
+                task._obj = diff::placement_differentiable_traits<nlp_op_type>::evaluateAndAccumulate(*(task._op));
+            }
+            /// @brief the operator value from the last runWithObj
+            nlp_numerical_type obj() const { return _obj; }
         protected:
-            EigenVector _partialsX;
-            EigenVector _partialsY;
+            partial_vector_type _partialsX;
+            partial_vector_type _partialsY;
+            nlp_numerical_type _obj = 0; ///< The operator value from the last runWithObj
             nlp_op_type* _op = nullptr;
-            std::array<IndexType, MAX_NUM_CELLS> _cellMap; ///< From db cell index to this class index
+            OperatorCellMap _cellMap; ///< From db cell index to this class index
             std::vector<IndexType> _inverseCellMap;
             IndexType _numCells;
     };
@@ -277,9 +235,7 @@ namespace nt
     {
         typedef diff::AsymmetryDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_op_type;
         typedef eigen_vector_type EigenVector;
-        friend UpdateGradientFromPartialTask<nlp_op_type, eigen_vector_type>;
         friend calc_operator_partial_build_cellmap_trait<nlp_op_type, eigen_vector_type>;
-        static constexpr IntType MAX_NUM_CELLS = IDEAPLACE_DEFAULT_MAX_NUM_CELLS;
         typedef CalculateOperatorPartialTask<diff::LseHpwlDifferentiable<nlp_numerical_type, nlp_coordinate_type>, eigen_vector_type> base_type;
         public:
             virtual void accumatePartial(nlp_numerical_type num, IndexType cellIdx, Orient2DType orient)
@@ -312,6 +268,88 @@ namespace nt
     };
 #endif
 
+    /// @brief gather the partials of all the CalculateOperatorPartialTask of an operator type into a target vector
+    /// @details A CSR from each target entry to the partials contributing to it is built once.
+    /// The entries are then gathered in parallel, and each entry adds its partials in the order of the operators.
+    /// So there is no write contention, and the result is the same as running the UpdateGradientFromPartialTask one by one
+    template<typename nlp_op_type, typename eigen_vector_type>
+    class GatherGradientFromPartialTask
+    {
+        typedef typename nlp_op_type::numerical_type nlp_numerical_type;
+        typedef eigen_vector_type EigenVector;
+        typedef CalculateOperatorPartialTask<nlp_op_type, eigen_vector_type> calc_task_type;
+        public:
+            GatherGradientFromPartialTask() = delete;
+            GatherGradientFromPartialTask(const GatherGradientFromPartialTask &other) = delete;
+            GatherGradientFromPartialTask(GatherGradientFromPartialTask &&other) = default;
+            /// @param the calculating tasks. The partials need to be kept at the same place
+            /// @param the target vector
+            /// @param convert cell idx to the target vector idx
+            GatherGradientFromPartialTask(std::vector<Task<calc_task_type>> &calcTasks, EigenVector *target,
+                    const std::function<IndexType(IndexType, Orient2DType)> &idxFunc)
+            {
+                _target = target;
+                // Count the partials of each entry, and then fill them in the order of the operators
+                _start.assign(target->size() + 1, 0);
+                for (auto &calc : calcTasks)
+                {
+                    const auto &data = calc.taskData();
+                    for (IndexType idx = 0; idx < data.numCells(); ++idx)
+                    {
+                        IndexType cellIdx = data._inverseCellMap[idx];
+                        ++_start[idxFunc(cellIdx, Orient2DType::HORIZONTAL) + 1];
+                        ++_start[idxFunc(cellIdx, Orient2DType::VERTICAL) + 1];
+                    }
+                }
+                for (IndexType entry = 0; entry < target->size(); ++entry)
+                {
+                    _start[entry + 1] += _start[entry];
+                }
+                _partials.resize(_start.back());
+                std::vector<IndexType> fill(_start.begin(), _start.end() - 1);
+                for (auto &calc : calcTasks)
+                {
+                    const auto &data = calc.taskData();
+                    for (IndexType idx = 0; idx < data.numCells(); ++idx)
+                    {
+                        IndexType cellIdx = data._inverseCellMap[idx];
+                        _partials[fill[idxFunc(cellIdx, Orient2DType::HORIZONTAL)]++] = &data._partialsX(idx);
+                        _partials[fill[idxFunc(cellIdx, Orient2DType::VERTICAL)]++] = &data._partialsY(idx);
+                    }
+                }
+            }
+            static void run(GatherGradientFromPartialTask &task)
+            {
+                #pragma omp parallel
+                {
+                    runShared(task);
+                }
+            }
+            /// @brief the worksharing loop without the implied barrier, for running inside an enclosing parallel region
+            static void runShared(GatherGradientFromPartialTask &task)
+            {
+                const IndexType numEntries = task._start.size() - 1;
+                #pragma omp for schedule(static) nowait
+                for (IndexType entry = 0; entry < numEntries; ++entry)
+                {
+                    if (task._start[entry] == task._start[entry + 1])
+                    {
+                        continue;
+                    }
+                    typename EigenVector::Scalar sum = 0;
+                    for (IndexType idx = task._start[entry]; idx < task._start[entry + 1]; ++idx)
+                    {
+                        sum += *task._partials[idx];
+                    }
+                    (*task._target)(entry) += sum;
+                }
+            }
+        private:
+            std::vector<IndexType> _start; ///< The partials of entry i are _partials[_start[i]] .. _partials[_start[i + 1] - 1]
+            std::vector<const nlp_numerical_type *> _partials; ///< The locations of the partials in the calculating tasks
+            EigenVector *_target = nullptr;
+    };
+
     template<typename nlp_numerical_type, typename nlp_coordinate_type>
     struct calc_operator_partial_build_cellmap_trait<diff::LseHpwlDifferentiable<nlp_numerical_type, nlp_coordinate_type>>
     {
@@ -323,7 +361,6 @@ namespace nt
             calc._inverseCellMap.resize(op._cells.size());
             for (IndexType idx = 0; idx < op._cells.size(); ++idx)
             {
-                calc._cellMap[op._cells[idx]] = idx;
                 calc._inverseCellMap[idx] = op._cells[idx];
             }
         }
@@ -338,13 +375,74 @@ namespace nt
         {
             calc._numCells = 2; // Always have exactly two cells
             calc._inverseCellMap.resize(2);
-            calc._cellMap[op._cellIdxI] = 0;
             calc._inverseCellMap[0] = op._cellIdxI;
-            calc._cellMap[op._cellIdxJ] = 1;
             calc._inverseCellMap[1] = op._cellIdxJ;
         }
     };
 
+    template<typename nlp_numerical_type, typename nlp_coordinate_type>
+    struct calc_operator_partial_build_cellmap_trait<diff::CellPairOverlapNeighborListPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type>>
+    {
+        typedef diff::CellPairOverlapNeighborListPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_op_type;
+        template<typename calc_type>
+        static void build(nlp_op_type &op, calc_type &calc)
+        {
+            // The pairs change with the neighbor list. Cover all the cells in the list, in its order, so that the operator accumulates by its local indices
+            calc._numCells = op._neighborList->numCells();
+            calc._inverseCellMap.resize(calc._numCells);
+            for (IndexType idx = 0; idx < calc._numCells; ++idx)
+            {
+                calc._inverseCellMap[idx] = op._neighborList->cellIdx(idx);
+            }
+        }
+    };
+
+    /// @brief zero only the cells of the pairs in the slice of the operator. They are the only entries written while the pairs stay the same.
+    /// After a rebuild of the neighbor list the entries of the old pairs are unknown, so all of them are zeroed once
+    template<typename nlp_numerical_type, typename nlp_coordinate_type>
+    struct calc_operator_partial_clear_trait<diff::CellPairOverlapNeighborListPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type>>
+    {
+        typedef diff::CellPairOverlapNeighborListPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_op_type;
+        template<typename calc_type>
+        static void clear(nlp_op_type &op, calc_type &calc)
+        {
+            const auto &nbl = *op._neighborList;
+            if (op._numRebuildsCleared != nbl.numRebuilds())
+            {
+                calc.clearAll();
+                op._numRebuildsCleared = nbl.numRebuilds();
+                return;
+            }
+            const auto &pairs = nbl.pairs();
+            for (IndexType pairIdx = op._sliceIdx; pairIdx < pairs.size(); pairIdx += op._numSlices)
+            {
+                calc._partialsX(pairs[pairIdx].first) = 0.0;
+                calc._partialsY(pairs[pairIdx].first) = 0.0;
+                calc._partialsX(pairs[pairIdx].second) = 0.0;
+                calc._partialsY(pairs[pairIdx].second) = 0.0;
+            }
+        }
+    };
+
+    template<typename nlp_numerical_type, typename nlp_coordinate_type>
+    struct calc_operator_partial_build_cellmap_trait<diff::ElectrostaticDensityPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type>>
+    {
+        typedef diff::ElectrostaticDensityPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type> nlp_op_type;
+        template<typename calc_type>
+        static void build(nlp_op_type &op, calc_type &calc)
+        {
+            // Only the slice of cells is touched by an operator
+            const auto &densityMap = *op._densityMap;
+            calc._numCells = 0;
+            calc._inverseCellMap.clear();
+            for (IndexType idx = op._sliceIdx; idx < densityMap.numCells(); idx += op._numSlices)
+            {
+                calc._inverseCellMap.emplace_back(densityMap.cellIdx(idx));
+                ++calc._numCells;
+            }
+        }
+    };
+
     template<typename nlp_numerical_type, typename nlp_coordinate_type>
     struct calc_operator_partial_build_cellmap_trait<diff::CellOutOfBoundaryPenaltyDifferentiable<nlp_numerical_type, nlp_coordinate_type>>
     {
@@ -354,7 +452,6 @@ namespace nt
         {
             calc._numCells = 1; // Always have exactly two cells
             calc._inverseCellMap.resize(1);
-            calc._cellMap[op._cellIdx] = 0;
             calc._inverseCellMap[0] = op._cellIdx;
         }
     };
@@ -372,16 +469,13 @@ namespace nt
             IndexType idx = 0;
             for (IndexType pairIdx = 0; pairIdx < op._pairCells.size(); ++pairIdx)
             {
-                calc._cellMap[op._pairCells[pairIdx][0]] = idx;
                 calc._inverseCellMap[idx] = op._pairCells[pairIdx][0];
                 ++idx;
-                calc._cellMap[op._pairCells[pairIdx][1]] = idx;
                 calc._inverseCellMap[idx] = op._pairCells[pairIdx][1];
                 ++idx;
             }
             for (IndexType ssIdx = 0; ssIdx < op._selfSymCells.size(); ++ssIdx)
             {
-                calc._cellMap[op._selfSymCells[ssIdx]] = idx;
                 calc._inverseCellMap[idx] = op._selfSymCells[ssIdx];
                 ++idx;
             }
@@ -400,11 +494,8 @@ namespace nt
         {
             calc._numCells = 3; // Always have exactly two cells
             calc._inverseCellMap.resize(3);
-            calc._cellMap[op._sCellIdx] = 0;
             calc._inverseCellMap[0] = op._sCellIdx;
-            calc._cellMap[op._midCellIdx] = 1;
             calc._inverseCellMap[1] = op._midCellIdx;
-            calc._cellMap[op._tCellIdx] = 2;
             calc._inverseCellMap[2] = op._tCellIdx;
         }
     };
@@ -420,7 +511,6 @@ namespace nt
             calc._inverseCellMap.resize(op._cells.size());
             for (IndexType idx = 0; idx < op._cells.size(); ++idx)
             {
-                calc._cellMap[op._cells[idx]] = idx;
                 calc._inverseCellMap[idx] = op._cells[idx];
             }
         }
@@ -435,9 +525,7 @@ namespace nt
         {
             calc._numCells = 2; // Always have exactly two cells
             calc._inverseCellMap.resize(2);
-            calc._cellMap[op._sCellIdx] = 0;
             calc._inverseCellMap[0] = op._sCellIdx;
-            calc._cellMap[op._tCellIdx] = 1;
             calc._inverseCellMap[1] = op._tCellIdx;
         }
     };
@@ -450,6 +538,10 @@ namespace nt
 namespace nt
 {
 
+    /// @brief The tasks for calculating the hessian of an operator and adding it to a target matrix
+    /// @details Only the nonzero entries emitted by the hessian trait are kept.
+    /// If the target is a vector, the hessian is diagonal and the diagonal is kept in the local indices.
+    /// Otherwise the entries are kept as triplets in the target indices, to be added to a dense target, or to a sparse one with setFromTriplets
     template<typename op_type, typename hessian_type, typename Matrix, typename TargetMatrix>
     class CalculateOperatorHessianTask
     {
@@ -457,15 +549,18 @@ namespace nt
         typedef typename nlp_op_type::numerical_type nlp_numerical_type;
         typedef typename nlp_op_type::coordinate_type nlp_coordiante_type;
         friend calc_operator_partial_build_cellmap_trait<nlp_op_type>;
-        static constexpr IntType MAX_NUM_CELLS = IDEAPLACE_DEFAULT_MAX_NUM_CELLS;
         public:
+            typedef Eigen::Triplet<nlp_numerical_type> triplet_type;
+            static constexpr bool isDiagonal = TargetMatrix::ColsAtCompileTime == 1;
+            typedef std::conditional_t<isDiagonal, TargetMatrix, std::vector<triplet_type>> local_hessian_type;
+
             CalculateOperatorHessianTask() = delete;
             CalculateOperatorHessianTask(CalculateOperatorHessianTask &other) = delete;
             CalculateOperatorHessianTask(CalculateOperatorHessianTask &&other)
                 : _hessian(std::move(other._hessian)), 
                 _cellMap(std::move(other._cellMap)), _inverseCellMap(std::move(other._inverseCellMap)),
                 _numCells(std::move(other._numCells)),
-                _target(std::move(other._target)), _idxFunc(std::move(other._idxFunc))
+                _target(std::move(other._target)), _targetIdx(std::move(other._targetIdx))
             {
                 createAccumulateFunc();
                 _op = other._op;
@@ -475,10 +570,19 @@ namespace nt
                 _op = op; 
                 // Use this trait to speficify different number of cells for different operators
                 calc_operator_partial_build_cellmap_trait<nlp_op_type>::build(*op, *this); 
-                _hessian.resize(2 * _numCells, 2 * _numCells);
-
+                _cellMap.build(_inverseCellMap);
+                if constexpr (isDiagonal)
+                {
+                    _hessian.resize(2 * _numCells);
+                }
                 _target = target;
-                _idxFunc = idxFunc;
+                // Convert the indices once here instead of for every entry
+                _targetIdx.resize(2 * _numCells);
+                for (IndexType idx = 0; idx < _numCells; ++idx)
+                {
+                    _targetIdx[idx] = idxFunc(_inverseCellMap[idx], Orient2DType::HORIZONTAL);
+                    _targetIdx[idx + _numCells] = idxFunc(_inverseCellMap[idx], Orient2DType::VERTICAL);
+                }
                 clear();
                 createAccumulateFunc();
             }
@@ -501,11 +605,26 @@ namespace nt
                 {
                     j += _numCells;
                 }
-                _hessian(i, j) += num;
+                if constexpr (isDiagonal)
+                {
+                    AssertMsg(i == j, "CalculateOperatorHessianTask: off-diagonal entry for a diagonal hessian \n");
+                    _hessian(i) += num;
+                }
+                else
+                {
+                    _hessian.emplace_back(_targetIdx[i], _targetIdx[j], num);
+                }
             }
             virtual void clear() 
             { 
-                _hessian.setZero();
+                if constexpr (isDiagonal)
+                {
+                    _hessian.setZero();
+                }
+                else
+                {
+                    _hessian.clear();
+                }
             }
             IndexType numCells() const { return _numCells; }
             void calc() 
@@ -513,48 +632,38 @@ namespace nt
                 clear(); 
                 hessian_type::accumulateHessian(*_op, _accumulateFunc);
             }
+            /// @brief add the hessian to the target. For a sparse target, collecting the triplets() of all the tasks into one setFromTriplets is cheaper
             void update()
             {
-                for (IndexType i = 0; i < _numCells * 2; ++i)
+                if constexpr (isDiagonal)
                 {
-                    Orient2DType iOrient;
-                    IndexType iCellIdx;
-                    if (i < _numCells)
-                    {
-                        iOrient = Orient2DType::HORIZONTAL;
-                        iCellIdx = _inverseCellMap[i];
-                    }
-                    else
+                    for (IndexType i = 0; i < 2 * _numCells; ++i)
                     {
-                        iOrient = Orient2DType::VERTICAL;
-                        iCellIdx = _inverseCellMap[i - _numCells];
+                        (*_target)(_targetIdx[i]) += _hessian(i);
                     }
-                    for (IndexType j = 0; j < _numCells * 2; ++j)
+                }
+                else
+                {
+                    for (const auto &triplet : _hessian)
                     {
-                        Orient2DType jOrient;
-                        IndexType jCellIdx;
-                        if (j < _numCells)
-                        {
-                            jOrient = Orient2DType::HORIZONTAL;
-                            jCellIdx = _inverseCellMap[j];
-                        }
-                        else
-                        {
-                            jOrient = Orient2DType::VERTICAL;
-                            jCellIdx = _inverseCellMap[j - _numCells];
-                        }
-                        (*_target)(_idxFunc(iCellIdx, iOrient), _idxFunc(jCellIdx, jOrient)) += _hessian(i, j);
+                        _target->coeffRef(triplet.row(), triplet.col()) += triplet.value();
                     }
                 }
             }
+            /// @brief the nonzero entries in the target indices. Only for non-diagonal targets
+            const std::vector<triplet_type> & triplets() const 
+            { 
+                static_assert(not isDiagonal, "CalculateOperatorHessianTask: triplets() is only for non-diagonal targets");
+                return _hessian;
+            }
         protected:
-            Matrix _hessian;
+            local_hessian_type _hessian; ///< The diagonal in the local indices if isDiagonal. Otherwise the nonzero entries in the target indices
             nlp_op_type* _op = nullptr;
-            std::array<IndexType, MAX_NUM_CELLS> _cellMap; ///< From db cell index to this class index
+            OperatorCellMap _cellMap; ///< From db cell index to this class index
             std::vector<IndexType> _inverseCellMap;
             IndexType _numCells;
             TargetMatrix *_target;
-            std::function<IndexType(IndexType, Orient2DType)> _idxFunc; //< convert cell idx to eigen vector idx
+            std::vector<IndexType> _targetIdx; ///< The target indices of the local indices. x of local cell i at [i], y at [i + _numCells]
             std::function<void(nlp_numerical_type, IndexType, IndexType, Orient2DType, Orient2DType)> _accumulateFunc;
     };
 } // namespace nt
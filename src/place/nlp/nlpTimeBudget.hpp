@@ -0,0 +1,122 @@
+/**
+ * @file nlpTimeBudget.hpp
+ * @brief The wall-clock budget of a global placement run
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include "global/global.h"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    /// @brief limits the inner and outer iterations of a global placement run by its wall-clock budget.
+    /// @details The cost of an inner iteration and the overhead of an outer iteration are measured as the run goes.
+    /// An outer iteration gets a share of the remaining time, so that the multipliers are still updated several times.
+    /// Its inner iterations are capped by that share over the measured cost. The outer loop stops once there is no time for a minimal outer iteration.
+    /// Disabled if the budget is not positive
+    class TimeBudget
+    {
+        public:
+            typedef std::chrono::steady_clock clock_type;
+            static constexpr RealType outerIterShare = 0.5; ///< The share of the remaining time given to an outer iteration. The first one from the initial placement usually takes most of the time
+            static constexpr IntType minInnerIters = 20; ///< An outer iteration with fewer inner iterations is not worth it
+
+            /// @brief start counting
+            /// @param the budget in millisecond. Not positive to disable
+            void start(RealType budgetMs)
+            {
+                _budgetMs = budgetMs;
+                _begin = clock_type::now();
+                _numInnerIters = 0;
+                _innerMs = 0;
+                _numOuterIters = 0;
+                _outerMs = 0;
+                _innerIterCap = -1;
+            }
+            bool enabled() const { return _budgetMs > 0; }
+            RealType elapsedMs() const { return msSince(_begin); }
+            RealType remainingMs() const { return _budgetMs - elapsedMs(); }
+            bool expired() const { return enabled() and remainingMs() <= 0; }
+            /// @brief the measured wall-clock time of an inner iteration. Negative if not measured yet
+            RealType innerIterMs() const { return _numInnerIters > 0 ? _innerMs / _numInnerIters : -1; }
+            /// @brief the measured overhead of an outer iteration besides its inner iterations. Zero if not measured yet
+            RealType outerOverheadMs() const { return _numOuterIters > 0 ? std::max(_outerMs - _innerMs, 0.0) / _numOuterIters : 0; }
+            /// @brief the cap of the inner iterations of the current outer iteration. Negative if capped by time directly
+            IntType innerIterCap() const { return _innerIterCap; }
+            /// @brief start an outer iteration. Decide its share of the remaining time and the cap of its inner iterations
+            void beginOuterIter()
+            {
+                if (not enabled())
+                {
+                    return;
+                }
+                _outerBegin = clock_type::now();
+                _lastInnerCheck = _outerBegin;
+                _outerSliceMs = outerIterShare * remainingMs();
+                const RealType iterMs = innerIterMs();
+                _innerIterCap = iterMs > 0 ? std::max(static_cast<IntType>(_outerSliceMs / iterMs), minInnerIters) : -1;
+                _curInnerIter = 0;
+            }
+            /// @brief check after an inner iteration
+            /// @return whether to stop the inner iterations
+            bool stopInner()
+            {
+                if (not enabled())
+                {
+                    return false;
+                }
+                const auto now = clock_type::now();
+                _innerMs += std::chrono::duration<RealType, std::milli>(now - _lastInnerCheck).count();
+                _lastInnerCheck = now;
+                ++_numInnerIters;
+                ++_curInnerIter;
+                if (expired())
+                {
+                    return true;
+                }
+                if (_innerIterCap < 0)
+                {
+                    // The first outer iteration. No measurement yet
+                    return msSince(_outerBegin) >= _outerSliceMs;
+                }
+                return _curInnerIter >= _innerIterCap;
+            }
+            /// @brief end an outer iteration
+            /// @return whether there is not enough time for another minimal outer iteration
+            bool endOuterIter()
+            {
+                if (not enabled())
+                {
+                    return false;
+                }
+                _outerMs += msSince(_outerBegin);
+                ++_numOuterIters;
+                return remainingMs() < minInnerIters * std::max(innerIterMs(), 0.0) + outerOverheadMs();
+            }
+        private:
+            static RealType msSince(clock_type::time_point tp)
+            {
+                return std::chrono::duration<RealType, std::milli>(clock_type::now() - tp).count();
+            }
+        private:
+            RealType _budgetMs = 0; ///< The budget. Not positive if disabled
+            clock_type::time_point _begin; ///< When the run starts
+            clock_type::time_point _outerBegin; ///< When the current outer iteration starts
+            clock_type::time_point _lastInnerCheck; ///< When the last inner iteration ends
+            RealType _outerSliceMs = 0; ///< The time given to the current outer iteration
+            IntType _innerIterCap = -1; ///< The cap of the inner iterations of the current outer iteration
+            IntType _curInnerIter = 0; ///< The number of inner iterations of the current outer iteration
+            IntType _numInnerIters = 0; ///< The number of inner iterations so far
+            RealType _innerMs = 0; ///< The time of the inner iterations so far
+            IntType _numOuterIters = 0; ///< The number of finished outer iterations
+            RealType _outerMs = 0; ///< The time of the finished outer iterations
+    };
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
@@ -0,0 +1,233 @@
+/**
+ * @file nlpTrace.hpp
+ * @brief Recording the convergence of the global placement into a ring buffer
+ * @author agent
+ * @date 10/16/2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "global/global.h"
+#include "nlpOuterOptm.hpp"
+
+PROJECT_NAMESPACE_BEGIN
+
+namespace nlp
+{
+    /// @brief the trace of the optimization.
+    /// @details The records are kept in a ring buffer allocated before the run, so recording is a copy of a few numbers.
+    /// If the run is longer than the buffer, the latest records are kept. The buffer is written out at the end of the run
+    namespace trace
+    {
+        constexpr char magic[4] = { 'I', 'P', 'T', 'R' };
+        constexpr IndexType version = 2;
+        constexpr IndexType maxNumMults = 8;
+        constexpr IndexType maxNumAlphas = 4;
+
+        /// @brief one record. The inner records are after each inner iteration. The outer records are after the multipliers and alpha are updated.
+        /// The kernels may not evaluate the objectives every iteration, e.g. adam only calculates the gradient.
+        /// The objectives are recorded only if they have been evaluated since the last record. They are NaN otherwise
+        struct Record
+        {
+            std::uint32_t outerIter = 0;
+            std::uint32_t innerIter = 0; ///< The number of inner iterations in the outer iteration
+            std::uint32_t isOuter = 0;
+            std::uint32_t objFresh = 0; ///< Whether the objectives have been evaluated since the last record
+            RealType obj = 0;
+            RealType objHpwl = 0;
+            RealType objOvl = 0;
+            RealType objOob = 0;
+            RealType objAsym = 0;
+            RealType objCos = 0;
+            RealType objPowerWl = 0;
+            RealType objCrf = 0;
+            RealType gradNorm = 0;
+            std::array<RealType, maxNumMults> mults = {}; ///< The multipliers in the outer records
+            std::array<RealType, maxNumAlphas> alphas = {}; ///< The alpha in the outer records
+        };
+
+        /// @brief how the multipliers and alpha are written into a record
+        template<typename T>
+        struct trace_trait
+        {
+            // static void record(const T &, Record &)
+        };
+
+        template<typename nlp_numerical_type, typename init_type, typename update_type>
+        struct trace_trait<outer_multiplier::mult_const_hpwl_cos_and_penalty_by_type<nlp_numerical_type, init_type, update_type>>
+        {
+            typedef outer_multiplier::mult_const_hpwl_cos_and_penalty_by_type<nlp_numerical_type, init_type, update_type> mult_type;
+            /// @brief the constant multipliers followed by the varied ones
+            static void record(const mult_type &mult, Record &rec)
+            {
+                IndexType idx = 0;
+                for (IndexType i = 0; i < mult._constMults.size() and idx < maxNumMults; ++i)
+                {
+                    rec.mults[idx++] = mult._constMults[i];
+                }
+                for (IndexType i = 0; i < mult._variedMults.size() and idx < maxNumMults; ++i)
+                {
+                    rec.mults[idx++] = mult._variedMults[i];
+                }
+            }
+        };
+
+        template<typename nlp_numerical_type>
+        struct trace_trait<alpha::alpha_hpwl_ovl_oob<nlp_numerical_type>>
+        {
+            typedef alpha::alpha_hpwl_ovl_oob<nlp_numerical_type> alpha_type;
+            static void record(const alpha_type &alpha, Record &rec)
+            {
+                for (IndexType i = 0; i < alpha._alpha.size() and i < maxNumAlphas; ++i)
+                {
+                    rec.alphas[i] = alpha._alpha[i];
+                }
+            }
+        };
+
+        /// @brief the ring buffer of the records. Disabled until started with a file
+        class TraceRecorder
+        {
+            public:
+                /// @brief allocate the buffer
+                /// @param the file to write at the end. Empty to disable. Written as CSV if it ends with .csv, binary otherwise
+                /// @param the number of records to keep
+                void start(const std::string &filename, IndexType capacity)
+                {
+                    _filename = filename;
+                    _records.clear();
+                    _numRecorded = 0;
+                    _outerIter = 0;
+                    _innerIter = 0;
+                    _numObjEvalsRecorded = 0;
+                    if (enabled())
+                    {
+                        _records.resize(std::max(capacity, static_cast<IndexType>(1)));
+                    }
+                }
+                bool enabled() const { return not _filename.empty(); }
+                /// @brief record after an inner iteration
+                template<typename nlp_type>
+                void recordInner(const nlp_type &n)
+                {
+                    if (not enabled())
+                    {
+                        return;
+                    }
+                    ++_innerIter;
+                    Record &rec = next();
+                    fill(n, rec, _numObjEvalsRecorded);
+                    rec.gradNorm = n._grad.norm();
+                }
+                /// @brief record after an outer iteration. The gradient norm is of the last inner iteration
+                template<typename nlp_type, typename mult_type, typename alpha_type>
+                void recordOuter(const nlp_type &n, const mult_type &mult, const alpha_type &alpha)
+                {
+                    if (not enabled())
+                    {
+                        return;
+                    }
+                    Record &rec = next();
+                    fill(n, rec, _numObjEvalsRecorded);
+                    rec.isOuter = 1;
+                    rec.gradNorm = n._grad.norm();
+                    trace_trait<mult_type>::record(mult, rec);
+                    trace_trait<alpha_type>::record(alpha, rec);
+                    ++_outerIter;
+                    _innerIter = 0;
+                }
+                /// @brief write the records from the oldest to the latest
+                /// @return whether the file is written successfully
+                bool flush() const
+                {
+                    if (not enabled())
+                    {
+                        return true;
+                    }
+                    const IndexType numKept = std::min(_numRecorded, static_cast<std::uint64_t>(_records.size()));
+                    const IndexType first = _numRecorded > _records.size() ? _numRecorded % _records.size() : 0;
+                    const bool csv = _filename.size() >= 4 and _filename.compare(_filename.size() - 4, 4, ".csv") == 0;
+                    std::ofstream os(_filename, csv ? std::ios::out : std::ios::binary);
+                    if (csv)
+                    {
+                        os << "outer,inner,isOuter,objFresh,obj,hpwl,ovl,oob,asym,cos,powerWl,crf,gradNorm";
+                        for (IndexType i = 0; i < maxNumMults; ++i) { os << ",mult" << i; }
+                        for (IndexType i = 0; i < maxNumAlphas; ++i) { os << ",alpha" << i; }
+                        os << "\n";
+                        for (IndexType idx = 0; idx < numKept; ++idx)
+                        {
+                            const Record &rec = _records[(first + idx) % _records.size()];
+                            os << rec.outerIter << "," << rec.innerIter << "," << rec.isOuter << "," << rec.objFresh << "," << rec.obj
+                               << "," << rec.objHpwl << "," << rec.objOvl << "," << rec.objOob << "," << rec.objAsym
+                               << "," << rec.objCos << "," << rec.objPowerWl << "," << rec.objCrf << "," << rec.gradNorm;
+                            for (RealType mult : rec.mults) { os << "," << mult; }
+                            for (RealType alpha : rec.alphas) { os << "," << alpha; }
+                            os << "\n";
+                        }
+                    }
+                    else
+                    {
+                        // Header: magic, version, the size of a record, the number of records. Then the records
+                        const IndexType recordSize = sizeof(Record);
+                        os.write(magic, 4);
+                        os.write(reinterpret_cast<const char *>(&version), sizeof(IndexType));
+                        os.write(reinterpret_cast<const char *>(&recordSize), sizeof(IndexType));
+                        os.write(reinterpret_cast<const char *>(&numKept), sizeof(IndexType));
+                        for (IndexType idx = 0; idx < numKept; ++idx)
+                        {
+                            os.write(reinterpret_cast<const char *>(&_records[(first + idx) % _records.size()]), recordSize);
+                        }
+                    }
+                    return os.good();
+                }
+                const std::string & filename() const { return _filename; }
+            private:
+                Record & next()
+                {
+                    Record &rec = _records[_numRecorded % _records.size()];
+                    ++_numRecorded;
+                    rec = Record();
+                    rec.outerIter = _outerIter;
+                    rec.innerIter = _innerIter;
+                    return rec;
+                }
+                /// @param the number of objective evaluations at the last record. Updated to the current number
+                template<typename nlp_type>
+                static void fill(const nlp_type &n, Record &rec, std::uint64_t &numObjEvalsRecorded)
+                {
+                    if (n._numObjEvals == numObjEvalsRecorded)
+                    {
+                        const RealType stale = std::numeric_limits<RealType>::quiet_NaN();
+                        rec.obj = rec.objHpwl = rec.objOvl = rec.objOob = rec.objAsym = rec.objCos = rec.objPowerWl = rec.objCrf = stale;
+                        return;
+                    }
+                    numObjEvalsRecorded = n._numObjEvals;
+                    rec.objFresh = 1;
+                    rec.obj = n._obj;
+                    rec.objHpwl = n._objHpwl;
+                    rec.objOvl = n._objOvl;
+                    rec.objOob = n._objOob;
+                    rec.objAsym = n._objAsym;
+                    rec.objCos = n._objCos;
+                    rec.objPowerWl = n._objPowerWl;
+                    rec.objCrf = n._objCrf;
+                }
+            private:
+                std::string _filename; ///< Empty if disabled
+                std::vector<Record> _records; ///< The ring buffer
+                std::uint64_t _numRecorded = 0; ///< The number of records so far, including the overwritten ones
+                std::uint32_t _outerIter = 0;
+                std::uint32_t _innerIter = 0;
+                std::uint64_t _numObjEvalsRecorded = 0; ///< The number of objective evaluations of the placer at the last record
+        };
+    } // namespace trace
+} // namespace nlp
+
+PROJECT_NAMESPACE_END
@@ -7,7 +7,7 @@
 
 PROJECT_NAMESPACE_BEGIN
 
-std::time_t MsgPrinter::_startTime = std::time(nullptr);
+std::atomic<std::time_t> MsgPrinter::_startTime(std::time(nullptr));
 FILE* MsgPrinter::_screenOutStream = stderr;
 FILE* MsgPrinter::_logOutStream = nullptr;
 std::string MsgPrinter::_logFileName = "";
@@ -101,15 +101,15 @@ void MsgPrinter::print(MsgType msgType, const char* rawFormat, va_list args)
     /// Get the message type
     std::string type = "[" + msgTypeToStr(msgType);
 
-    /// Get local time and elapsed time
-    struct tm* timeInfo;
+    /// Get local time and elapsed time. The reentrant localtime, since the placers may print concurrently
+    struct tm timeInfo;
     std::time_t now = std::time(nullptr);
-    timeInfo = localtime(&now);
-    double elapsed = difftime(now, _startTime);
+    localtime_r(&now, &timeInfo);
+    double elapsed = difftime(now, _startTime.load());
 
     /// Local time
     char locTime[32];
-    strftime(locTime, 32, " %F %T ", timeInfo);
+    strftime(locTime, 32, " %F %T ", &timeInfo);
 
     /// Elapsed time
     char elpTime[32];
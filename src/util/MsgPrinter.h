@@ -13,6 +13,7 @@
 #include <cstdio> // FILE *, stderr
 #include <string>
 #include <ctime>
+#include <atomic>
 #include <cstdarg>
 #include "global/namespace.h"
 
@@ -40,7 +41,7 @@ std::string msgTypeToStr(MsgType msgType);
 class MsgPrinter 
 {
     public:
-        static void startTimer() { _startTime = std::time(nullptr); } // Cache start time
+        static void startTimer() { _startTime.store(std::time(nullptr)); } // Cache start time. Thread-safe, the concurrent placers share the latest start
         static void screenOn()   { _screenOutStream = stderr; }       // Turn on screen printing
         static void screenOff()  { _screenOutStream = nullptr; }      // Turn off screen printing
 
@@ -55,7 +56,7 @@ class MsgPrinter
         static void print(MsgType msgType, const char *rawFormat, va_list args);
 
     private:
-        static std::time_t   _startTime;
+        static std::atomic<std::time_t> _startTime;
         static FILE *        _screenOutStream;  // Out stream for screen printing
         static FILE *        _logOutStream;     // Out stream for log printing
         static std::string   _logFileName;      // Current log file name
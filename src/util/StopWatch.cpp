@@ -2,15 +2,21 @@
 
 namespace klib
 {
+    std::mutex StopWatchMgr::_mutex;
     std::vector<std::uint64_t> StopWatchMgr::_us = std::vector<std::uint64_t>(1, 0);
     std::unordered_map<std::string, std::uint32_t> StopWatchMgr::_nameToIdxMap;
     StopWatch StopWatchMgr::_watch = StopWatch(0); 
 
     std::unique_ptr<StopWatch> StopWatchMgr::createNewStopWatch(std::string &&name) 
     {
-        auto idx = _us.size();
-        _us.emplace_back(0);
-        _nameToIdxMap[std::move(name)] = idx;
+        std::uint32_t idx = 0;
+        {
+            // Not held while constructing the watch, which records its time on destruction
+            std::lock_guard<std::mutex> lock(_mutex);
+            idx = _us.size();
+            _us.emplace_back(0);
+            _nameToIdxMap[std::move(name)] = idx;
+        }
         return std::make_unique<StopWatch>(StopWatch(idx));
     }
     void StopWatchMgr::quickStart()
@@ -14,25 +14,35 @@
 #include <memory>
 #include <iostream>
 #include <cassert>
+#include <mutex>
 
 namespace klib
 {
     class StopWatch;
-    /// @brief class for maintain the global stop watch
+    /// @brief class for maintain the global stop watch. Thread-safe, so that several placers can run concurrently
     class StopWatchMgr
     {
         public:
             static std::unique_ptr<StopWatch> createNewStopWatch(std::string &&name);
             static void recordTime(std::uint64_t time, std::uint32_t idx)
             {
+                std::lock_guard<std::mutex> lock(_mutex);
                 _us[idx] = time;
             }
+            /// @brief the time recorded by the last watch of a name. A watch of the name must have been created
             static std::uint64_t time(std::string &&name)
             {
+                std::lock_guard<std::mutex> lock(_mutex);
                 auto iter = _nameToIdxMap.find(std::move(name));
                 assert(iter != _nameToIdxMap.end());
                 return _us[iter->second];
             }
+            /// @brief whether a watch of a name has been created
+            static bool hasWatch(const std::string &name)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                return _nameToIdxMap.find(name) != _nameToIdxMap.end();
+            }
             /// @brief start the default timer. The time will return on the end, and won't be recorded
             static void quickStart();
             /// @brief end the default timer.
@@ -43,6 +53,7 @@ namespace klib
             static std::vector<std::uint64_t> _us; // The record of the stop watch times
             static std::unordered_map<std::string, std::uint32_t> _nameToIdxMap; ///< Map timer names to indices
             static StopWatch _watch; ///< The default one for quick usage that don't need to record
+            static std::mutex _mutex; ///< Guard _us and _nameToIdxMap
     };
     /// @brief the single stop watch
     class StopWatch
@@ -8,6 +8,7 @@
 #ifndef KLIB_LINEAR_PROGRAMMING_H_
 #define KLIB_LINEAR_PROGRAMMING_H_
 
+#include <mutex>
 #include "global/namespace.h"
 #include "lp_limbo.h"
 
@@ -68,6 +69,13 @@ namespace lp
 {
     typedef typename _lp::select_lp<0, _lp::lp_rank<0>::if_enable>::LpModel LpModel;
     typedef typename _lp::select_lp<0, _lp::lp_rank<0>::if_enable>::LpTrait LpTrait;
+    /// @brief the backends keep global states and are not thread-safe. Hold it from building a model until the model is destroyed,
+    /// so that the placers running concurrently take turns in their LP phases
+    inline std::mutex & lpMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
 };
 
 } //namespace klib